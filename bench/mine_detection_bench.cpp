@@ -0,0 +1,486 @@
+//Micro-benchmarks of the core algorithms of the nodes.
+//Run with: rosrun mine_detection mine_detection_bench
+//what they time is checked for correctness by the tests in test/, run with: catkin_make run_tests_mine_detection
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include <obstacle.h>
+#include <points_gen.h>
+#include <quaternion.h>
+#include <camera_model.h>
+#include <paper_vision.h>
+#include <colour_lut.h>
+#include <bit_mask.h>
+#include <lane_order.h>
+#include <path_plan.h>
+#include <strip_detection.h>
+#include <thread_pool.h>
+#include <depth_scan.h>
+
+using namespace Obstacle_avoidance;
+
+//points on a quarter circle arc, like a laser scan of a round obstacle.
+static std::vector<Obstacle_Point> arcPoints(int count)
+{
+    std::vector<Obstacle_Point> points;
+    for (int i = 0; i < count; i++)
+    {
+        double angle = M_PI_4 + M_PI_2 * i / (count - 1);
+        Obstacle_Point p = {1.0 + 0.15 * cos(angle), 0.15 * sin(angle)};
+        points.push_back(p);
+    }
+    return points;
+}
+
+//synthetic camera frame: grey ground with red paper sheets and some red noise pixels.
+static cv::Mat syntheticFrame(int width, int height)
+{
+    cv::Mat frame(height, width, CV_8UC3, cv::Scalar(90, 100, 110));
+    cv::RNG rng(42);
+    for (int i = 0; i < 6; i++)
+    {
+        cv::Point tl(rng.uniform(0, width - 80), rng.uniform(0, height - 60));
+        cv::rectangle(frame, tl, tl + cv::Point(rng.uniform(30, 80), rng.uniform(20, 60)), cv::Scalar(20, 20, 230), -1);
+    }
+    for (int i = 0; i < width * height / 500; i++)
+    {
+        frame.at<cv::Vec3b>(rng.uniform(0, height), rng.uniform(0, width)) = cv::Vec3b(10, 10, 240);
+    }
+    return frame;
+}
+
+static const Paper_vision::Hsv_range paperRange = {0, 179, 170, 255, 150, 255};
+
+static void BM_getCenterOfCircle(benchmark::State &state)
+{
+    std::vector<Obstacle_Point> points = arcPoints(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getCenterOfCircle(&points));
+    }
+}
+BENCHMARK(BM_getCenterOfCircle)->Arg(16)->Arg(256);
+
+static void BM_obstacleRadius(benchmark::State &state)
+{
+    Obstacle_Point center = {1.0, 0.0};
+    Obstacle_Point edge = {1.1, 0.1};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(center);
+        benchmark::DoNotOptimize(obstacleRadius(center, edge));
+    }
+}
+BENCHMARK(BM_obstacleRadius);
+
+static void BM_convertCoordinatesOfPoint(benchmark::State &state)
+{
+    Camera_model::point pixel = {320, 240};
+    turtlesim::Pose pose;
+    pose.x = 1.2;
+    pose.y = 0.8;
+    pose.theta = 0.3;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(pixel);
+        benchmark::DoNotOptimize(Camera_model::convertCoordinatesOfPoint(pixel, pose));
+    }
+}
+BENCHMARK(BM_convertCoordinatesOfPoint);
+
+static void BM_ToEulerAngles(benchmark::State &state)
+{
+    Quaternion q = {0.0, 0.0, sin(0.4), cos(0.4)};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(q);
+        benchmark::DoNotOptimize(ToEulerAngles(q));
+    }
+}
+BENCHMARK(BM_ToEulerAngles);
+
+//square fields with the given side length in meters.
+static void BM_gen_Point_list(benchmark::State &state)
+{
+    Points_gen::points_List points_instance;
+    double side = state.range(0);
+    for (auto _ : state)
+    {
+        std::vector<Points_gen::Point> vec = points_instance.gen_Point_list(side, side);
+        benchmark::DoNotOptimize(vec.data());
+    }
+}
+BENCHMARK(BM_gen_Point_list)->Arg(3)->Arg(10)->Arg(30)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+//check every point of the demo path against an obstacle in the middle of the field,
+//and offset the points inside it, like the planner does.
+static void BM_patchPathAroundObstacle(benchmark::State &state)
+{
+    Points_gen::points_List points_instance;
+    std::vector<Points_gen::Point> path = points_instance.gen_Point_list();
+    Obstacle_Point obstacle = {1.5, 1.45};
+    double path_radius = 0.425;
+    for (auto _ : state)
+    {
+        std::vector<Points_gen::Point> vec = path;
+        for (size_t i = 0; i < vec.size(); i++)
+        {
+            if (isInObstacle(vec[i], obstacle, path_radius))
+            {
+                vec[i] = offsetPointInObstacle(vec[i], path_radius, obstacle);
+            }
+        }
+        benchmark::DoNotOptimize(vec.data());
+    }
+}
+BENCHMARK(BM_patchPathAroundObstacle)->Unit(benchmark::kMicrosecond);
+
+static void BM_thresholdFrame(benchmark::State &state)
+{
+    cv::Mat frame = syntheticFrame(state.range(0), state.range(1));
+    cv::Mat mask;
+    for (auto _ : state)
+    {
+        Paper_vision::thresholdFrame(frame, paperRange, mask);
+    }
+}
+BENCHMARK(BM_thresholdFrame)->Args({640, 480})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+
+//the synthetic frame as the YUYV a V4L2 webcam gives.
+static std::vector<uint8_t> syntheticYuyv(int width, int height)
+{
+    cv::Mat yuv;
+    cv::cvtColor(syntheticFrame(width, height), yuv, cv::COLOR_BGR2YUV);
+    std::vector<uint8_t> yuyv(width * height * 2);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x += 2)
+        {
+            const cv::Vec3b &a = yuv.at<cv::Vec3b>(y, x);
+            const cv::Vec3b &b = yuv.at<cv::Vec3b>(y, x + 1);
+            uint8_t *p = &yuyv[(y * width + x) * 2];
+            p[0] = a[0];
+            p[1] = (a[1] + b[1]) / 2;
+            p[2] = b[0];
+            p[3] = (a[2] + b[2]) / 2;
+        }
+    }
+    return yuyv;
+}
+
+//what the OpenCV capture does with a YUYV frame: convert it to BGR, then threshold it in HSV.
+static void BM_yuyvConvertThreshold(benchmark::State &state)
+{
+    int width = state.range(0);
+    int height = state.range(1);
+    std::vector<uint8_t> yuyv = syntheticYuyv(width, height);
+    cv::Mat mask;
+    cv::Mat bgr;
+    for (auto _ : state)
+    {
+        cv::cvtColor(cv::Mat(height, width, CV_8UC2, yuyv.data()), bgr, cv::COLOR_YUV2BGR_YUYV);
+        Paper_vision::thresholdFrame(bgr, paperRange, mask);
+    }
+}
+BENCHMARK(BM_yuyvConvertThreshold)->Args({640, 480})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+
+//the YUYV frame thresholded in place with the YUV colours of the paper range.
+static void BM_thresholdYuv(benchmark::State &state)
+{
+    int width = state.range(0);
+    int height = state.range(1);
+    std::vector<uint8_t> yuyv = syntheticYuyv(width, height);
+    Yuv_threshold::Yuv_frame frame = {Yuv_threshold::FORMAT_YUYV, width, height, yuyv.data(), size_t(width * 2), NULL, 0};
+
+    Yuv_threshold::Yuv_range range = Yuv_threshold::rangeOfHsv(paperRange.lowH, paperRange.highH, paperRange.lowS, paperRange.highS,
+                                                               paperRange.lowV, paperRange.highV);
+    cv::Mat mask;
+    for (auto _ : state)
+    {
+        Paper_vision::thresholdYuv(frame, range, mask);
+    }
+}
+BENCHMARK(BM_thresholdYuv)->Args({640, 480})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+
+static void BM_filterMask(benchmark::State &state)
+{
+    cv::Mat mask;
+    Paper_vision::thresholdFrame(syntheticFrame(state.range(0), state.range(1)), paperRange, mask);
+    for (auto _ : state)
+    {
+        cv::Mat filtered = mask.clone();
+        Paper_vision::filterMask(filtered);
+    }
+}
+BENCHMARK(BM_filterMask)->Args({640, 480})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+
+static void BM_filterMaskBytes(benchmark::State &state)
+{
+    cv::Mat mask;
+    Paper_vision::thresholdFrame(syntheticFrame(state.range(0), state.range(1)), paperRange, mask);
+    for (auto _ : state)
+    {
+        cv::Mat filtered = mask.clone();
+        Paper_vision::filterMaskBytes(filtered);
+    }
+}
+BENCHMARK(BM_filterMaskBytes)->Args({640, 480})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+
+//the packed morphology alone, without packing and unpacking the bytes.
+static void BM_bitMaskFilter(benchmark::State &state)
+{
+    cv::Mat mask;
+    Paper_vision::thresholdFrame(syntheticFrame(state.range(0), state.range(1)), paperRange, mask);
+    Bit_mask::bit_Mask bits;
+    Bit_mask::pack(mask.data, mask.step, mask.cols, 0, mask.rows, bits);
+    for (auto _ : state)
+    {
+        Bit_mask::bit_Mask filtered = bits;
+        Bit_mask::filter(filtered);
+    }
+}
+BENCHMARK(BM_bitMaskFilter)->Args({640, 480})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+
+static void BM_extractRuns(benchmark::State &state)
+{
+    cv::Mat mask;
+    Paper_vision::thresholdFrame(syntheticFrame(1280, 720), paperRange, mask);
+    Paper_vision::filterMask(mask);
+    Bit_mask::bit_Mask bits;
+    Bit_mask::pack(mask.data, mask.step, mask.cols, 0, mask.rows, bits);
+    std::vector<Blob_runs::Run> runs;
+    for (auto _ : state)
+    {
+        runs.clear();
+        if (state.range(0))
+        {
+            Bit_mask::extractRuns(bits, 0, bits.rows, 0, runs);
+        }
+        else
+        {
+            Blob_runs::extractRuns(mask.data, mask.step, mask.cols, 0, mask.rows, runs);
+        }
+    }
+}
+//0 scans the bytes, 1 the packed mask.
+BENCHMARK(BM_extractRuns)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_findBoundingBoxes(benchmark::State &state)
+{
+    cv::Mat frame = syntheticFrame(state.range(0), state.range(1));
+    cv::Mat mask;
+    Paper_vision::thresholdFrame(frame, paperRange, mask);
+    Paper_vision::filterMask(mask);
+    std::vector<std::vector<cv::Point>> contoursPoly;
+    std::vector<cv::Rect> boundbox;
+    for (auto _ : state)
+    {
+        cv::Mat contourMask = mask.clone();
+        Paper_vision::findBoundingBoxes(contourMask, contoursPoly, boundbox);
+    }
+}
+BENCHMARK(BM_findBoundingBoxes)->Args({640, 480})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+
+//threshold, morphology and blob extraction of a 1280x720 frame in bands, on 1 to N threads.
+static void BM_processBands(benchmark::State &state)
+{
+    cv::Mat frame = syntheticFrame(1280, 720);
+    Thread_pool::thread_Pool pool(state.range(0));
+    cv::Mat mask;
+    std::vector<cv::Rect> boundbox;
+    for (auto _ : state)
+    {
+        Paper_vision::processBands(frame, paperRange, pool, 2 * pool.size(), mask, boundbox);
+    }
+}
+BENCHMARK(BM_processBands)->DenseRange(1, std::max(1u, std::thread::hardware_concurrency()))->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+//the boxes of count mine colours, the paper range first and then boxes spread over the hues.
+static std::vector<Paper_vision::Hsv_range> colourRanges(int count)
+{
+    std::vector<Paper_vision::Hsv_range> ranges(1, paperRange);
+    for (int i = 1; i < count; i++)
+    {
+        Paper_vision::Hsv_range range = {10 + 20 * i, 25 + 20 * i, 100, 255, 100, 255};
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
+//one mask per colour: a conversion to HSV, then a threshold, morphology and labelling pass per colour.
+static void BM_inRangeClasses(benchmark::State &state)
+{
+    cv::Mat frame = syntheticFrame(640, 480);
+    std::vector<Paper_vision::Hsv_range> ranges = colourRanges(state.range(0));
+    cv::Mat hsv;
+    cv::Mat mask;
+    std::vector<Blob_runs::Blob> blobs;
+    for (auto _ : state)
+    {
+        cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+        blobs.clear();
+        for (size_t k = 0; k < ranges.size(); k++)
+        {
+            const Paper_vision::Hsv_range &range = ranges[k];
+            cv::inRange(hsv, cv::Scalar(range.lowH, range.lowS, range.lowV), cv::Scalar(range.highH, range.highS, range.highV), mask);
+            Paper_vision::filterMask(mask);
+            Paper_vision::labelRows(mask, 0, mask.rows, blobs);
+        }
+    }
+}
+BENCHMARK(BM_inRangeClasses)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMicrosecond);
+
+//the colours of colourRanges as HSV classes.
+static std::vector<Colour_lut::Colour_class> colourClasses(int count)
+{
+    std::vector<Paper_vision::Hsv_range> ranges = colourRanges(count);
+    std::vector<Colour_lut::Colour_class> classes;
+    for (size_t k = 0; k < ranges.size(); k++)
+    {
+        Colour_lut::Colour_class colourClass = {"", true, {ranges[k].lowH, ranges[k].lowS, ranges[k].lowV}, {ranges[k].highH, ranges[k].highS, ranges[k].highV}};
+        classes.push_back(colourClass);
+    }
+    return classes;
+}
+
+static void BM_compileColourTable(benchmark::State &state)
+{
+    std::vector<Colour_lut::Colour_class> classes = colourClasses(state.range(0));
+    Colour_lut::colour_Table table;
+    for (auto _ : state)
+    {
+        table.compile(classes);
+    }
+}
+BENCHMARK(BM_compileColourTable)->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+
+//the same colours as classes of one lookup table, on the calling thread.
+static void BM_processClasses(benchmark::State &state)
+{
+    cv::Mat frame = syntheticFrame(640, 480);
+    std::vector<Colour_lut::Colour_class> classes = colourClasses(state.range(0));
+    Colour_lut::colour_Table table;
+    table.compile(classes);
+
+    Thread_pool::thread_Pool pool(1);
+    cv::Mat classMask;
+    std::vector<std::vector<Blob_runs::Blob>> blobs;
+    for (auto _ : state)
+    {
+        Paper_vision::processClasses(frame, table, pool, 1, classMask, blobs);
+    }
+}
+BENCHMARK(BM_processClasses)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMicrosecond);
+
+//reordering lanes of a field after detours, the argument is the number of lanes.
+//the time budget is large, so this measures the time to a local optimum.
+static void BM_planRoute(benchmark::State &state)
+{
+    //boustrophedon lanes split in two by detours, shuffled to start from a bad order.
+    std::vector<Lane_order::Segment> segments;
+    for (int lane = 0; lane < state.range(0); lane++)
+    {
+        double x = 0.175 + 0.35 * (lane / 2);
+        Lane_order::Segment segment = {x, lane % 2 ? 1.6 : 0.175, x, lane % 2 ? 2.725 : 1.3};
+        segments.push_back(segment);
+    }
+    std::mt19937 random(1);
+    std::shuffle(segments.begin(), segments.end(), random);
+    for (auto _ : state)
+    {
+        Lane_order::Route route = Lane_order::planRoute(0, 0, segments, 10.0);
+        benchmark::DoNotOptimize(route.transit);
+    }
+}
+BENCHMARK(BM_planRoute)->RangeMultiplier(2)->Range(8, 512)->Unit(benchmark::kMicrosecond);
+
+//walk every point of a square field like the planner, with the obstacle check and next stop lookup at each point
+//and a detour around an obstacle in the middle. the argument is the side length in meters.
+static void BM_lanePathDrive(benchmark::State &state)
+{
+    Points_gen::points_List points_instance;
+    double side = state.range(0);
+    std::vector<Points_gen::Point> vec = points_instance.gen_Point_list(side, side);
+    Obstacle_Point obstacle = {side / 2, side / 2};
+    double path_radius = 0.425;
+    for (auto _ : state)
+    {
+        Path_plan::lane_Path path(vec);
+        double distance = 0;
+        size_t s = 0;
+        int offset = 0;
+        while (s < path.size())
+        {
+            int detour = path.detour(s, offset, obstacle, path_radius);
+            if (detour == offset && offset > 0)
+            {
+                s++;
+                offset = 0;
+            }
+            const Path_plan::Span &span = path.span(s);
+            distance += path.stop(s).y - path.point(span.begin + offset).y;
+            if (span.begin + ++offset == span.end)
+            {
+                s++;
+                offset = 0;
+            }
+        }
+        benchmark::DoNotOptimize(distance);
+    }
+}
+BENCHMARK(BM_lanePathDrive)->Arg(3)->Arg(10)->Arg(30)->Unit(benchmark::kMicrosecond);
+
+//incremental detection of a 1280x720 camera driving straight, the argument is the distance per frame in millimeters.
+static void BM_stripDetector(benchmark::State &state)
+{
+    cv::Mat frame = syntheticFrame(1280, 720);
+    Camera_model::Camera camera;
+    camera.imageWidth = 1280;
+    camera.imageHeight = 720;
+    Strip_detection::Strip_config config;
+    config.refreshFrames = 1000000;
+    Strip_detection::strip_Detector detector(camera, config);
+    turtlesim::Pose pose;
+    pose.x = 0;
+    pose.y = 0;
+    pose.theta = 0;
+    cv::Mat mask;
+    std::vector<cv::Rect> boundbox;
+    detector.process(frame, paperRange, pose, NULL, 1, mask, boundbox);
+    for (auto _ : state)
+    {
+        pose.x += state.range(0) / 1000.0;
+        detector.process(frame, paperRange, pose, NULL, 1, mask, boundbox);
+    }
+}
+BENCHMARK(BM_stripDetector)->Arg(2)->Arg(5)->Arg(10)->Arg(20)->Unit(benchmark::kMicrosecond);
+
+//a depth image of the floor with a box in front of the robot, projected to scan points.
+static void BM_depthProject(benchmark::State &state)
+{
+    Depth_scan::Depth_camera camera;
+    Depth_scan::depth_Projector projector(camera);
+    std::vector<uint16_t> depth(camera.width * camera.height, 0);
+    for (int r = 0; r < camera.height; r++)
+    {
+        double down = (r - camera.cy) / camera.fy;
+        for (int c = 0; c < camera.width; c++)
+        {
+            bool box = c > camera.width / 3 && c < camera.width / 2 && camera.mountHeight - 0.9 * down < 0.2;
+            depth[r * camera.width + c] = box ? 900 : down > 0 ? std::min(65000.0, 1000 * camera.mountHeight / down) : 0;
+        }
+    }
+    std::vector<Obstacle_avoidance::Obstacle_Point> points;
+    for (auto _ : state)
+    {
+        projector.project(depth.data(), camera.width * sizeof(uint16_t), points);
+        benchmark::DoNotOptimize(points.data());
+    }
+}
+BENCHMARK(BM_depthProject)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
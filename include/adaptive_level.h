@@ -0,0 +1,34 @@
+#pragma once
+
+//chooses how much work a frame gets, so the frame rate holds when frames take longer than their budget.
+namespace Adaptive_level
+{
+    struct Level_config
+    {
+        double budget = 0;       //seconds of processing per frame. 0 keeps the full level.
+        int maxLevel = 3;        //the cheapest level.
+        int overrunFrames = 2;   //consecutive frames over the budget before going one level cheaper.
+        double headroom = 0.6;   //a frame under this part of the budget has headroom.
+        int headroomFrames = 30; //consecutive frames with headroom before going one level back up.
+    };
+
+    //level 0 is the full pipeline, each higher level is cheaper. the level steps down quickly on overruns
+    //and back up slowly, so it does not flip between two levels.
+    class level_Controller
+    {
+    public:
+        explicit level_Controller(const Level_config &config = Level_config());
+
+        //report the processing time of a frame and get the level for the next one.
+        int update(double seconds);
+
+        int level() const { return current; }
+
+    private:
+        Level_config config;
+        int current;
+        int overruns;
+        int calm;
+    };
+
+} // namespace Adaptive_level
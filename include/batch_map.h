@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "camera_model.h"
+#include "colour_lut.h"
+#include "detection_map.h"
+#include "paper_vision.h"
+#include "pose_history.h"
+
+//rebuilds the mine map of a recorded mission from its mission logs, offline. the timeline of the logged frames is
+//split into chunks that are processed in parallel. a chunk starts reading a little before its begin, so the
+//detector has seen the frame before its first one. the sightings of the chunks are merged in the order of the
+//timeline, so the map is the same as a single pass over the logs, whatever the number of threads.
+namespace Batch_map
+{
+    struct Batch_config
+    {
+        //the colour range of the paper, or the colour classes if there are any.
+        Paper_vision::Hsv_range range = {0, 179, 170, 255, 150, 255};
+        const Colour_lut::colour_Table *classes = NULL;
+        //the cameras by the names their frames are logged with, frames of other cameras use the default camera.
+        std::vector<std::string> names;
+        std::vector<Camera_model::Camera> cameras;
+        //delay between the exposure of a frame and it being grabbed, in seconds.
+        double cameraLatency = 0;
+        //seconds a chunk starts reading before its begin and keeps reading past its end, for frames logged out of order.
+        double overlap = 2;
+        int surfaceLimit = 250;
+    };
+
+    //a mine seen in a frame, in the odometry frame.
+    struct Sighting
+    {
+        double stamp;
+        double x;
+        double y;
+    };
+
+    //the part [begin, end) of the timeline, with the sightings of its frames in the order of their stamps.
+    struct Chunk
+    {
+        double begin;
+        double end;
+        size_t frames;
+        std::vector<Sighting> sightings;
+    };
+
+    //the odometry poses of the logs, in the order of their stamps. false if a log can't be read.
+    bool loadPoses(const std::vector<std::string> &logs, std::vector<Pose_history::Stamped_pose> &poses);
+
+    //the pose at the stamp, interpolated between the poses around it. false outside the poses.
+    bool poseAt(const std::vector<Pose_history::Stamped_pose> &poses, double stamp, Pose_history::Stamped_pose &pose);
+
+    //the chunks of chunkLength seconds covering [begin, end].
+    std::vector<Chunk> splitTimeline(double begin, double end, double chunkLength);
+
+    //find the mines in the frames of the logs in the chunk. false if a log can't be read.
+    bool processChunk(const std::vector<std::string> &logs, const std::vector<Pose_history::Stamped_pose> &poses,
+                      const Batch_config &config, Chunk &chunk);
+
+    //add the sightings of the chunks to the map, in the order of the chunks.
+    void mergeChunks(const std::vector<Chunk> &chunks, Detection_map::detection_Map &map);
+
+} // namespace Batch_map
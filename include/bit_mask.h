@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "blob_runs.h"
+
+//binary masks with 64 pixels per word. morphology works on whole words with shifts and ORs/ANDs,
+//so it moves an eighth of the memory of a byte mask.
+namespace Bit_mask
+{
+    //pixel x of row y is bit x % 64 of word x / 64 of the row. bits past the width are kept 0.
+    class bit_Mask
+    {
+    public:
+        bit_Mask() : rows(0), cols(0), wordsPerRow(0) {}
+        bit_Mask(int rows, int cols) { create(rows, cols); }
+
+        void create(int rows, int cols);
+
+        uint64_t *row(int y) { return &words[y * wordsPerRow]; }
+        const uint64_t *row(int y) const { return &words[y * wordsPerRow]; }
+
+        int rows;
+        int cols;
+        int wordsPerRow;
+        std::vector<uint64_t> words;
+    };
+
+    //pack the rows [rowBegin, rowEnd) of a byte mask, whose pixels are 0 or 255 as cv::inRange gives them,
+    //into the mask rows starting at 0. the mask is created with rowEnd - rowBegin rows.
+    void pack(const uint8_t *data, size_t step, int width, int rowBegin, int rowEnd, bit_Mask &mask);
+
+    //pack the rows [rowBegin, rowEnd) of a byte image of class bits, bit k of every pixel into masks[k], for the first
+    //count bits in one pass over the image. the masks are created with rowEnd - rowBegin rows.
+    void packClasses(const uint8_t *data, size_t step, int width, int rowBegin, int rowEnd, int count, bit_Mask *masks);
+
+    //unpack the mask rows [rowBegin, rowEnd) to 0 and 255 bytes, starting at data.
+    void unpack(const bit_Mask &mask, int rowBegin, int rowEnd, uint8_t *data, size_t step);
+
+    //erosion and dilation with the 5x5 ellipse of cv::getStructuringElement, or the 3x3 one for radius 1,
+    //including its border handling: pixels outside the mask do not erode and do not dilate. dst must not be src.
+    void erode(const bit_Mask &src, bit_Mask &dst, int radius = 2);
+    void dilate(const bit_Mask &src, bit_Mask &dst, int radius = 2);
+
+    //opening followed by closing, the same as Paper_vision::filterMaskBytes.
+    void filter(bit_Mask &mask, int radius = 2);
+
+    //append the runs of set pixels in the mask rows [rowBegin, rowEnd), in row order.
+    //rowOffset is added to the row of each run.
+    void extractRuns(const bit_Mask &mask, int rowBegin, int rowEnd, int rowOffset, std::vector<Blob_runs::Run> &runs);
+
+} // namespace Bit_mask
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//blob labelling on horizontal runs of foreground pixels.
+//a mask can be split into bands of rows that are labelled independently and merged afterwards.
+namespace Blob_runs
+{
+    //foreground pixels [start, end) of a row.
+    struct Run
+    {
+        int row;
+        int start;
+        int end;
+    };
+
+    //8-connected group of runs. bounds are inclusive.
+    struct Blob
+    {
+        int minX, minY;
+        int maxX, maxY;
+        long area;
+    };
+
+    //append the runs of non-zero pixels in the rows [rowBegin, rowEnd) of a byte mask, in row order.
+    void extractRuns(const uint8_t *data, size_t step, int width, int rowBegin, int rowEnd, std::vector<Run> &runs);
+
+    //connect 8-connected runs of neighbouring rows. runs must be sorted by row and start.
+    //parent[i] is the union-find parent of runs[i], indices into runs.
+    void connectRuns(const std::vector<Run> &runs, std::vector<int> &parent);
+
+    //merge the connected runs of consecutive bands into blobs, joining runs that touch across the seam
+    //between two bands. blobs are ordered by their first run, top to bottom and left to right.
+    void mergeBands(const std::vector<std::vector<Run>> &bands, const std::vector<std::vector<int>> &parents, std::vector<Blob> &blobs);
+
+} // namespace Blob_runs
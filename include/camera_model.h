@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ros/ros.h"
+#include <turtlesim/Pose.h>
+
+//geometry of the downward facing cameras, used to place detections in the odometry frame.
+namespace Camera_model
+{
+    class point
+    {
+    public:
+        double x;
+        double y;
+    };
+
+    //mounting and optics of a downward facing camera.
+    //the robot frame used here has x to the right and y forward.
+    struct Camera
+    {
+        double fov = 64;            //diagonal field of view in degrees.
+        double height = 0.35;       //distance from the camera to the ground in meters.
+        double forward = 0.21;      //distance the image center is ahead of the robot center in meters.
+        double lateral = 0;         //distance the image center is right of the robot center in meters.
+        double yaw = 0;             //counter clockwise rotation of the image up direction from the robot forward direction in radians.
+        int imageWidth = 640;       //image size in pixels.
+        int imageHeight = 480;
+    };
+
+    //If theta is negative it is converted to the corresponding positive angle.
+    double getTheta(double angle);
+
+    //Converts degrees to radians.
+    double degreesToRadians(double angleDegrees);
+
+    //Converts a point from pixels to meters, based on the ratio between side length and number of pixels.
+    point pixelsToMeters(point coordInPixels, double length, int imageWidth = 640);
+
+    //Rotates a vector by a given angle.
+    point rotatePointByAngle(double angle, point coord);
+
+    //size of the ground area the camera sees, in meters. length is along the image width.
+    void groundFootprint(const Camera &camera, double &length, double &width);
+
+    //Converts a pixel coordinate in the camera image to the odometry frame, seen from the given robot pose.
+    point convertCoordinatesOfPoint(point Coord, turtlesim::Pose pose, const Camera &camera = Camera());
+
+    //Converts a point in the odometry frame to the pixel coordinate it has in the camera image, seen from the given robot pose.
+    //inverse of convertCoordinatesOfPoint.
+    point pixelOfPoint(point odomPoint, turtlesim::Pose pose, const Camera &camera = Camera());
+
+    //the camera of an entry of a ~cameras parameter, with the defaults for the fields the entry leaves out.
+    Camera cameraOfEntry(XmlRpc::XmlRpcValue &entry);
+
+    //the cameras listed in the cameras parameter of the node, the single default camera without it. names gets
+    //their names, the names paper_detection gives them.
+    std::vector<Camera> loadCameras(const ros::NodeHandle &node, const std::string &param = "cameras", std::vector<std::string> *names = NULL);
+
+    //the strip across the robot that the cameras see together, as its extent left and right of the robot center in
+    //meters. the ground areas of the cameras are merged where they touch, the strip is the one over the robot center.
+    //false if no camera sees the ground beside the center.
+    bool lateralSwath(const std::vector<Camera> &cameras, double &left, double &right);
+
+    //largest distance a corner of the ground area seen by the camera moves between two robot poses, in meters.
+    double footprintShift(const Camera &camera, turtlesim::Pose from, turtlesim::Pose to);
+
+} // namespace Camera_model
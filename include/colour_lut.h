@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ros/ros.h"
+
+//colour classes of any number of mine colours in one pass over a BGR frame. the classes are compiled into a table
+//over the quantized BGR cube, giving the classes of a colour as a bit mask, so a frame costs one lookup per pixel
+//however many classes there are.
+namespace Colour_lut
+{
+    //the classes of a table are the bits of a byte.
+    const int max_classes = 8;
+
+    //a box of colours. HSV boxes are in OpenCV HSV, hue 0 - 179 and saturation and value 0 - 255, a hue box with
+    //low above high wraps around red. BGR boxes are 0 - 255 per channel.
+    struct Colour_class
+    {
+        std::string name;
+        bool hsv;
+        int low[3];
+        int high[3];
+
+        bool contains(int b, int g, int r) const;
+    };
+
+    //OpenCV COLOR_BGR2HSV of one 8 bit colour, up to the rounding of its integer tables.
+    void bgrToHsv(int b, int g, int r, int hsv[3]);
+
+    class colour_Table
+    {
+    public:
+        //bits kept of every channel. 6 bits give a 256 KB table whose cells are 4 levels wide.
+        explicit colour_Table(int bits = 6);
+
+        //compile the classes into the table, a cell gets the classes of the colour at its center. false with more than
+        //max_classes classes.
+        bool compile(const std::vector<Colour_class> &classes);
+        const std::vector<Colour_class> &classes() const { return compiled; }
+
+        //the class bits of a colour.
+        uint8_t lookup(uint8_t b, uint8_t g, uint8_t r) const
+        {
+            return table[((b >> shift) << (2 * bits)) | ((g >> shift) << bits) | (r >> shift)];
+        }
+
+        //write the class bits of the pixels of the BGR rows [rowBegin, rowEnd) to out, which points to the row of rowBegin.
+        void classify(const uint8_t *bgr, size_t step, int width, int rowBegin, int rowEnd, uint8_t *out, size_t outStep) const;
+
+    private:
+        int bits;
+        int shift;
+        std::vector<uint8_t> table;
+        std::vector<Colour_class> compiled;
+    };
+
+    //compile the colour classes of the colour_classes parameter of the node, for example
+    //colour_classes: [{name: red, hsv: [170, 10, 170, 255, 150, 255]}, {name: blue, bgr: [120, 255, 0, 80, 0, 80]}]
+    //the boxes are low and high of every channel. false without the parameter or without a valid class.
+    bool loadClasses(const ros::NodeHandle &node, colour_Table &table);
+
+} // namespace Colour_lut
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include "bit_mask.h"
+#include "camera_model.h"
+
+//ground the robot has covered, as one bit per cell of a grid over the field in the odometry frame.
+namespace Coverage_map
+{
+    class coverage_Map
+    {
+    public:
+        //grid over the rectangle [minX, maxX] x [minY, maxY] with square cells of resolution meters.
+        coverage_Map(double minX, double minY, double maxX, double maxY, double resolution = 0.02);
+
+        //mark the cells whose center is inside the shape as covered. parts outside the grid are ignored.
+        void markDisk(double x, double y, double r);
+        //the area swept by a disk moving in a straight line.
+        void markSwept(double x0, double y0, double x1, double y1, double r);
+        //convex polygon, corners in order.
+        void markPolygon(const std::vector<Camera_model::point> &corners);
+
+        //part of the cells of the disk that are covered. 1 for a disk outside the grid.
+        double diskCoverage(double x, double y, double r) const;
+
+        //part of all cells that are covered.
+        double coverage() const;
+
+        //the cells, to share them with other robots. rows of words with one bit per cell.
+        const Bit_mask::bit_Mask &covered() const { return cells; }
+
+        //add the covered cells of another map of the same grid, the rows gaining cells count as marked for
+        //takeChanged. false if the grid differs.
+        bool merge(int rows, int cols, const std::vector<uint64_t> &words);
+
+        //the rows [begin, end) marked since the last call, to save only those. empty if begin == end.
+        void takeChanged(int &begin, int &end);
+
+    private:
+        //add the row to the rows marked since the last takeChanged.
+        void markChanged(int row);
+        //set the cells [begin, end) of a row.
+        void markSpan(int row, int begin, int end);
+        //the cells of a row whose center is in [x0, x1], cut to the grid. false if there are none.
+        bool span(double x0, double x1, int &begin, int &end) const;
+
+        double minX;
+        double minY;
+        double resolution;
+        Bit_mask::bit_Mask cells;
+        //rows marked since the last takeChanged.
+        int changedBegin;
+        int changedEnd;
+    };
+
+} // namespace Coverage_map
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "obstacle.h"
+
+//obstacles straight from the depth image of the 3D sensor. every column of the image gives the nearest point whose
+//height above the ground is in a band, so low and overhanging obstacles are seen, not only the one row of a scan.
+namespace Depth_scan
+{
+    //pinhole intrinsics of the depth camera and where it is mounted. the camera looks forward and level.
+    struct Depth_camera
+    {
+        int width = 640;
+        int height = 480;
+        double fx = 570.3;
+        double fy = 570.3;
+        double cx = 319.5;
+        double cy = 239.5;
+        double mountHeight = 0.28;    //height of the camera above the ground in meters.
+        double minHeight = 0.03;      //band of heights that are obstacles, above the floor and below the robot top.
+        double maxHeight = 0.45;
+        double maxRange = 1.5;        //points further away are ignored, in meters.
+    };
+
+    //projects depth images to the points of a scan in the laser frame, x forward and y to the left.
+    //the rays of the pixels are computed once: the lateral slope of every column and the band of depths of every
+    //row whose points are in the height band. a frame is then one pass over the rows keeping the nearest depth of
+    //every column, with no trigonometry per pixel.
+    class depth_Projector
+    {
+    public:
+        depth_Projector() {}
+        explicit depth_Projector(const Depth_camera &camera) { configure(camera); }
+
+        void configure(const Depth_camera &camera);
+        const Depth_camera &camera() const { return config; }
+
+        //project an image of depths in millimeters, 0 where there is no depth, as 16UC1 images are.
+        void project(const uint16_t *data, size_t step, std::vector<Obstacle_avoidance::Obstacle_Point> &points);
+        //project an image of depths in meters, NaN where there is no depth, as 32FC1 images are.
+        void project(const float *data, size_t step, std::vector<Obstacle_avoidance::Obstacle_Point> &points);
+
+    private:
+        //the points of the nearest depth of every column, in meters.
+        void columnPoints(std::vector<Obstacle_avoidance::Obstacle_Point> &points) const;
+
+        Depth_camera config;
+        //lateral offset per meter of depth of every column.
+        std::vector<float> slope;
+        //depths of every row whose points are in the height band, [nearRow, farRow]. empty rows have near > far.
+        std::vector<float> nearRow;
+        std::vector<float> farRow;
+        //the same in millimeters, for 16UC1 images.
+        std::vector<uint16_t> nearRowMm;
+        std::vector<uint16_t> farRowMm;
+        //nearest depth of every column in the last frame.
+        std::vector<float> nearest;
+        std::vector<uint16_t> nearestMm;
+    };
+
+} // namespace Depth_scan
@@ -0,0 +1,40 @@
+#pragma once
+#include <mutex>
+#include <vector>
+
+namespace Detection_map
+{
+    //a detected mine in the odometry frame.
+    struct Detection
+    {
+        int id;
+        double x;
+        double y;
+        //number of detections merged into this one.
+        int hits;
+    };
+
+    //detections of all cameras in the odometry frame.
+    //detections closer than the merge radius are the same mine seen again, or seen by overlapping cameras,
+    //and are merged into one with the averaged position. safe to use from several threads.
+    class detection_Map
+    {
+    public:
+        explicit detection_Map(double merge_radius = 0.1);
+
+        //add a detection and return the detection it was merged into.
+        Detection add(double x, double y);
+
+        //copy of all detections, in the order they were first seen.
+        std::vector<Detection> detections() const;
+
+        //replace all detections, e.g. by the ones saved before a restart. their ids must be their index.
+        void restore(const std::vector<Detection> &detections);
+
+    private:
+        mutable std::mutex mutex;
+        double merge_radius;
+        std::vector<Detection> list;
+    };
+
+} // namespace Detection_map
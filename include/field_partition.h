@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+//split the lanes of a field between the robots of a fleet.
+namespace Field_partition
+{
+    //the lanes [firstLane, lastLane] of a robot.
+    struct Region
+    {
+        int firstLane;
+        int lastLane;
+    };
+
+    //start position of a robot in the field frame.
+    struct Start
+    {
+        double x;
+        double y;
+    };
+
+    //give every robot a block of neighbouring lanes, with the regions ordered along the field like the robots' start positions.
+    //the blocks are chosen so the largest cost of a robot is as small as possible. the cost of a robot is the length of its lanes,
+    //the transits between them and the drive from its start to its first lane.
+    //lanes run along y at x = laneSpacing / 2 + lane * laneSpacing, from y = margin to y = width - margin.
+    //robots that get no lane, with more robots than lanes, have firstLane > lastLane.
+    std::vector<Region> partitionLanes(int lanes, double laneSpacing, double width, double margin, const std::vector<Start> &starts);
+
+} // namespace Field_partition
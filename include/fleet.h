@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ros/ros.h"
+#include "pose_history.h"
+
+//robots covering a field together. the robots and their start poses are the /fleet/robots parameter, e.g.
+//fleet/robots: [{name: robot1, x: 0.0, y: 0.0, theta: 0.0}, {name: robot2, x: 1.6, y: 0.0, theta: 0.0}]
+//every robot runs its nodes in the namespace of its name. all robots plan in the field frame, the odometry
+//of a robot starts at its start pose in that frame.
+namespace Fleet
+{
+    struct Robot
+    {
+        std::string name;
+        double x;
+        double y;
+        double theta;
+    };
+
+    //the robots of the /fleet/robots parameter. empty without it.
+    std::vector<Robot> loadRobots();
+
+    //name of this robot, the namespace of the node without slashes. empty in the global namespace.
+    std::string robotName();
+
+    //frame of the rviz markers. the field frame "field" in a fleet, where the launch file places each robot's
+    //odometry frame at its start pose, otherwise "/odom".
+    std::string markerFrame();
+
+    //converts odometry poses of a robot to the field frame.
+    class field_Frame
+    {
+    public:
+        //the identity, for a robot alone on the field.
+        field_Frame() : x(0), y(0), theta(0) {}
+        field_Frame(double x, double y, double theta) : x(x), y(y), theta(theta) {}
+
+        //the frame of this robot from /fleet/robots. the identity if the robot is not in it.
+        static field_Frame load();
+        //the frame in which the odometry pose odom is the field pose field, to continue in the field frame after
+        //a restart that reset the odometry.
+        static field_Frame matching(const Pose_history::Stamped_pose &field, const Pose_history::Stamped_pose &odom);
+
+        Pose_history::Stamped_pose toField(const Pose_history::Stamped_pose &odom) const;
+
+    private:
+        double x;
+        double y;
+        double theta;
+    };
+
+} // namespace Fleet
@@ -0,0 +1,46 @@
+#pragma once
+#include <turtlesim/Pose.h>
+#include "opencv2/core/core.hpp"
+#include "camera_model.h"
+
+//decides which camera frames are worth a full detection pass.
+namespace Frame_gate
+{
+    struct Gate_config
+    {
+        double minShift = 0.02; //distance in meters the ground footprint must move before a new pass.
+        double minChange = 6;   //mean absolute difference of the thumbnails, in grey levels, that counts as a change while the robot is still.
+        double maxAge = 2.0;    //seconds after which a frame is processed anyway.
+    };
+
+    //a frame is processed when the footprint of the camera moved enough since the last processed frame,
+    //or when the image changed although the robot did not move. the image change is checked on a small
+    //thumbnail, which costs a fraction of the full pass.
+    class frame_Gate
+    {
+    public:
+        frame_Gate(const Camera_model::Camera &camera, const Gate_config &config = Gate_config());
+
+        //true if the frame should be processed. the frame is remembered as the last processed one in that case.
+        bool shouldProcess(const cv::Mat &frame, const turtlesim::Pose &pose, double stamp);
+
+        //process the next frame regardless, e.g. after the colour range changed.
+        void reset();
+
+    private:
+        Camera_model::Camera camera;
+        Gate_config config;
+
+        bool primed;
+        turtlesim::Pose lastPose;
+        double lastStamp;
+        cv::Mat lastThumbnail;
+    };
+
+    //shrink the frame to a 32x24 thumbnail by area averaging.
+    void thumbnail(const cv::Mat &frame, cv::Mat &small);
+
+    //mean absolute difference of two thumbnails, per pixel and channel.
+    double thumbnailChange(const cv::Mat &a, const cv::Mat &b);
+
+} // namespace Frame_gate
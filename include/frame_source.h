@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "opencv2/core/core.hpp"
+#include "yuv_threshold.h"
+#include "mission_log.h"
+
+//where the camera frames come from. a V4L2 device or a raw file gives its YUV frames in the buffer they were
+//captured to, so they can be thresholded without converting or copying them. OpenCV gives BGR frames.
+namespace Frame_source
+{
+    //a grabbed frame, valid until it is released. a BGR frame is in bgr, a YUV frame in yuv.
+    struct Frame
+    {
+        bool isYuv = false;
+        cv::Mat bgr;
+        Yuv_threshold::Yuv_frame yuv;
+        //buffer of the source holding the frame.
+        int buffer = -1;
+    };
+
+    class frame_Source
+    {
+    public:
+        virtual ~frame_Source() {}
+
+        //wait for the next frame. returns false at the end of a file or on an error.
+        virtual bool grab(Frame &frame) = 0;
+
+        //give the buffer of the frame back to the source, its data may not be used after this.
+        virtual void release(Frame &frame) {}
+    };
+
+    //releases a grabbed frame when it goes out of scope.
+    class frame_Lease
+    {
+    public:
+        frame_Lease(frame_Source &source, Frame &frame) : source(source), frame(frame) {}
+        ~frame_Lease() { source.release(frame); }
+
+    private:
+        frame_Source &source;
+        Frame &frame;
+    };
+
+    //open a source, NULL if that fails:
+    //"v4l2:/dev/video0" a V4L2 device streaming from mmap buffers, in format "yuyv" or "nv12" at width x height.
+    //"raw:/path/frames.raw" a file written by raw_Writer, replayed at its frame rate.
+    //"log:/path/run.mdlog#name" the frames of camera name in a mission log, at the time of the ROS clock when it is
+    //simulated by the replay, otherwise at the rate they were logged. without #name the frames of the first camera.
+    //"topic:camera/rgb/image_raw" the bgr8 or rgb8 images of a sensor_msgs/Image topic, e.g. a camera in Gazebo.
+    //anything else is opened with OpenCV, a device index if it is only digits and a video file otherwise.
+    std::unique_ptr<frame_Source> openSource(const std::string &source, const std::string &format, int width, int height);
+
+    //the frame data as a matrix, without copying it: BGR as it is, YUYV as two channels and NV12 as its Y plane.
+    //enough to compare frames, not to show them.
+    cv::Mat rawView(const Frame &frame);
+
+    //the frame data without row padding, the chroma plane of NV12 after the luma plane, as raw files and mission logs
+    //keep it. returns the format of a raw file, 0 YUYV, 1 NV12 or 2 BGR.
+    uint32_t packFrame(const Frame &frame, std::vector<uint8_t> &bytes);
+
+    //the frame of a mission log record, raw frames point into the mapped log. false if a JPEG can't be decoded.
+    bool unpackLogged(const Mission_log::Frame &logged, Frame &frame);
+
+    //writes frames to a raw file for the raw source. the file is a header and the frames back to back,
+    //the rows of a frame without padding.
+    class raw_Writer
+    {
+    public:
+        ~raw_Writer();
+
+        //create the file for frames of the format and size of the first frame.
+        bool open(const std::string &path, const Frame &first, double fps);
+        bool write(const Frame &frame);
+
+    private:
+        std::FILE *file = NULL;
+        std::vector<uint8_t> packed;
+    };
+
+} // namespace Frame_source
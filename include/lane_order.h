@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+
+//order in which the remaining lanes are driven. every lane is a segment that can be driven in
+//either direction, the order and directions are chosen to keep the empty transits between lanes short.
+namespace Lane_order
+{
+    //the two ends of a lane.
+    struct Segment
+    {
+        double startX, startY;
+        double endX, endY;
+    };
+
+    //segment order[k] is driven k-th, from its end to its start if reversed[k].
+    struct Route
+    {
+        std::vector<int> order;
+        std::vector<bool> reversed;
+        //length of the transits, from the start position to the first segment and between segments.
+        double transit;
+    };
+
+    //nearest neighbour route from the start position and the segments in their given order, both improved by 2-opt
+    //and Or-opt moves until none shortens them or the time budget in seconds is used up. returns the shorter one, so
+    //the route is never longer than driving the segments as given.
+    Route planRoute(double startX, double startY, const std::vector<Segment> &segments, double timeBudget);
+
+    //transit length of a route.
+    double transitLength(double startX, double startY, const std::vector<Segment> &segments, const Route &route);
+
+} // namespace Lane_order
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "path_plan.h"
+
+//plans the path ahead of the robot on a thread of its own. while a lane is driven, the lanes after it are reordered
+//and detoured around the obstacle, so at the next lane start the main loop only splices the finished plan in.
+namespace Lane_planner
+{
+    //the path from a lane start on, planned for one version of the path.
+    struct Lane_plan
+    {
+        uint64_t version;
+        size_t from;
+        //whether the lanes were to be reordered, and whether their order changed.
+        bool reorder;
+        bool reordered;
+        double transit;
+        int detours;
+        //the points from the lane start on in driving order, with stop set on the last point of every span.
+        std::vector<Points_gen::Point> points;
+    };
+
+    //ring of plans passed from one producer thread to one consumer thread without locks.
+    class plan_Queue
+    {
+    public:
+        static const size_t capacity = 8;
+
+        //false if the queue is full, the plan stays with the caller then.
+        bool push(std::unique_ptr<Lane_plan> &plan);
+        //false if the queue is empty.
+        bool pop(std::unique_ptr<Lane_plan> &plan);
+
+    private:
+        std::unique_ptr<Lane_plan> slots[capacity];
+        //next slot to pop, written by the consumer, and next slot to push, written by the producer.
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+    };
+
+    class lane_Planner
+    {
+    public:
+        ~lane_Planner() { stop(); }
+
+        //lanesAhead lanes after the lane start are detoured ahead, lanes are reordered within reorderBudget seconds.
+        void start(int lanesAhead, double reorderBudget);
+        void stop();
+        bool running() const { return thread.joinable(); }
+
+        //plan the path from span from on, which starts a lane, for when the robot arrives there. version changes with
+        //every change of the path, a request equal to the last one is ignored. with reorder the lanes are reordered
+        //from the stop before the lane start.
+        void request(const Path_plan::lane_Path &path, uint64_t version, size_t from, bool reorder);
+
+        //the obstacle moved. the lanes planned ahead are planned again if it is near them.
+        void obstacle(const Obstacle_avoidance::Obstacle_Point &obstacle, double radius);
+
+        //collect the finished plans, keeping the newest. called by the consumer thread only.
+        void receive();
+        //the newest plan for the version, lane start and reorder. false if it is not finished yet.
+        //called by the consumer thread only.
+        bool take(uint64_t version, size_t from, bool reorder, Lane_plan &plan);
+
+    private:
+        void run();
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        int lanes_ahead = 1;
+        double reorder_budget = 0;
+
+        //guarded by mutex.
+        bool stopping = false;
+        //the last request, planned again when it is new or the obstacle moved near its lanes. path holds the spans of
+        //the requested path from span first on, the span before the lane start.
+        Path_plan::lane_Path path;
+        size_t first = 0;
+        uint64_t version = 0;
+        size_t from = 0;
+        bool reorder = false;
+        bool requested = false;
+        bool planned = true;
+        Obstacle_avoidance::Obstacle_Point current_obstacle = {0, 0};
+        double current_radius = 0;
+        //the lanes of the last plan, planned from its span planned_from on, and the obstacle they were planned against.
+        Path_plan::lane_Path planned_path;
+        size_t planned_from = 0;
+        Obstacle_avoidance::Obstacle_Point planned_obstacle = {0, 0};
+        double planned_radius = 0;
+        int planned_detours = 0;
+
+        plan_Queue finished;
+        //used by the planner thread only: a plan waiting for room in the queue.
+        std::unique_ptr<Lane_plan> unsent;
+        //used by the consumer thread only.
+        std::unique_ptr<Lane_plan> newest;
+    };
+
+} // namespace Lane_planner
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include "ros/ros.h"
+#include "latency_trace.h"
+
+namespace Latency_trace
+{
+    //periodically publishes the stage latency percentiles on /diagnostics.
+    //the summaries are published from a ros::Timer, so they are only sent while the node spins.
+    class diagnostics_Publisher
+    {
+    public:
+        //reads the private parameters ~diagnostics_period (seconds, 0 disables publishing)
+        //and ~trace_file (path of a binary trace file, empty disables tracing).
+        void start(ros::NodeHandle &n, const std::string &node_name);
+        ~diagnostics_Publisher();
+
+    private:
+        void publish(const ros::TimerEvent &event);
+
+        std::string node_name;
+        ros::Publisher diagnostics_pub;
+        ros::Timer timer;
+        bool tracing = false;
+    };
+
+} // namespace Latency_trace
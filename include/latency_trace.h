@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//low overhead latency instrumentation.
+//every thread records durations into its own histograms without locking,
+//summaries merge the histograms of all threads.
+namespace Latency_trace
+{
+    //maximum number of stages that can be registered.
+    const int max_stages = 64;
+
+    //monotonic time in nanoseconds.
+    uint64_t now();
+
+    //register a stage by name and return its id. registering the same name twice returns the same id.
+    int stage(const std::string &name);
+
+    //record the duration of one run of a stage on the calling thread.
+    void record(int stage_id, uint64_t start_ns, uint64_t duration_ns);
+
+    //records the time from construction to destruction.
+    class Scoped_timer
+    {
+    public:
+        explicit Scoped_timer(int stage_id) : stage_id(stage_id), start(now()) {}
+        ~Scoped_timer() { record(stage_id, start, now() - start); }
+
+    private:
+        int stage_id;
+        uint64_t start;
+    };
+
+    //record that a chain of messages reached the hop stage_id. the chain started from message seq of the sensor
+    //source_id, a stage id too, stamped origin_ns, and reached the hop at at_ns. both are ROS times in nanoseconds,
+    //so the hops written by different nodes line up. the stage records the time from the origin to the hop.
+    void hop(int stage_id, int source_id, uint32_t seq, uint64_t origin_ns, uint64_t at_ns);
+
+    //latency percentiles of a stage in milliseconds.
+    struct Stage_summary
+    {
+        std::string name;
+        uint64_t count;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+    };
+
+    //summaries of the stages that recorded anything since the previous call.
+    std::vector<Stage_summary> summarize();
+
+    //start writing every recorded duration to a binary trace file. returns false if it could not be opened.
+    bool open_trace(const std::string &path);
+
+    //flush and close the trace file.
+    void close_trace();
+
+} // namespace Latency_trace
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "ros/ros.h"
+#include <visualization_msgs/Marker.h>
+
+//rviz markers published from a background thread, so building and sending them stays off the control and vision paths.
+namespace Marker_sidecar
+{
+    //keeps the newest marker of every namespace and id, and publishes the changed ones as one MarkerArray on
+    ///visualization_marker_array at a capped rate. nothing is published without subscribers, and a new subscriber
+    //gets all markers again.
+    class marker_Sidecar
+    {
+    public:
+        //reads the private parameter ~marker_rate (Hz, 0 disables the markers).
+        void start(ros::NodeHandle &n);
+        void stop();
+        ~marker_Sidecar();
+
+        //whether anyone shows the markers. markers that are replaced often, like the obstacle, can skip building them without it.
+        bool wanted() const { return subscribed.load(std::memory_order_relaxed); }
+
+        //replace the marker with the namespace and id of this one. the marker is moved into the sidecar.
+        void update(visualization_msgs::Marker &marker);
+
+    private:
+        struct Entry
+        {
+            visualization_msgs::Marker marker;
+            bool dirty = false;
+        };
+
+        void run(double rate);
+
+        ros::Publisher marker_pub;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool running = false;
+        std::atomic<bool> subscribed{false};
+        //guarded by mutex.
+        std::map<std::pair<std::string, int>, Entry> markers;
+        int dirty_count = 0;
+    };
+
+} // namespace Marker_sidecar
@@ -0,0 +1,183 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//compact log of a field run, replayed instead of recording bags. the log is appended in chunks of about a second of
+//records: odometry as deltas in millimeters and 1e-4 radians, scans in millimeters, frames raw or as JPEG. every
+//chunk starts its deltas again, so a reader can start at any chunk, and an index of the chunks closes the file.
+//a log cut short by a crash has no index, the reader finds its chunks by walking them.
+namespace Mission_log
+{
+    enum Record_type
+    {
+        RECORD_ODOM = 1,
+        RECORD_SCAN = 2,
+        RECORD_FRAME = 3
+    };
+
+    //the first three are the formats of Frame_source raw files.
+    enum Frame_format
+    {
+        FRAME_YUYV = 0,
+        FRAME_NV12 = 1,
+        FRAME_BGR = 2,
+        FRAME_JPEG = 3
+    };
+
+    struct Odom
+    {
+        double x;
+        double y;
+        double theta;
+    };
+
+    //ranges in millimeters as little endian 16 bit values, 0 for no return.
+    struct Scan
+    {
+        float angleMin;
+        float angleIncrement;
+        float rangeMin;
+        float rangeMax;
+        int count;
+        const uint8_t *ranges;
+
+        //range i in meters, NaN for no return.
+        float range(int i) const;
+    };
+
+    //the bytes of a frame, the rows without padding and the chroma plane of NV12 after the luma plane.
+    struct Frame
+    {
+        std::string camera;
+        int format;
+        int width;
+        int height;
+        size_t bytes;
+        const uint8_t *data;
+    };
+
+    //a record read from a log. the data of scans and frames points into the mapped log.
+    struct Record
+    {
+        int type;
+        double stamp;
+        Odom odom;
+        Scan scan;
+        Frame frame;
+    };
+
+    //appends records to a log. the records are encoded into a chunk in memory, full chunks are written by a
+    //background thread, so the callers never wait for the disk. safe to use from several threads.
+    class log_Writer
+    {
+    public:
+        log_Writer() {}
+        ~log_Writer() { close(); }
+        log_Writer(const log_Writer &) = delete;
+        log_Writer &operator=(const log_Writer &) = delete;
+
+        //create the log at path, replacing an old one, see startPath. false if it can't be created.
+        bool open(const std::string &path);
+        bool isOpen() const { return file != NULL; }
+
+        void odom(double stamp, double x, double y, double theta);
+        void scan(double stamp, float angleMin, float angleIncrement, float rangeMin, float rangeMax, const std::vector<float> &ranges);
+        void frame(double stamp, const std::string &camera, int format, int width, int height, const uint8_t *data, size_t bytes);
+
+        //write the last chunk and the index.
+        void close();
+
+    private:
+        struct Chunk
+        {
+            std::vector<uint8_t> bytes;
+            uint32_t records = 0;
+            uint32_t streams = 0;
+            double base = 0;
+            double first = 0;
+            double last = 0;
+            //the last stamp in microseconds after base, and the last odometry, the deltas start from them.
+            int64_t stamp = 0;
+            int64_t odom[3] = {0, 0, 0};
+        };
+
+        //start a record in the current chunk, the chunk is queued first if it is full. called with the mutex held.
+        void begin(int type, double stamp);
+        void queueChunk();
+        void writeLoop();
+
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::deque<Chunk> full;
+        Chunk current;
+        bool closing = false;
+        std::thread writer;
+        std::FILE *file = NULL;
+
+        //written by the writer thread only.
+        uint64_t offset = 0;
+        std::vector<uint8_t> index;
+        uint32_t chunks = 0;
+    };
+
+    //reads a log through a read only view of its mapping. not thread safe, use a reader per thread.
+    class log_Reader
+    {
+    public:
+        log_Reader() {}
+        ~log_Reader() { close(); }
+        log_Reader(const log_Reader &) = delete;
+        log_Reader &operator=(const log_Reader &) = delete;
+
+        //map the log at path. false if it is not a log.
+        bool open(const std::string &path);
+        void close();
+
+        //the first and the last stamp of the log.
+        double begin() const;
+        double end() const;
+        //bytes of the log, for the replay rate.
+        size_t size() const { return length; }
+
+        //continue at the first record at or after the stamp, in the first chunk that reaches it.
+        void seek(double stamp);
+        //the next record in the order it was logged. false at the end of the log.
+        bool next(Record &record);
+
+    private:
+        //start reading chunk c.
+        void enterChunk(size_t c);
+
+        struct Entry
+        {
+            uint64_t offset;
+            double first;
+            double last;
+        };
+
+        uint8_t *map = NULL;
+        size_t length = 0;
+        std::vector<Entry> chunks;
+
+        //the chunk being read and the deltas in it.
+        size_t chunk = 0;
+        const uint8_t *position = NULL;
+        const uint8_t *chunkEnd = NULL;
+        double base = 0;
+        int64_t stamp = 0;
+        int64_t odom[3] = {0, 0, 0};
+        double skipBefore = 0;
+    };
+
+    //the path of the log of this start of the node, path with the start time and the process id before its extension,
+    //e.g. logs/laser-20261019-101500-4711.mdlog. a node respawned after a crash then keeps the log of the crashed run.
+    std::string startPath(const std::string &path);
+
+} // namespace Mission_log
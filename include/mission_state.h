@@ -0,0 +1,131 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "coverage_map.h"
+#include "detection_map.h"
+#include "path_plan.h"
+
+//mission state kept in memory mapped files, so a mission interrupted by a crash or a battery swap continues where
+//it stopped. an update is a few stores into the mapping, the kernel writes the pages back and sync waits for it.
+//records that may not be read half written have a sequence number and a checksum, and are written to two slots in
+//turn. a torn slot is ignored and the other one is used.
+namespace Mission_state
+{
+    //a pose in the field frame.
+    struct Pose
+    {
+        double x;
+        double y;
+        double theta;
+    };
+
+    //where the mission was at the last checkpoint.
+    struct Progress
+    {
+        //the span being driven, the spans before it are done, and the index of the next point in it.
+        int32_t span;
+        int32_t offset;
+        Pose pose;
+        //the last obstacle seen.
+        double obstacleX;
+        double obstacleY;
+        double obstacleR;
+    };
+
+    //the field of a mission, a file of another field is not resumed.
+    struct Field
+    {
+        double length;
+        double width;
+        double resolution;
+        //the lanes of this robot.
+        int32_t firstLane;
+        int32_t lastLane;
+    };
+
+    //a file mapped read and write, grown by remapping it.
+    class mapped_File
+    {
+    public:
+        mapped_File() {}
+        ~mapped_File() { close(); }
+        mapped_File(const mapped_File &) = delete;
+        mapped_File &operator=(const mapped_File &) = delete;
+
+        //map the file at path, created or cut to size bytes if truncate is set. false on an error.
+        bool open(const std::string &path, size_t size, bool truncate);
+        //grow the file to size bytes, the mapping may move.
+        bool resize(size_t size);
+        void sync();
+        void close();
+
+        uint8_t *data() const { return map; }
+        size_t size() const { return length; }
+
+    private:
+        int fd = -1;
+        uint8_t *map = NULL;
+        size_t length = 0;
+    };
+
+    //the state of path_basis: the path with its detours, the progress along it, and the covered cells.
+    class mission_File
+    {
+    public:
+        //create the file of a new mission, replacing an old one. false if it can't be written.
+        bool create(const std::string &path, const Field &field, const Coverage_map::coverage_Map &coverage);
+        //map the file of an unfinished mission on a field of the same size. false if there is none.
+        bool open(const std::string &path, const Field &field);
+
+        //the field the file was created for, with the lanes of the robot then.
+        Field field() const;
+        //false if no progress was saved.
+        bool loadProgress(Progress &progress) const;
+        //false if no path was saved or it is torn, the path is then planned again and its covered spans skipped.
+        bool loadPath(Path_plan::lane_Path &path) const;
+        //add the saved cells to the map.
+        void loadCoverage(Coverage_map::coverage_Map &coverage) const;
+
+        void saveProgress(const Progress &progress);
+        //rewrite the path, after a detour or a new lane order.
+        void savePath(const Path_plan::lane_Path &path);
+        //copy the rows marked since the last call.
+        void saveCoverage(Coverage_map::coverage_Map &coverage);
+        //the mission is done, so it is not resumed.
+        void finish();
+
+        //wait until the changes are on disk.
+        void sync() { file.sync(); }
+
+    private:
+        mapped_File file;
+        uint64_t progressSequence = 0;
+        uint64_t pathSequence = 0;
+    };
+
+    //the mines found by paper_detection, and its last pose. safe to use from several threads.
+    class mine_File
+    {
+    public:
+        //map the file at path. without resume the old mines are dropped.
+        bool open(const std::string &path, bool resume);
+
+        //the saved mines, numbered in the order they were found.
+        std::vector<Detection_map::Detection> loadMines() const;
+        //false if no pose was saved.
+        bool loadPose(Pose &pose) const;
+
+        //add or update the mine with the id of the detection.
+        void saveMine(const Detection_map::Detection &detection);
+        void savePose(const Pose &pose);
+
+    private:
+        mutable std::mutex mutex;
+        mapped_File file;
+        uint64_t poseSequence = 0;
+    };
+
+} // namespace Mission_state
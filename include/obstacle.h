@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include "points_gen.h"
 
 namespace Obstacle_avoidance{
     struct Obstacle_Point{
@@ -9,4 +10,16 @@ namespace Obstacle_avoidance{
     class Obstacle{
         std::vector<Obstacle_Point> peripheral_points();
     };
-}
\ No newline at end of file
+
+    //get the center of the circle through the first, middle and last point of an obstacle.
+    Obstacle_Point getCenterOfCircle(std::vector<Obstacle_Point> *points);
+
+    //calculate radius from center to peripheral point.
+    double obstacleRadius(Obstacle_Point center, Obstacle_Point per_coordinate);
+
+    //check if a path point is within the radius r of the obstacle.
+    bool isInObstacle(Points_gen::Point p, Obstacle_Point obstacle, double r);
+
+    //return new path point which is offset to the edge of the obstacle.
+    Points_gen::Point offsetPointInObstacle(Points_gen::Point path_point, double r, Obstacle_Point obstacle);
+}
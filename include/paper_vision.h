@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include "opencv2/imgproc/imgproc.hpp"
+#include "blob_runs.h"
+#include "colour_lut.h"
+#include "thread_pool.h"
+#include "yuv_threshold.h"
+
+//image processing steps of the paper detector.
+namespace Paper_vision
+{
+    //HSV colour box of the paper. hue is 0 - 179, saturation and value 0 - 255. a hue box with low above high wraps
+    //around red.
+    struct Hsv_range
+    {
+        int lowH, highH;
+        int lowS, highS;
+        int lowV, highV;
+    };
+
+    //convert a BGR frame to HSV and threshold it to a binary mask.
+    void thresholdFrame(const cv::Mat &frame, const Hsv_range &range, cv::Mat &mask);
+
+    //threshold a frame in its YUV format to a binary mask, without converting it. gives the mask of thresholdFrame on
+    //the frame converted by yuvToBgr.
+    void thresholdYuv(const Yuv_threshold::Yuv_frame &frame, const Yuv_threshold::Yuv_range &range, cv::Mat &mask);
+
+    //convert a YUV frame to BGR, for showing it.
+    void yuvToBgr(const Yuv_threshold::Yuv_frame &frame, cv::Mat &bgr);
+
+    //morphological opening followed by closing, removes small objects and small holes from the mask.
+    //the mask pixels must be 0 or 255. runs on a bit-packed copy of the mask.
+    //radius 2 uses the 5x5 ellipse, radius 1 the cheaper 3x3 one.
+    void filterMask(cv::Mat &mask, int radius = 2);
+
+    //the same with cv::erode and cv::dilate on the bytes.
+    void filterMaskBytes(cv::Mat &mask);
+
+    //find the outer contours of the mask as simplified polygons, and the bounding boxes of the 8-connected blobs they
+    //are the outlines of, top to bottom and then left to right like blobBoxes. the mask may be modified.
+    void findBoundingBoxes(cv::Mat &mask, std::vector<std::vector<cv::Point>> &contoursPoly, std::vector<cv::Rect> &boundbox);
+
+    //rows a band is extended by on both sides, so the four 5x5 morphology passes of filterMask
+    //give the same result in the band as on the full frame.
+    const int bandHalo = 4 * 2;
+
+    //threshold and filter the frame like thresholdFrame and filterMask, split into horizontal bands
+    //that are processed in parallel on the pool. the bounding boxes of the 8-connected blobs of the
+    //mask are found in the same pass, blobs crossing band borders are merged.
+    void processBands(const cv::Mat &frame, const Hsv_range &range, Thread_pool::thread_Pool &pool, int bands,
+                      cv::Mat &mask, std::vector<cv::Rect> &boundbox, int radius = 2);
+
+    //same as above, giving the blobs themselves.
+    void processBands(const cv::Mat &frame, const Hsv_range &range, Thread_pool::thread_Pool &pool, int bands,
+                      cv::Mat &mask, std::vector<Blob_runs::Blob> &blobs, int radius = 2);
+
+    //same as above for a YUV frame, thresholded with thresholdYuv.
+    void processBands(const Yuv_threshold::Yuv_frame &frame, const Yuv_threshold::Yuv_range &range, Thread_pool::thread_Pool &pool, int bands,
+                      cv::Mat &mask, std::vector<cv::Rect> &boundbox, int radius = 2);
+
+    //classify a BGR frame by the colour classes of the table and find the blobs of every class, in bands on the pool
+    //like processBands. classes gets the class bits of the pixels before filtering, blobs[k] the blobs of class k after
+    //filtering. a class costs a pack, a filter and the labelling of its runs, the frame is read once for all classes.
+    void processClasses(const cv::Mat &frame, const Colour_lut::colour_Table &table, Thread_pool::thread_Pool &pool, int bands,
+                        cv::Mat &classes, std::vector<std::vector<Blob_runs::Blob>> &blobs, int radius = 2);
+
+    //threshold and filter only the region of the frame into the same region of the mask, with the result the
+    //full frame would give there. the mask must have the size of the frame.
+    void processRegion(const cv::Mat &frame, const Hsv_range &range, const cv::Rect &region, cv::Mat &mask);
+
+    //append the 8-connected blobs of the mask rows [rowBegin, rowEnd).
+    void labelRows(const cv::Mat &mask, int rowBegin, int rowEnd, std::vector<Blob_runs::Blob> &blobs);
+
+    //bounding boxes of blobs, top to bottom and then left to right. the mine trigger compares the boxes of frames by
+    //their index, so every way of finding the boxes gives them in this order.
+    void blobBoxes(const std::vector<Blob_runs::Blob> &blobs, std::vector<cv::Rect> &boundbox);
+
+    //picks the bounding boxes of a frame that are mines: a box more than surfaceLimit pixels smaller than the box
+    //with the same index in the frame before.
+    class mine_Trigger
+    {
+    public:
+        explicit mine_Trigger(int surfaceLimit = 250) : surfaceLimit(surfaceLimit) {}
+
+        //compare the boxes of the next frame with the frame before, and append the ones that are mines.
+        void update(const std::vector<cv::Rect> &boundbox, std::vector<cv::Rect> &mines);
+
+    private:
+        int surfaceLimit;
+        //surface of the bounding boxes of the frame before.
+        std::vector<int> lastSurface;
+    };
+
+} // namespace Paper_vision
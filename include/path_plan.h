@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include "points_gen.h"
+#include "obstacle.h"
+
+//the coverage path as a list of spans. a span is a run of points the robot drives without stopping, it stops
+//and turns at the last point of every span. the points of a span are contiguous, so the next stop of any point
+//is found without walking the path.
+namespace Path_plan
+{
+    struct Span
+    {
+        //points [begin, end) of the path, the stop is end - 1.
+        int begin;
+        int end;
+        int lane;
+        //bounding box of the points, to skip the obstacle check on spans far from the obstacle.
+        double minX, minY;
+        double maxX, maxY;
+    };
+
+    class lane_Path
+    {
+    public:
+        lane_Path() {}
+        //split a generated path after each of its stop points.
+        explicit lane_Path(const std::vector<Points_gen::Point> &path);
+        //a path saved with compact.
+        lane_Path(const std::vector<Points_gen::Point> &points, const std::vector<Span> &spans) : points(points), spans(spans) {}
+
+        size_t size() const { return spans.size(); }
+        const Span &span(size_t s) const { return spans[s]; }
+        const Points_gen::Point &point(int index) const { return points[index]; }
+        const Points_gen::Point &stop(size_t s) const { return points[spans[s].end - 1]; }
+        //true if span s is the first span of its lane.
+        bool laneStart(size_t s) const { return s == 0 || spans[s].lane != spans[s - 1].lane; }
+
+        //if points of span s from offset on are within radius of the obstacle, replace the first run of them by a
+        //detour around the obstacle. span s is split into the part before the detour, the detour up to the first point
+        //after the obstacle, and the rest. returns the offset in span s where the detour starts, or -1 without detour.
+        //the stop of the span is never moved.
+        int detour(size_t s, int offset, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius);
+        //detour the spans of the first lanes from span s on around the obstacle. returns the number of detours.
+        int detourLanes(size_t s, int lanes, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius);
+        //true if a span of the first lanes from span s on has its bounding box within radius of the obstacle.
+        bool nearLanes(size_t s, int lanes, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius) const;
+
+        //reorder the lanes from span s on, which must start a lane, so the transits between them are short when starting
+        //at x, y. a lane may be driven in either direction. returns true if the order changed, which it only does when
+        //that makes the transits strictly shorter. transit is set to the length of the transits of the kept order.
+        bool reorderLanes(size_t s, double x, double y, double timeBudget, double &transit);
+
+        //the points of the spans from s on in driving order, with stop set on the last point of every span.
+        std::vector<Points_gen::Point> flatten(size_t s = 0) const;
+        //replace the spans from s on by a path flattened from them, e.g. a copy planned ahead.
+        void replaceFrom(size_t s, const std::vector<Points_gen::Point> &path);
+
+        //the spans with only their own points, in span order, to save the path.
+        void compact(std::vector<Points_gen::Point> &points, std::vector<Span> &spans) const;
+
+    private:
+        //add the points as spans ending at their stop points, the last point always ends a span.
+        void appendSpans(const std::vector<Points_gen::Point> &path, std::vector<Span> &out);
+        Span makeSpan(int begin, int end) const;
+        //drop the points no span uses once they are more than half of the points, the spans keep their indices.
+        void dropUnused();
+        //true if span s is within radius of the obstacle by its bounding box.
+        bool spanNear(size_t s, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius) const;
+
+        //points of all spans. points replaced by a detour or a reversed lane stay until dropUnused, the new ones are
+        //appended.
+        std::vector<Points_gen::Point> points;
+        std::vector<Span> spans;
+    };
+
+} // namespace Path_plan
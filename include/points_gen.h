@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include "ros/ros.h"
+#include "marker_sidecar.h"
+#include "camera_model.h"
 
 namespace Points_gen
 {
@@ -9,13 +11,31 @@ namespace Points_gen
         double x;
         double y;
         bool stop;
+        //index of the lane the point belongs to. points of one lane are consecutive.
+        int lane;
     };
 
+    //the widest spacing of the lanes at which the cameras still see all the ground between them, with neighbouring
+    //lanes sharing the overlap part of the strip the cameras see. the strip is taken as wide on both sides of the
+    //robot as on its narrower side, so the lanes are covered whichever way they are driven. fallback if the cameras
+    //see no strip over the robot center.
+    double laneSpacing(const std::vector<Camera_model::Camera> &cameras, double overlap, double fallback);
+
+    //the number of lanes the points are on.
+    int laneCount(const std::vector<Point> &points);
+
+    //the distance along the points in meters, the lanes with the transits between them.
+    double pathLength(const std::vector<Point> &points);
+
     class points_List
     {
     public:
-        std::vector<Point> gen_Point_list();
-        void rvizPoints(ros::Publisher point_pub, std::vector<Point> point_list);
+        //generate the path covering a field of the given length (x) and width (y) in meters, with the lanes
+        //laneSpacing apart at x = laneSpacing / 2 + lane * laneSpacing, the last lane no further than laneSpacing / 2
+        //from the end of the field.
+        std::vector<Point> gen_Point_list(double length = 3.0, double width = 2.9, double laneSpacing = 0.35);
+        //hand the path to the marker sidecar, as points with the stops in red and a line through them.
+        void rvizPoints(Marker_sidecar::marker_Sidecar &markers, const std::vector<Point> &point_list, const std::string &frame_id = "/odom", const std::string &ns = "Path namespace");
     };
 
 } // namespace Points_gen
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Pose_history
+{
+    //robot pose in the odometry frame, stamped with the time (in seconds) it was measured.
+    struct Stamped_pose
+    {
+        double stamp;
+        double x;
+        double y;
+        double theta;
+    };
+
+    //interpolate between two poses along the SE2 geodesic (constant linear and angular velocity).
+    Stamped_pose interpolate(const Stamped_pose &a, const Stamped_pose &b, double stamp);
+
+    //ring buffer of the latest odometry poses.
+    //a single thread (the odometry callback) writes, any number of threads may read without locking.
+    //every slot carries its own sequence number, so a reader detects and skips a slot that was
+    //overwritten while it was being read.
+    class pose_Buffer
+    {
+    public:
+        explicit pose_Buffer(size_t capacity = 256);
+
+        //append a pose. stamps must be increasing, older poses are dropped.
+        void push(const Stamped_pose &pose);
+
+        //get the newest pose without blocking the writer. returns false if no pose has been received.
+        bool latest(Stamped_pose &pose) const;
+
+        //get the pose at the given time, interpolated between the two surrounding poses.
+        //a stamp newer than the newest pose returns the newest pose.
+        //returns false if the stamp is older than the buffer reaches back.
+        bool lookup(double stamp, Stamped_pose &pose) const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> seq;
+            std::atomic<double> stamp;
+            std::atomic<double> x;
+            std::atomic<double> y;
+            std::atomic<double> theta;
+        };
+
+        //read the pose with the given write index. fails if the slot has been reused.
+        bool read(uint64_t index, Stamped_pose &pose) const;
+
+        size_t capacity;
+        std::unique_ptr<Slot[]> slots;
+        //number of poses written so far.
+        std::atomic<uint64_t> head;
+    };
+
+} // namespace Pose_history
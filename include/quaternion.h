@@ -0,0 +1,14 @@
+#pragma once
+
+struct Quaternion
+{
+    double x, y, z, w;
+};
+
+struct EulerAngles
+{
+    double roll, pitch, yaw;
+};
+
+//convert quarternion into eulerangles.
+EulerAngles ToEulerAngles(Quaternion q);
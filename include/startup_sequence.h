@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "ros/ros.h"
+#include "ros/callback_queue.h"
+#include <std_srvs/Trigger.h>
+
+//the steps of path_basis before the robot moves: wait for the mobile base to connect, reset its odometry, and wait for
+//the mission to be started by the start_mission service. the steps run on callbacks of their own queue and thread, so
+//nothing spins while waiting and the mission is planned on the main thread meanwhile.
+namespace Startup_sequence
+{
+    enum Stage
+    {
+        STAGE_WAIT_BASE,     //the base has not subscribed to the reset and velocity topics yet.
+        STAGE_WAIT_ODOMETRY, //waiting for the first odometry after the reset.
+        STAGE_READY,         //waiting for the start.
+        STAGE_STARTED
+    };
+
+    class startup_Sequence
+    {
+    public:
+        ~startup_Sequence() { stop(); }
+
+        //advertise the reset and velocity topics and the start_mission service on n. without reset the odometry is kept,
+        //as for a resumed mission. with autoStart the mission starts as soon as the base is ready.
+        void start(ros::NodeHandle &n, bool reset, bool autoStart);
+        void stop();
+
+        //the publisher of the velocity commands.
+        ros::Publisher velocity() const { return velocity_pub; }
+        Stage stage() const { return current.load(std::memory_order_acquire); }
+
+        //called by the odometry callback with the stamp of every message.
+        void odometry(double stamp);
+
+        //wait until the mission is started. the callbacks of the global queue keep running meanwhile.
+        //false if ROS shuts down first.
+        bool waitForStart();
+
+        //called before every velocity command, the first one records the time from the start to the first motion.
+        void moved();
+
+    private:
+        void connected(const ros::SingleSubscriberPublisher &subscriber);
+        bool startService(std_srvs::Trigger::Request &request, std_srvs::Trigger::Response &response);
+        //move on to the next stages whose conditions hold. called with the mutex held.
+        void advance();
+
+        ros::CallbackQueue queue;
+        std::unique_ptr<ros::AsyncSpinner> spinner;
+        ros::Publisher reset_pub;
+        ros::Publisher velocity_pub;
+        ros::ServiceServer start_service;
+
+        std::atomic<Stage> current{STAGE_WAIT_BASE};
+        //guarded by mutex.
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool reset = true;
+        bool start_requested = false;
+        //odometry stamped at or after this is from after the reset, none before the reset is sent.
+        double odometry_after = INFINITY;
+        bool odometry_seen = false;
+        //Latency_trace times of the node start and the start request.
+        uint64_t node_start = 0;
+        uint64_t start_time = 0;
+
+        //used by the main thread only.
+        bool has_moved = false;
+    };
+
+} // namespace Startup_sequence
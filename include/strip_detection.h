@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <turtlesim/Pose.h>
+#include "opencv2/imgproc/imgproc.hpp"
+#include "blob_runs.h"
+#include "camera_model.h"
+#include "paper_vision.h"
+#include "thread_pool.h"
+
+//incremental paper detection. while the robot drives, most of a frame is ground that was already
+//analysed in the previous frame, only moved in the image. the odometry predicts that motion, the previous
+//mask and blobs are moved along and only the newly exposed strip is thresholded, filtered and labelled.
+namespace Strip_detection
+{
+    struct Strip_config
+    {
+        int refreshFrames = 10; //a full frame is processed every this many frames, to stop errors in the predicted motion from adding up.
+        double maxError = 1.0;  //largest difference in pixels between the motion of the image corners and the center, above it the image
+                                //did not just translate, e.g. because the robot turned, and the full frame is processed.
+    };
+
+    class strip_Detector
+    {
+    public:
+        strip_Detector(const Camera_model::Camera &camera, const Strip_config &config = Strip_config());
+
+        //find the mask and bounding boxes of the paper in a frame seen from the pose. the frame is processed
+        //in bands on the pool if one is given and the full frame is processed.
+        //returns true if the full frame was processed, false if only the new strip.
+        bool process(const cv::Mat &frame, const Paper_vision::Hsv_range &range, const turtlesim::Pose &pose,
+                     Thread_pool::thread_Pool *pool, int bands, cv::Mat &mask, std::vector<cv::Rect> &boundbox);
+
+    private:
+        //the rounded image motion since the last frame, previous(q + (dx, dy)) shows the ground now at q.
+        //false if the motion is not a translation or too large to be worth it.
+        bool predictShift(const turtlesim::Pose &pose, int rows, int cols, int &dx, int &dy) const;
+
+        void processFull(const cv::Mat &frame, const Paper_vision::Hsv_range &range, Thread_pool::thread_Pool *pool, int bands, cv::Mat &mask);
+        void processStrips(const cv::Mat &frame, const Paper_vision::Hsv_range &range, int dx, int dy, cv::Mat &mask);
+
+        Camera_model::Camera camera;
+        Strip_config config;
+
+        bool primed;
+        int framesSinceRefresh;
+        turtlesim::Pose lastPose;
+        Paper_vision::Hsv_range lastRange;
+        cv::Mat lastMask;
+        std::vector<Blob_runs::Blob> blobs;
+    };
+
+    //move the mask by the image motion, mask(q) = previous(q + (dx, dy)). uncovered pixels are zero.
+    void shiftMask(const cv::Mat &previous, int dx, int dy, cv::Mat &mask);
+
+} // namespace Strip_detection
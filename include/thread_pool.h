@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Thread_pool
+{
+    //persistent pool of worker threads with one task queue per worker.
+    //an idle worker steals tasks from the other queues, so uneven tasks still keep every core busy.
+    class thread_Pool
+    {
+    public:
+        //threads is the total number of threads working on a parallelFor, including the calling thread.
+        //0 uses one thread per core.
+        explicit thread_Pool(unsigned threads = 0);
+        ~thread_Pool();
+
+        //number of threads working on a parallelFor, including the calling thread.
+        unsigned size() const { return workers.size() + 1; }
+
+        //run body(i) for every i in [0, count) and wait until all have finished.
+        //the calling thread runs tasks too. several threads may call parallelFor at the same time.
+        void parallelFor(int count, const std::function<void(int)> &body);
+
+    private:
+        struct Job
+        {
+            const std::function<void(int)> *body;
+            //tasks not yet finished, guarded by mutex.
+            int remaining;
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+
+        struct Task
+        {
+            Job *job;
+            int index;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        //take a task from the own queue, or steal one from another queue.
+        bool takeTask(unsigned self, Task &task);
+        void runTask(const Task &task);
+        void workerLoop(unsigned self);
+
+        std::vector<std::thread> workers;
+        //queue 0 is shared by the calling threads, queue i + 1 belongs to worker i.
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::atomic<unsigned> next_queue;
+
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::atomic<int> queued;
+        bool stopping;
+    };
+
+} // namespace Thread_pool
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include "ros/ros.h"
+#include "mine_detection/TraceContext.h"
+#include "latency_trace.h"
+
+//trace contexts of the chains of messages that follow from one sensor message, like a scan to its obstacle, the
+//detour around it and the velocity command after it. every node records when a chain reaches it in its trace file
+//(~trace_file), trace_report joins the hops of all nodes into the latency from the sensor to every hop.
+namespace Trace_context
+{
+    //the context of a new message of the sensor source, stamped stamp. the messages of a source are numbered.
+    mine_detection::TraceContext begin(const std::string &source, const ros::Time &stamp);
+
+    //record that the chain of trace reached the hop stage_id now. a message without a context is not recorded.
+    void hop(int stage_id, const mine_detection::TraceContext &trace);
+
+} // namespace Trace_context
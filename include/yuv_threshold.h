@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//threshold camera frames in their YUV format, without converting them to BGR and HSV first.
+//the YUV values are BT.601 with limited range, as V4L2 webcams give them.
+namespace Yuv_threshold
+{
+    enum Yuv_format
+    {
+        //4:2:2, one row of Y0 U Y1 V per two pixels.
+        FORMAT_YUYV,
+        //4:2:0, a Y plane and a half resolution plane of interleaved U V.
+        FORMAT_NV12
+    };
+
+    //a frame in the buffer it was captured to. uv is only used for NV12.
+    struct Yuv_frame
+    {
+        Yuv_format format;
+        int width;
+        int height;
+        const uint8_t *data;
+        size_t step;
+        const uint8_t *uv;
+        size_t uvStep;
+    };
+
+    //the YUV colours of the paper, one bit per colour of the YUV cube. a colour is in the range if the BGR colour
+    //OpenCV converts it to, as COLOR_YUV2BGR_YUYV and COLOR_YUV2BGR_NV12 do, is in the HSV box as COLOR_BGR2HSV gives
+    //it, so a YUV frame gives the mask its BGR conversion would give. the bits of the 256 luma values of a chroma pair
+    //are next to each other, as the two pixels of a pair share their chroma.
+    struct Yuv_range
+    {
+        std::vector<uint64_t> bits;
+
+        bool contains(uint8_t y, uint8_t u, uint8_t v) const
+        {
+            return (bits[(size_t(u) << 10) | (size_t(v) << 2) | (y >> 6)] >> (y & 63)) & 1;
+        }
+    };
+
+    //the YUV range of an HSV box, hue 0 - 179 and saturation and value 0 - 255 like OpenCV. a hue box with low above
+    //high wraps around red. an empty box gives an empty range. takes about 16 M tests, compute it once per box.
+    Yuv_range rangeOfHsv(int lowH, int highH, int lowS, int highS, int lowV, int highV);
+
+    //write 255 to the mask for pixels of the rows [rowBegin, rowEnd) in the range, 0 otherwise, 0 for all with an empty
+    //range. mask points to the mask row of rowBegin.
+    void threshold(const Yuv_frame &frame, int rowBegin, int rowEnd, const Yuv_range &range, uint8_t *mask, size_t maskStep);
+
+} // namespace Yuv_threshold
@@ -0,0 +1,43 @@
+#include "adaptive_level.h"
+
+using namespace Adaptive_level;
+
+level_Controller::level_Controller(const Level_config &config)
+    : config(config), current(0), overruns(0), calm(0)
+{
+}
+
+int level_Controller::update(double seconds)
+{
+    if (config.budget <= 0)
+    {
+        return current;
+    }
+
+    if (seconds > config.budget)
+    {
+        calm = 0;
+        if (++overruns >= config.overrunFrames && current < config.maxLevel)
+        {
+            current++;
+            overruns = 0;
+        }
+    }
+    else
+    {
+        overruns = 0;
+        if (seconds < config.headroom * config.budget)
+        {
+            if (++calm >= config.headroomFrames && current > 0)
+            {
+                current--;
+                calm = 0;
+            }
+        }
+        else
+        {
+            calm = 0;
+        }
+    }
+    return current;
+}
@@ -0,0 +1,120 @@
+#include "ros/ros.h"
+#include <math.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "opencv2/core/core.hpp"
+#include <batch_map.h>
+#include <camera_model.h>
+#include <colour_lut.h>
+#include <detection_map.h>
+#include <mission_log.h>
+#include <thread_pool.h>
+
+//rebuilds the mine map of a recorded mission from its mission logs, to see the effect of new thresholds or a new
+//camera model without driving the field again. the odometry comes from the log of path_basis, the frames from the
+//log of paper_detection, written with ~log_frame_period:=0 to keep every frame.
+//usage: rosrun mine_detection batch_detection path_basis-*.mdlog paper_detection-*.mdlog _output:=mines.csv
+//~cameras, ~colour_classes and ~camera_latency are those of paper_detection, ~hsv is the colour range of the paper
+//as [low h, high h, low s, high s, low v, high v]. ~chunk_length is the seconds of the timeline a thread processes
+//at a time, ~chunk_overlap the seconds a chunk reads before it and ~threads the threads, 0 for one per core.
+//the mines are written to ~output as id,x,y,hits in the odometry frame.
+
+int main(int argc, char *argv[])
+{
+    ros::init(argc, argv, "batch_detection");
+    ros::NodeHandle n;
+
+    std::vector<std::string> logs(argv + 1, argv + argc);
+    if (logs.empty())
+    {
+        ROS_ERROR("Usage: batch_detection LOG...");
+        return 1;
+    }
+
+    Batch_map::Batch_config config;
+    config.cameras = Camera_model::loadCameras(ros::NodeHandle("~"), "cameras", &config.names);
+    ros::NodeHandle("~").param("camera_latency", config.cameraLatency, config.cameraLatency);
+    ros::NodeHandle("~").param("chunk_overlap", config.overlap, config.overlap);
+    std::vector<int> hsv;
+    if (ros::NodeHandle("~").getParam("hsv", hsv) && hsv.size() == 6)
+    {
+        Paper_vision::Hsv_range range = {hsv[0], hsv[1], hsv[2], hsv[3], hsv[4], hsv[5]};
+        config.range = range;
+    }
+    Colour_lut::colour_Table colourTable;
+    if (Colour_lut::loadClasses(ros::NodeHandle("~"), colourTable))
+    {
+        config.classes = &colourTable;
+    }
+    double chunkLength;
+    int threads;
+    std::string output;
+    ros::NodeHandle("~").param("chunk_length", chunkLength, 60.0);
+    ros::NodeHandle("~").param("threads", threads, 0);
+    ros::NodeHandle("~").param("output", output, std::string("mines.csv"));
+
+    ros::WallTime start = ros::WallTime::now();
+    std::vector<Pose_history::Stamped_pose> poses;
+    if (!Batch_map::loadPoses(logs, poses))
+    {
+        ROS_ERROR("Could not read the logs.");
+        return 1;
+    }
+    if (poses.empty())
+    {
+        ROS_ERROR("The logs have no odometry, add the log of path_basis.");
+        return 1;
+    }
+
+    //the timeline of the logs, split into chunks processed in parallel.
+    double begin = INFINITY;
+    double end = -INFINITY;
+    for (size_t l = 0; l < logs.size(); l++)
+    {
+        Mission_log::log_Reader reader;
+        reader.open(logs[l]);
+        begin = std::min(begin, reader.begin());
+        end = std::max(end, reader.end());
+    }
+    std::vector<Batch_map::Chunk> chunks = Batch_map::splitTimeline(begin, end, chunkLength);
+
+    //the chunks are the parallelism, keep OpenCV from starting its own threads per call.
+    cv::setNumThreads(0);
+    Thread_pool::thread_Pool pool(threads);
+    std::vector<char> read(chunks.size());
+    pool.parallelFor(chunks.size(), [&](int c) { read[c] = Batch_map::processChunk(logs, poses, config, chunks[c]); });
+    if (std::count(read.begin(), read.end(), 0) > 0)
+    {
+        ROS_ERROR("Could not read the logs.");
+        return 1;
+    }
+
+    Detection_map::detection_Map map;
+    Batch_map::mergeChunks(chunks, map);
+    std::vector<Detection_map::Detection> mines = map.detections();
+
+    FILE *file = fopen(output.c_str(), "w");
+    if (file == NULL)
+    {
+        ROS_ERROR("Could not create %s.", output.c_str());
+        return 1;
+    }
+    fprintf(file, "id,x,y,hits\n");
+    for (size_t i = 0; i < mines.size(); i++)
+    {
+        fprintf(file, "%d,%.4f,%.4f,%d\n", mines[i].id, mines[i].x, mines[i].y, mines[i].hits);
+    }
+    fclose(file);
+
+    size_t frames = 0;
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        frames += chunks[c].frames;
+    }
+    double seconds = (ros::WallTime::now() - start).toSec();
+    ROS_INFO("%zu mines from %zu frames in %zu chunks of %.0f s on %u threads, %.2f s for %.0f s of mission.", mines.size(), frames,
+             chunks.size(), chunkLength, pool.size(), seconds, end - begin);
+    return 0;
+}
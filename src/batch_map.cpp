@@ -0,0 +1,225 @@
+#include "batch_map.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include "frame_source.h"
+#include "mission_log.h"
+#include "thread_pool.h"
+#include "yuv_threshold.h"
+
+using namespace Batch_map;
+
+namespace
+{
+    bool earlierPose(const Pose_history::Stamped_pose &a, const Pose_history::Stamped_pose &b)
+    {
+        return a.stamp < b.stamp;
+    }
+
+    bool earlierSighting(const Sighting &a, const Sighting &b)
+    {
+        return a.stamp < b.stamp;
+    }
+
+    //the bounding boxes of the paper in a frame, found like paper_detection does at its full level on one thread.
+    void findBoxes(const Frame_source::Frame &frame, const Batch_config &config, const Yuv_threshold::Yuv_range &yuvRange,
+                   Thread_pool::thread_Pool &pool, std::vector<cv::Rect> &boundbox)
+    {
+        if (config.classes)
+        {
+            cv::Mat bgr = frame.bgr;
+            if (frame.isYuv)
+            {
+                Paper_vision::yuvToBgr(frame.yuv, bgr);
+            }
+            cv::Mat classes;
+            std::vector<std::vector<Blob_runs::Blob>> blobs;
+            Paper_vision::processClasses(bgr, *config.classes, pool, 1, classes, blobs);
+            for (size_t k = 0; k < blobs.size(); k++)
+            {
+                std::vector<cv::Rect> classBoxes;
+                Paper_vision::blobBoxes(blobs[k], classBoxes);
+                boundbox.insert(boundbox.end(), classBoxes.begin(), classBoxes.end());
+            }
+            return;
+        }
+
+        cv::Mat mask;
+        if (frame.isYuv)
+        {
+            Paper_vision::thresholdYuv(frame.yuv, yuvRange, mask);
+        }
+        else
+        {
+            Paper_vision::thresholdFrame(frame.bgr, config.range, mask);
+        }
+        Paper_vision::filterMask(mask);
+        std::vector<std::vector<cv::Point>> contoursPoly;
+        Paper_vision::findBoundingBoxes(mask, contoursPoly, boundbox);
+    }
+
+    Camera_model::Camera cameraNamed(const Batch_config &config, const std::string &name)
+    {
+        for (size_t i = 0; i < config.names.size() && i < config.cameras.size(); i++)
+        {
+            if (config.names[i] == name)
+            {
+                return config.cameras[i];
+            }
+        }
+        return Camera_model::Camera();
+    }
+} // namespace
+
+bool Batch_map::loadPoses(const std::vector<std::string> &logs, std::vector<Pose_history::Stamped_pose> &poses)
+{
+    poses.clear();
+    for (size_t l = 0; l < logs.size(); l++)
+    {
+        Mission_log::log_Reader reader;
+        if (!reader.open(logs[l]))
+        {
+            return false;
+        }
+        Mission_log::Record record;
+        while (reader.next(record))
+        {
+            if (record.type == Mission_log::RECORD_ODOM)
+            {
+                Pose_history::Stamped_pose pose = {record.stamp, record.odom.x, record.odom.y, record.odom.theta};
+                poses.push_back(pose);
+            }
+        }
+    }
+    std::stable_sort(poses.begin(), poses.end(), earlierPose);
+    return true;
+}
+
+bool Batch_map::poseAt(const std::vector<Pose_history::Stamped_pose> &poses, double stamp, Pose_history::Stamped_pose &pose)
+{
+    Pose_history::Stamped_pose key = {stamp, 0, 0, 0};
+    std::vector<Pose_history::Stamped_pose>::const_iterator after = std::lower_bound(poses.begin(), poses.end(), key, earlierPose);
+    if (after == poses.end())
+    {
+        return false;
+    }
+    if (after->stamp == stamp)
+    {
+        pose = *after;
+        return true;
+    }
+    if (after == poses.begin())
+    {
+        return false;
+    }
+    pose = Pose_history::interpolate(*(after - 1), *after, stamp);
+    return true;
+}
+
+std::vector<Chunk> Batch_map::splitTimeline(double begin, double end, double chunkLength)
+{
+    std::vector<Chunk> chunks;
+    int count = chunkLength > 0 ? std::max(1, int(std::ceil((end - begin) / chunkLength))) : 1;
+    for (int i = 0; i < count; i++)
+    {
+        Chunk chunk;
+        chunk.begin = begin + i * chunkLength;
+        //the last chunk takes the records stamped at the end too.
+        chunk.end = i == count - 1 ? INFINITY : begin + (i + 1) * chunkLength;
+        chunk.frames = 0;
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+bool Batch_map::processChunk(const std::vector<std::string> &logs, const std::vector<Pose_history::Stamped_pose> &poses,
+                             const Batch_config &config, Chunk &chunk)
+{
+    //the YUV colours of the range, built with the first YUV frame.
+    Yuv_threshold::Yuv_range yuvRange;
+    bool yuvBuilt = false;
+    //the chunks are the parallelism, the colour classes run on the calling thread.
+    Thread_pool::thread_Pool pool(1);
+
+    chunk.frames = 0;
+    chunk.sightings.clear();
+    for (size_t l = 0; l < logs.size(); l++)
+    {
+        Mission_log::log_Reader reader;
+        if (!reader.open(logs[l]))
+        {
+            return false;
+        }
+        //a frame is compared with the frame before of the same camera, which may be in the chunk before.
+        std::map<std::string, Paper_vision::mine_Trigger> triggers;
+        reader.seek(chunk.begin - config.overlap);
+        Mission_log::Record record;
+        //the cameras log their frames as they arrive, so a frame of the chunk may come after a later frame of
+        //another camera. reading stops only the overlap past the end.
+        while (reader.next(record) && record.stamp < chunk.end + config.overlap)
+        {
+            if (record.type != Mission_log::RECORD_FRAME || record.stamp >= chunk.end)
+            {
+                continue;
+            }
+            //frames without odometry are skipped, as they are on the robot.
+            Pose_history::Stamped_pose stampedPose;
+            Frame_source::Frame frame;
+            if (!poseAt(poses, record.stamp - config.cameraLatency, stampedPose) || !Frame_source::unpackLogged(record.frame, frame))
+            {
+                continue;
+            }
+
+            if (frame.isYuv && !yuvBuilt && !config.classes)
+            {
+                const Paper_vision::Hsv_range &range = config.range;
+                yuvRange = Yuv_threshold::rangeOfHsv(range.lowH, range.highH, range.lowS, range.highS, range.lowV, range.highV);
+                yuvBuilt = true;
+            }
+            std::vector<cv::Rect> boundbox;
+            findBoxes(frame, config, yuvRange, pool, boundbox);
+            std::map<std::string, Paper_vision::mine_Trigger>::iterator trigger = triggers.find(record.frame.camera);
+            if (trigger == triggers.end())
+            {
+                trigger = triggers.insert(std::make_pair(record.frame.camera, Paper_vision::mine_Trigger(config.surfaceLimit))).first;
+            }
+            std::vector<cv::Rect> mineBoxes;
+            trigger->second.update(boundbox, mineBoxes);
+            //the frames before the chunk only prepare the triggers.
+            if (record.stamp < chunk.begin)
+            {
+                continue;
+            }
+            chunk.frames++;
+
+            Camera_model::Camera camera = cameraNamed(config, record.frame.camera);
+            turtlesim::Pose framePose;
+            framePose.x = stampedPose.x;
+            framePose.y = stampedPose.y;
+            framePose.theta = stampedPose.theta;
+            for (size_t i = 0; i < mineBoxes.size(); i++)
+            {
+                Camera_model::point centerCoord;
+                centerCoord.x = mineBoxes[i].x + (mineBoxes[i].width / 2);
+                centerCoord.y = mineBoxes[i].y + (mineBoxes[i].height / 2);
+                Camera_model::point paperPoint = Camera_model::convertCoordinatesOfPoint(centerCoord, framePose, camera);
+                Sighting sighting = {record.stamp, paperPoint.x, paperPoint.y};
+                chunk.sightings.push_back(sighting);
+            }
+        }
+    }
+    //the sightings of several logs in the order of the timeline.
+    std::stable_sort(chunk.sightings.begin(), chunk.sightings.end(), earlierSighting);
+    return true;
+}
+
+void Batch_map::mergeChunks(const std::vector<Chunk> &chunks, Detection_map::detection_Map &map)
+{
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        for (size_t i = 0; i < chunks[c].sightings.size(); i++)
+        {
+            map.add(chunks[c].sightings[i].x, chunks[c].sightings[i].y);
+        }
+    }
+}
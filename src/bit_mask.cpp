@@ -0,0 +1,275 @@
+#include "bit_mask.h"
+#include <cstring>
+
+using namespace Bit_mask;
+
+namespace
+{
+    //8 bytes of 0 or 255 for each combination of 8 bits.
+    struct Unpack_table
+    {
+        uint64_t bytes[256];
+        Unpack_table()
+        {
+            for (int b = 0; b < 256; b++)
+            {
+                uint64_t value = 0;
+                for (int i = 0; i < 8; i++)
+                {
+                    if (b & (1 << i))
+                    {
+                        value |= uint64_t(0xff) << (8 * i);
+                    }
+                }
+                bytes[b] = value;
+            }
+        }
+    };
+    const Unpack_table unpackTable;
+
+    //the pixels of one row moved by the wide middle rows of the ellipse, 2 * Radius + 1 pixels wide.
+    //outside is the value of the pixels past both ends of the row.
+    template <bool Erode, int Radius>
+    void horizontal(const uint64_t *in, uint64_t *out, int words, uint64_t lastMask, uint64_t outside)
+    {
+        for (int i = 0; i < words; i++)
+        {
+            uint64_t a = in[i];
+            uint64_t previous = i > 0 ? in[i - 1] : outside;
+            uint64_t next = i + 1 < words ? in[i + 1] : outside;
+            //the bits past the width take the outside value.
+            if (i + 1 == words)
+            {
+                a = (a & lastMask) | (outside & ~lastMask);
+            }
+            if (i + 2 == words)
+            {
+                next = (next & lastMask) | (outside & ~lastMask);
+            }
+
+            //pixel x takes x - 1, x - 2 from the lower bits and x + 1, x + 2 from the higher bits.
+            uint64_t left1 = (a << 1) | (previous >> 63);
+            uint64_t right1 = (a >> 1) | (next << 63);
+            if (Radius == 1)
+            {
+                out[i] = Erode ? a & left1 & right1 : a | left1 | right1;
+                continue;
+            }
+            uint64_t left2 = (a << 2) | (previous >> 62);
+            uint64_t right2 = (a >> 2) | (next << 62);
+            out[i] = Erode ? a & left1 & left2 & right1 & right2 : a | left1 | left2 | right1 | right2;
+        }
+    }
+
+    template <bool Erode, int Radius>
+    void morph(const bit_Mask &src, bit_Mask &dst)
+    {
+        dst.create(src.rows, src.cols);
+        int words = src.wordsPerRow;
+        if (words == 0)
+        {
+            return;
+        }
+        uint64_t outside = Erode ? ~uint64_t(0) : 0;
+        int tail = src.cols % 64;
+        uint64_t lastMask = tail ? (uint64_t(1) << tail) - 1 : ~uint64_t(0);
+
+        //rows 1 to 3 of the 5x5 ellipse are 5 wide, rows 0 and 4 only the center pixel.
+        //the 3x3 ellipse is a cross, its middle row is 3 wide, rows 0 and 2 only the center pixel.
+        std::vector<uint64_t> wide(src.words.size());
+        for (int y = 0; y < src.rows; y++)
+        {
+            horizontal<Erode, Radius>(src.row(y), &wide[y * words], words, lastMask, outside);
+        }
+
+        for (int y = 0; y < src.rows; y++)
+        {
+            uint64_t *out = dst.row(y);
+            for (int i = 0; i < words; i++)
+            {
+                uint64_t value = wide[y * words + i];
+                if (Radius == 1)
+                {
+                    uint64_t up = y >= 1 ? src.row(y - 1)[i] : outside;
+                    uint64_t down = y + 1 < src.rows ? src.row(y + 1)[i] : outside;
+                    out[i] = Erode ? value & up & down : value | up | down;
+                    continue;
+                }
+                uint64_t up2 = y >= 2 ? src.row(y - 2)[i] : outside;
+                uint64_t up1 = y >= 1 ? wide[(y - 1) * words + i] : outside;
+                uint64_t down1 = y + 1 < src.rows ? wide[(y + 1) * words + i] : outside;
+                uint64_t down2 = y + 2 < src.rows ? src.row(y + 2)[i] : outside;
+                out[i] = Erode ? value & up2 & up1 & down1 & down2 : value | up2 | up1 | down1 | down2;
+            }
+            out[words - 1] &= lastMask;
+        }
+    }
+} // namespace
+
+void bit_Mask::create(int rows, int cols)
+{
+    this->rows = rows;
+    this->cols = cols;
+    wordsPerRow = (cols + 63) / 64;
+    words.assign(size_t(rows) * wordsPerRow, 0);
+}
+
+void Bit_mask::pack(const uint8_t *data, size_t step, int width, int rowBegin, int rowEnd, bit_Mask &mask)
+{
+    mask.create(rowEnd - rowBegin, width);
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        const uint8_t *in = data + y * step;
+        uint64_t *out = mask.row(y - rowBegin);
+        int x = 0;
+        //8 pixels at a time, the top bits of the 8 bytes are gathered into one byte by the multiplication.
+        for (; x + 8 <= width; x += 8)
+        {
+            uint64_t bytes;
+            memcpy(&bytes, in + x, 8);
+            uint64_t bits = ((bytes & 0x8080808080808080ull) >> 7) * 0x0102040810204080ull >> 56;
+            out[x / 64] |= bits << (x % 64);
+        }
+        for (; x < width; x++)
+        {
+            if (in[x])
+            {
+                out[x / 64] |= uint64_t(1) << (x % 64);
+            }
+        }
+    }
+}
+
+void Bit_mask::packClasses(const uint8_t *data, size_t step, int width, int rowBegin, int rowEnd, int count, bit_Mask *masks)
+{
+    for (int k = 0; k < count; k++)
+    {
+        masks[k].create(rowEnd - rowBegin, width);
+    }
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        const uint8_t *in = data + y * step;
+        int x = 0;
+        //8 pixels at a time, bit k of the 8 bytes is gathered into one byte like in pack.
+        for (; x + 8 <= width; x += 8)
+        {
+            uint64_t bytes;
+            memcpy(&bytes, in + x, 8);
+            if (bytes == 0)
+            {
+                continue;
+            }
+            for (int k = 0; k < count; k++)
+            {
+                uint64_t bits = ((bytes >> k) & 0x0101010101010101ull) * 0x0102040810204080ull >> 56;
+                masks[k].row(y - rowBegin)[x / 64] |= bits << (x % 64);
+            }
+        }
+        for (; x < width; x++)
+        {
+            for (int k = 0; k < count; k++)
+            {
+                if (in[x] & (1 << k))
+                {
+                    masks[k].row(y - rowBegin)[x / 64] |= uint64_t(1) << (x % 64);
+                }
+            }
+        }
+    }
+}
+
+void Bit_mask::unpack(const bit_Mask &mask, int rowBegin, int rowEnd, uint8_t *data, size_t step)
+{
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        const uint64_t *in = mask.row(y);
+        uint8_t *out = data + (y - rowBegin) * step;
+        int x = 0;
+        for (; x + 8 <= mask.cols; x += 8)
+        {
+            memcpy(out + x, &unpackTable.bytes[(in[x / 64] >> (x % 64)) & 0xff], 8);
+        }
+        for (; x < mask.cols; x++)
+        {
+            out[x] = (in[x / 64] >> (x % 64)) & 1 ? 255 : 0;
+        }
+    }
+}
+
+void Bit_mask::erode(const bit_Mask &src, bit_Mask &dst, int radius)
+{
+    if (radius == 1)
+    {
+        morph<true, 1>(src, dst);
+    }
+    else
+    {
+        morph<true, 2>(src, dst);
+    }
+}
+
+void Bit_mask::dilate(const bit_Mask &src, bit_Mask &dst, int radius)
+{
+    if (radius == 1)
+    {
+        morph<false, 1>(src, dst);
+    }
+    else
+    {
+        morph<false, 2>(src, dst);
+    }
+}
+
+void Bit_mask::filter(bit_Mask &mask, int radius)
+{
+    bit_Mask other;
+
+    //Morphological opening (removes small objects from the foreground).
+    erode(mask, other, radius);
+    dilate(other, mask, radius);
+
+    //Morphological closing (removes small holes from the foreground).
+    dilate(mask, other, radius);
+    erode(other, mask, radius);
+}
+
+void Bit_mask::extractRuns(const bit_Mask &mask, int rowBegin, int rowEnd, int rowOffset, std::vector<Blob_runs::Run> &runs)
+{
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        const uint64_t *in = mask.row(y);
+        //a run may continue over word borders, start is -1 while outside a run.
+        int start = -1;
+        for (int i = 0; i < mask.wordsPerRow; i++)
+        {
+            uint64_t word = in[i];
+            int base = i * 64;
+            int bit = 0;
+            while (bit < 64)
+            {
+                //the next change between background and foreground.
+                uint64_t rest = (start < 0 ? word : ~word) >> bit;
+                if (rest == 0)
+                {
+                    break;
+                }
+                bit += __builtin_ctzll(rest);
+                if (start < 0)
+                {
+                    start = base + bit;
+                }
+                else
+                {
+                    Blob_runs::Run run = {y + rowOffset, start, base + bit};
+                    runs.push_back(run);
+                    start = -1;
+                }
+            }
+        }
+        if (start >= 0)
+        {
+            Blob_runs::Run run = {y + rowOffset, start, mask.cols};
+            runs.push_back(run);
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#include "blob_runs.h"
+
+using namespace Blob_runs;
+
+namespace
+{
+    int findRoot(std::vector<int> &parent, int i)
+    {
+        while (parent[i] != i)
+        {
+            //path halving.
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite(std::vector<int> &parent, int a, int b)
+    {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        //keep the smaller index as root, so the root is the first run of the blob.
+        if (a < b)
+        {
+            parent[b] = a;
+        }
+        else if (b < a)
+        {
+            parent[a] = b;
+        }
+    }
+
+    //8-connected runs overlap when widened by one pixel.
+    bool touches(const Run &a, const Run &b)
+    {
+        return a.start <= b.end && b.start <= a.end;
+    }
+
+    //unite the 8-connected runs of two neighbouring rows, both sorted by start.
+    //offsets map the run indices into parent.
+    void connectRows(const std::vector<Run> &upper, size_t upperBegin, size_t upperEnd, int upperOffset,
+                     const std::vector<Run> &lower, size_t lowerBegin, size_t lowerEnd, int lowerOffset,
+                     std::vector<int> &parent)
+    {
+        size_t u = upperBegin;
+        size_t l = lowerBegin;
+        while (u < upperEnd && l < lowerEnd)
+        {
+            if (touches(upper[u], lower[l]))
+            {
+                unite(parent, upperOffset + u, lowerOffset + l);
+            }
+            //advance the run that ends first, the other may still touch the next one.
+            if (upper[u].end < lower[l].end)
+            {
+                u++;
+            }
+            else
+            {
+                l++;
+            }
+        }
+    }
+} // namespace
+
+void Blob_runs::extractRuns(const uint8_t *data, size_t step, int width, int rowBegin, int rowEnd, std::vector<Run> &runs)
+{
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        const uint8_t *row = data + y * step;
+        int x = 0;
+        while (x < width)
+        {
+            //skip background.
+            while (x < width && row[x] == 0)
+            {
+                x++;
+            }
+            if (x == width)
+            {
+                break;
+            }
+            int start = x;
+            while (x < width && row[x] != 0)
+            {
+                x++;
+            }
+            Run run = {y, start, x};
+            runs.push_back(run);
+        }
+    }
+}
+
+void Blob_runs::connectRuns(const std::vector<Run> &runs, std::vector<int> &parent)
+{
+    parent.resize(runs.size());
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        parent[i] = i;
+    }
+
+    //[previousBegin, rowBegin) are the runs of the previous row, [rowBegin, rowEnd) the runs of the current row.
+    size_t previousBegin = 0;
+    size_t rowBegin = 0;
+    while (rowBegin < runs.size())
+    {
+        size_t rowEnd = rowBegin;
+        while (rowEnd < runs.size() && runs[rowEnd].row == runs[rowBegin].row)
+        {
+            rowEnd++;
+        }
+        if (rowBegin > 0 && runs[rowBegin - 1].row == runs[rowBegin].row - 1)
+        {
+            connectRows(runs, previousBegin, rowBegin, 0, runs, rowBegin, rowEnd, 0, parent);
+        }
+        previousBegin = rowBegin;
+        rowBegin = rowEnd;
+    }
+}
+
+void Blob_runs::mergeBands(const std::vector<std::vector<Run>> &bands, const std::vector<std::vector<int>> &parents, std::vector<Blob> &blobs)
+{
+    //join the per band union-find forests into one.
+    std::vector<int> offsets(bands.size() + 1, 0);
+    for (size_t b = 0; b < bands.size(); b++)
+    {
+        offsets[b + 1] = offsets[b] + bands[b].size();
+    }
+    std::vector<int> parent(offsets.back());
+    for (size_t b = 0; b < bands.size(); b++)
+    {
+        for (size_t i = 0; i < bands[b].size(); i++)
+        {
+            parent[offsets[b] + i] = offsets[b] + parents[b][i];
+        }
+    }
+
+    //connect the last row of every band with the first row of the next band.
+    for (size_t b = 0; b + 1 < bands.size(); b++)
+    {
+        const std::vector<Run> &upper = bands[b];
+        const std::vector<Run> &lower = bands[b + 1];
+        if (upper.empty() || lower.empty() || upper.back().row + 1 != lower.front().row)
+        {
+            continue;
+        }
+        size_t upperBegin = upper.size();
+        while (upperBegin > 0 && upper[upperBegin - 1].row == upper.back().row)
+        {
+            upperBegin--;
+        }
+        size_t lowerEnd = 0;
+        while (lowerEnd < lower.size() && lower[lowerEnd].row == lower.front().row)
+        {
+            lowerEnd++;
+        }
+        connectRows(upper, upperBegin, upper.size(), offsets[b], lower, 0, lowerEnd, offsets[b + 1], parent);
+    }
+
+    //collect the bounds of every blob, in the order of their root runs.
+    blobs.clear();
+    std::vector<int> blobOf(parent.size(), -1);
+    for (size_t b = 0; b < bands.size(); b++)
+    {
+        for (size_t i = 0; i < bands[b].size(); i++)
+        {
+            const Run &run = bands[b][i];
+            int root = findRoot(parent, offsets[b] + i);
+            if (blobOf[root] < 0)
+            {
+                blobOf[root] = blobs.size();
+                Blob blob = {run.start, run.row, run.end - 1, run.row, 0};
+                blobs.push_back(blob);
+            }
+            Blob &blob = blobs[blobOf[root]];
+            blob.minX = run.start < blob.minX ? run.start : blob.minX;
+            blob.maxX = run.end - 1 > blob.maxX ? run.end - 1 : blob.maxX;
+            blob.minY = run.row < blob.minY ? run.row : blob.minY;
+            blob.maxY = run.row > blob.maxY ? run.row : blob.maxY;
+            blob.area += run.end - run.start;
+        }
+    }
+}
@@ -0,0 +1,247 @@
+#include "camera_model.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace Camera_model;
+
+double Camera_model::getTheta(double angle)
+{
+    //If theta is negative it is converted to the corresponding positive angle (Theta becomes negative when the turtle rotates clockwise).
+    double theta = angle < 0 ? angle + 2 * M_PI : angle;
+    //cout << "Got theta: " << theta << endl;
+    return theta;
+}
+
+//Converts degrees to radians.
+double Camera_model::degreesToRadians(double angleDegrees)
+{
+    return angleDegrees * M_PI / 180;
+}
+
+//Converts a pioint from pixels to meters, based on the ratio between side length and number of pixels.
+point Camera_model::pixelsToMeters(point coordInPixels, double length, int imageWidth)
+{
+    point coordInMeters;
+    coordInMeters.x = coordInPixels.x * (length / imageWidth);
+    coordInMeters.y = coordInPixels.y * (length / imageWidth);
+    return coordInMeters;
+}
+
+//Rotates a vector by a given angle.
+point Camera_model::rotatePointByAngle(double angle, point coord)
+{
+    point rotatedPoint;
+    rotatedPoint.x = coord.x * cos(angle - M_PI_2) + coord.y * (-sin(angle - M_PI_2));
+    rotatedPoint.y = coord.x * sin(angle - M_PI_2) + coord.y * cos(angle - M_PI_2);
+    return rotatedPoint;
+}
+
+void Camera_model::groundFootprint(const Camera &camera, double &length, double &width)
+{
+    //The following determines the measurements (length and width) of the area that the camera projects.
+    double halfFOV = degreesToRadians(camera.fov / 2);
+    double B = M_PI - M_PI_2 - halfFOV;
+    double a = (camera.height / sin(B)) * sin(halfFOV);
+    double alpha = atan2(camera.imageHeight, camera.imageWidth);
+
+    length = 2 * cos(alpha) * a;
+    width = 2 * sin(alpha) * a;
+}
+
+point Camera_model::convertCoordinatesOfPoint(point Coord, turtlesim::Pose pose, const Camera &camera)
+{
+    double length;
+    double width;
+    groundFootprint(camera, length, width);
+    //std::cout << "Dimensions: " << length << " ; " << width << "\n";
+
+    //The coordinates of the found point in pixels.
+    point coordInPixel; //Use the coordinates that will be published, the current values are for testing only.
+    coordInPixel.x = Coord.x;
+    coordInPixel.y = Coord.y;
+
+    //Converts the point's coordinates from pixels to meters using the pixelsToMeters function.
+    point coordInMeters = pixelsToMeters(coordInPixel, length, camera.imageWidth);
+
+    //Since the camera determines the coordinates of the point using the y-axis going downwards. The y-axis is reverted by adding a negative sign.
+    coordInMeters.y = -coordInMeters.y;
+
+    //The vector of the area projected by the camera from Origo to the center of the area/camera.
+    point camOrigoToCamCenter;
+    camOrigoToCamCenter.x = 1.0 / 2.0 * length;
+    camOrigoToCamCenter.y = -1.0 / 2.0 * width;
+    //std::cout << "camOrigoToCamCenter: " << camOrigoToCamCenter.x << " ; " << camOrigoToCamCenter.y << "\n";
+
+    //The vector of the found point from the center of the camera area (in meters).
+    point coordInMetersToCamCenter;
+    coordInMetersToCamCenter.x = coordInMeters.x - camOrigoToCamCenter.x;
+    coordInMetersToCamCenter.y = coordInMeters.y - camOrigoToCamCenter.y;
+
+    //Rotate by the mounting angle of the camera, and shift by the vector from the center of the robot to the middle of the camera.
+    //This is done to shift the coodinate-system of the camera to a coodinate-system with Origo in the robot's centre.
+    point camCenterRotated = rotatePointByAngle(camera.yaw + M_PI_2, coordInMetersToCamCenter);
+    point coordInMetersToRobotOrigo;
+    coordInMetersToRobotOrigo.x = camCenterRotated.x + camera.lateral;
+    coordInMetersToRobotOrigo.y = camCenterRotated.y + camera.forward;
+    //std::cout << "coordInMetersToRobotOrigo: " << coordInMetersToRobotOrigo.x << " ; " << coordInMetersToRobotOrigo.y << "\n";
+
+    //The found point is rotated to fit with the robots coodinate-system.
+    //It is then rotated with the current angle of the robot measured from the x-axis to determine the correct position of the point compared to the robot.
+    point rotatedPoint = rotatePointByAngle(getTheta(pose.theta), coordInMetersToRobotOrigo); // if the first argument for rotatePointByAngle is not
+    // getTheta(pose.theta) then it is in test-mode
+    //std::cout << "RotatedPoint: " << rotatedPoint.x << " ; " << rotatedPoint.y << "\n";
+
+    //The coordinates of the found paper from the robots Origin point.
+    //Determined from the coordinates of the robot from its Origin + the vector from the robot centre to the found point.
+
+    point paperPoint;
+    paperPoint.x = pose.x + rotatedPoint.x; //pose.x
+    paperPoint.y = pose.y + rotatedPoint.y; //pose.y
+    return paperPoint;
+}
+
+point Camera_model::pixelOfPoint(point odomPoint, turtlesim::Pose pose, const Camera &camera)
+{
+    double length;
+    double width;
+    groundFootprint(camera, length, width);
+
+    //The vector from the robot centre to the point, in the robot's coordinate-system.
+    //rotatePointByAngle rotates by the angle minus 90 degrees, so each rotation of convertCoordinatesOfPoint is undone
+    //by passing 180 degrees minus its angle.
+    point toPoint;
+    toPoint.x = odomPoint.x - pose.x;
+    toPoint.y = odomPoint.y - pose.y;
+    point coordInMetersToRobotOrigo = rotatePointByAngle(M_PI - getTheta(pose.theta), toPoint);
+
+    //Undo the mounting of the camera.
+    point camCenterRotated;
+    camCenterRotated.x = coordInMetersToRobotOrigo.x - camera.lateral;
+    camCenterRotated.y = coordInMetersToRobotOrigo.y - camera.forward;
+    point coordInMetersToCamCenter = rotatePointByAngle(M_PI - (camera.yaw + M_PI_2), camCenterRotated);
+
+    //From the center of the camera area to its corner, with the y-axis of the image going downwards.
+    point coordInPixel;
+    coordInPixel.x = (coordInMetersToCamCenter.x + 1.0 / 2.0 * length) * (camera.imageWidth / length);
+    coordInPixel.y = -(coordInMetersToCamCenter.y - 1.0 / 2.0 * width) * (camera.imageWidth / length);
+    return coordInPixel;
+}
+
+double Camera_model::footprintShift(const Camera &camera, turtlesim::Pose from, turtlesim::Pose to)
+{
+    //the footprint is a rigid rectangle, so its corners move the most.
+    double corners[4][2] = {{0, 0}, {double(camera.imageWidth), 0}, {0, double(camera.imageHeight)}, {double(camera.imageWidth), double(camera.imageHeight)}};
+    double shift = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        point corner;
+        corner.x = corners[i][0];
+        corner.y = corners[i][1];
+        point a = convertCoordinatesOfPoint(corner, from, camera);
+        point b = convertCoordinatesOfPoint(corner, to, camera);
+        shift = std::max(shift, std::hypot(b.x - a.x, b.y - a.y));
+    }
+    return shift;
+}
+
+namespace
+{
+    //read a number from a camera entry.
+    double cameraNumber(XmlRpc::XmlRpcValue &entry, const char *key, double fallback)
+    {
+        if (!entry.hasMember(key))
+        {
+            return fallback;
+        }
+        XmlRpc::XmlRpcValue &value = entry[key];
+        if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+        {
+            return int(value);
+        }
+        return double(value);
+    }
+} // namespace
+
+Camera Camera_model::cameraOfEntry(XmlRpc::XmlRpcValue &entry)
+{
+    Camera defaults;
+    Camera camera;
+    camera.fov = cameraNumber(entry, "fov", defaults.fov);
+    camera.height = cameraNumber(entry, "mount_height", defaults.height);
+    camera.forward = cameraNumber(entry, "forward", defaults.forward);
+    camera.lateral = cameraNumber(entry, "lateral", defaults.lateral);
+    camera.yaw = cameraNumber(entry, "yaw", defaults.yaw);
+    camera.imageWidth = cameraNumber(entry, "image_width", defaults.imageWidth);
+    camera.imageHeight = cameraNumber(entry, "image_height", defaults.imageHeight);
+    return camera;
+}
+
+std::vector<Camera> Camera_model::loadCameras(const ros::NodeHandle &node, const std::string &param, std::vector<std::string> *names)
+{
+    std::vector<Camera> cameras;
+    XmlRpc::XmlRpcValue list;
+    if (!node.getParam(param, list) || list.getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+        cameras.push_back(Camera());
+        if (names)
+        {
+            names->assign(1, "0");
+        }
+        return cameras;
+    }
+    for (int i = 0; i < list.size(); i++)
+    {
+        cameras.push_back(cameraOfEntry(list[i]));
+        if (names)
+        {
+            //named like paper_detection names its cameras, by the source without a name.
+            XmlRpc::XmlRpcValue &entry = list[i];
+            std::string name = std::to_string(i);
+            if (entry.hasMember("name"))
+            {
+                name = std::string(entry["name"]);
+            }
+            else if (entry.hasMember("source"))
+            {
+                XmlRpc::XmlRpcValue &value = entry["source"];
+                name = value.getType() == XmlRpc::XmlRpcValue::TypeInt ? std::to_string(int(value)) : std::string(value);
+            }
+            names->push_back(name);
+        }
+    }
+    return cameras;
+}
+
+bool Camera_model::lateralSwath(const std::vector<Camera> &cameras, double &left, double &right)
+{
+    //the extent of every ground area along the x axis of the robot, the area is a rectangle turned by the yaw.
+    std::vector<std::pair<double, double>> strips;
+    for (size_t i = 0; i < cameras.size(); i++)
+    {
+        double length;
+        double width;
+        groundFootprint(cameras[i], length, width);
+        double half = (length * std::fabs(cos(cameras[i].yaw)) + width * std::fabs(sin(cameras[i].yaw))) / 2;
+        strips.push_back(std::make_pair(cameras[i].lateral - half, cameras[i].lateral + half));
+    }
+    std::sort(strips.begin(), strips.end());
+
+    //merge the strips that touch, and keep the merged strip over the center.
+    for (size_t i = 0; i < strips.size();)
+    {
+        double low = strips[i].first;
+        double high = strips[i].second;
+        for (i++; i < strips.size() && strips[i].first <= high; i++)
+        {
+            high = std::max(high, strips[i].second);
+        }
+        if (low < 0 && high > 0)
+        {
+            left = -low;
+            right = high;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,158 @@
+#include "colour_lut.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Colour_lut;
+
+void Colour_lut::bgrToHsv(int b, int g, int r, int hsv[3])
+{
+    int v = std::max(b, std::max(g, r));
+    int diff = v - std::min(b, std::min(g, r));
+    double h = 0;
+    if (diff > 0)
+    {
+        if (v == r)
+        {
+            h = 60.0 * (g - b) / diff;
+        }
+        else if (v == g)
+        {
+            h = 120.0 + 60.0 * (b - r) / diff;
+        }
+        else
+        {
+            h = 240.0 + 60.0 * (r - g) / diff;
+        }
+        if (h < 0)
+        {
+            h += 360;
+        }
+    }
+    //hue in steps of 2 degrees, 180 is red again.
+    hsv[0] = int(std::lround(h / 2)) % 180;
+    hsv[1] = v == 0 ? 0 : int(std::lround(255.0 * diff / v));
+    hsv[2] = v;
+}
+
+bool Colour_class::contains(int b, int g, int r) const
+{
+    int value[3] = {b, g, r};
+    if (hsv)
+    {
+        bgrToHsv(b, g, r, value);
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        bool inside = value[c] >= low[c] && value[c] <= high[c];
+        //a hue box wrapping around red.
+        if (hsv && c == 0 && low[0] > high[0])
+        {
+            inside = value[0] >= low[0] || value[0] <= high[0];
+        }
+        if (!inside)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+colour_Table::colour_Table(int bits) : bits(std::max(1, std::min(bits, 8))), shift(8 - this->bits)
+{
+}
+
+bool colour_Table::compile(const std::vector<Colour_class> &classes)
+{
+    if (classes.size() > size_t(max_classes))
+    {
+        return false;
+    }
+    compiled = classes;
+
+    int levels = 1 << bits;
+    //the center of a cell, cells of a single level are that level.
+    int center = shift > 0 ? 1 << (shift - 1) : 0;
+    table.assign(size_t(1) << (3 * bits), 0);
+    for (int b = 0; b < levels; b++)
+    {
+        for (int g = 0; g < levels; g++)
+        {
+            for (int r = 0; r < levels; r++)
+            {
+                uint8_t mask = 0;
+                for (size_t k = 0; k < classes.size(); k++)
+                {
+                    if (classes[k].contains((b << shift) + center, (g << shift) + center, (r << shift) + center))
+                    {
+                        mask |= 1 << k;
+                    }
+                }
+                table[(b << (2 * bits)) | (g << bits) | r] = mask;
+            }
+        }
+    }
+    return true;
+}
+
+void colour_Table::classify(const uint8_t *bgr, size_t step, int width, int rowBegin, int rowEnd, uint8_t *out, size_t outStep) const
+{
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        const uint8_t *in = bgr + y * step;
+        uint8_t *classes = out + (y - rowBegin) * outStep;
+        for (int x = 0; x < width; x++)
+        {
+            classes[x] = lookup(in[3 * x], in[3 * x + 1], in[3 * x + 2]);
+        }
+    }
+}
+
+bool Colour_lut::loadClasses(const ros::NodeHandle &node, colour_Table &table)
+{
+    XmlRpc::XmlRpcValue list;
+    if (!node.getParam("colour_classes", list) || list.getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+        return false;
+    }
+
+    std::vector<Colour_class> classes;
+    for (int i = 0; i < list.size(); i++)
+    {
+        XmlRpc::XmlRpcValue &entry = list[i];
+        Colour_class colourClass;
+        colourClass.name = entry.hasMember("name") ? std::string(entry["name"]) : std::to_string(i);
+        colourClass.hsv = entry.hasMember("hsv");
+        if (!colourClass.hsv && !entry.hasMember("bgr"))
+        {
+            ROS_ERROR("Colour class %s has no hsv or bgr box.", colourClass.name.c_str());
+            continue;
+        }
+        XmlRpc::XmlRpcValue &box = entry[colourClass.hsv ? "hsv" : "bgr"];
+        if (box.getType() != XmlRpc::XmlRpcValue::TypeArray || box.size() != 6)
+        {
+            ROS_ERROR("The box of colour class %s needs 6 values.", colourClass.name.c_str());
+            continue;
+        }
+        for (int c = 0; c < 6; c++)
+        {
+            XmlRpc::XmlRpcValue &value = box[c];
+            int level = value.getType() == XmlRpc::XmlRpcValue::TypeInt ? int(value) : int(double(value));
+            (c % 2 == 0 ? colourClass.low : colourClass.high)[c / 2] = level;
+        }
+        classes.push_back(colourClass);
+    }
+
+    //without a class the table would never find a mine, the colour range is used instead.
+    if (classes.empty())
+    {
+        ROS_ERROR("No valid colour class, detecting by the colour range.");
+        return false;
+    }
+    if (!table.compile(classes))
+    {
+        ROS_ERROR("At most %d colour classes are supported.", max_classes);
+        return false;
+    }
+    ROS_INFO("Classifying frames by %zu colour classes.", classes.size());
+    return true;
+}
@@ -0,0 +1,201 @@
+#include "coverage_map.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Coverage_map;
+
+coverage_Map::coverage_Map(double minX, double minY, double maxX, double maxY, double resolution)
+    : minX(minX), minY(minY), resolution(resolution), changedBegin(0), changedEnd(0)
+{
+    cells.create(std::max(1, int(std::ceil((maxY - minY) / resolution))), std::max(1, int(std::ceil((maxX - minX) / resolution))));
+}
+
+bool coverage_Map::span(double x0, double x1, int &begin, int &end) const
+{
+    //cell c has its center at minX + (c + 0.5) * resolution.
+    begin = std::max(0, int(std::ceil((x0 - minX) / resolution - 0.5)));
+    end = std::min(cells.cols, int(std::floor((x1 - minX) / resolution - 0.5)) + 1);
+    return begin < end;
+}
+
+void coverage_Map::markChanged(int row)
+{
+    if (changedBegin == changedEnd)
+    {
+        changedBegin = row;
+        changedEnd = row + 1;
+    }
+    changedBegin = std::min(changedBegin, row);
+    changedEnd = std::max(changedEnd, row + 1);
+}
+
+void coverage_Map::markSpan(int row, int begin, int end)
+{
+    markChanged(row);
+
+    uint64_t *words = cells.row(row);
+    for (int word = begin / 64; word <= (end - 1) / 64; word++)
+    {
+        int from = std::max(begin - word * 64, 0);
+        int to = std::min(end - word * 64, 64);
+        uint64_t bits = to == 64 ? ~uint64_t(0) : (uint64_t(1) << to) - 1;
+        words[word] |= bits & ~((uint64_t(1) << from) - 1);
+    }
+}
+
+void coverage_Map::markDisk(double x, double y, double r)
+{
+    int rowBegin = std::max(0, int(std::ceil((y - r - minY) / resolution - 0.5)));
+    int rowEnd = std::min(cells.rows, int(std::floor((y + r - minY) / resolution - 0.5)) + 1);
+    for (int row = rowBegin; row < rowEnd; row++)
+    {
+        double dy = minY + (row + 0.5) * resolution - y;
+        double halfWidth = std::sqrt(std::max(0.0, r * r - dy * dy));
+        int begin;
+        int end;
+        if (span(x - halfWidth, x + halfWidth, begin, end))
+        {
+            markSpan(row, begin, end);
+        }
+    }
+}
+
+void coverage_Map::markSwept(double x0, double y0, double x1, double y1, double r)
+{
+    markDisk(x0, y0, r);
+    markDisk(x1, y1, r);
+
+    double length = std::hypot(x1 - x0, y1 - y0);
+    if (length == 0)
+    {
+        return;
+    }
+    //the rectangle between the two disks.
+    double nx = -(y1 - y0) / length * r;
+    double ny = (x1 - x0) / length * r;
+    std::vector<Camera_model::point> corners(4);
+    corners[0].x = x0 + nx;
+    corners[0].y = y0 + ny;
+    corners[1].x = x1 + nx;
+    corners[1].y = y1 + ny;
+    corners[2].x = x1 - nx;
+    corners[2].y = y1 - ny;
+    corners[3].x = x0 - nx;
+    corners[3].y = y0 - ny;
+    markPolygon(corners);
+}
+
+void coverage_Map::markPolygon(const std::vector<Camera_model::point> &corners)
+{
+    double low = corners[0].y;
+    double high = corners[0].y;
+    for (size_t i = 1; i < corners.size(); i++)
+    {
+        low = std::min(low, corners[i].y);
+        high = std::max(high, corners[i].y);
+    }
+
+    int rowBegin = std::max(0, int(std::ceil((low - minY) / resolution - 0.5)));
+    int rowEnd = std::min(cells.rows, int(std::floor((high - minY) / resolution - 0.5)) + 1);
+    for (int row = rowBegin; row < rowEnd; row++)
+    {
+        //a convex polygon crosses the row center line in one interval, between its edge crossings.
+        double y = minY + (row + 0.5) * resolution;
+        double x0 = INFINITY;
+        double x1 = -INFINITY;
+        for (size_t i = 0; i < corners.size(); i++)
+        {
+            const Camera_model::point &a = corners[i];
+            const Camera_model::point &b = corners[(i + 1) % corners.size()];
+            if (a.y == b.y && a.y == y)
+            {
+                //an edge along the center line.
+                x0 = std::min(x0, std::min(a.x, b.x));
+                x1 = std::max(x1, std::max(a.x, b.x));
+            }
+            else if ((a.y <= y && y <= b.y) || (b.y <= y && y <= a.y))
+            {
+                double x = a.x + (y - a.y) / (b.y - a.y) * (b.x - a.x);
+                x0 = std::min(x0, x);
+                x1 = std::max(x1, x);
+            }
+        }
+        int begin;
+        int end;
+        if (x0 <= x1 && span(x0, x1, begin, end))
+        {
+            markSpan(row, begin, end);
+        }
+    }
+}
+
+double coverage_Map::diskCoverage(double x, double y, double r) const
+{
+    long total = 0;
+    long covered = 0;
+    int rowBegin = std::max(0, int(std::ceil((y - r - minY) / resolution - 0.5)));
+    int rowEnd = std::min(cells.rows, int(std::floor((y + r - minY) / resolution - 0.5)) + 1);
+    for (int row = rowBegin; row < rowEnd; row++)
+    {
+        double dy = minY + (row + 0.5) * resolution - y;
+        double halfWidth = std::sqrt(std::max(0.0, r * r - dy * dy));
+        int begin;
+        int end;
+        if (!span(x - halfWidth, x + halfWidth, begin, end))
+        {
+            continue;
+        }
+        total += end - begin;
+        const uint64_t *words = cells.row(row);
+        for (int word = begin / 64; word <= (end - 1) / 64; word++)
+        {
+            int from = std::max(begin - word * 64, 0);
+            int to = std::min(end - word * 64, 64);
+            uint64_t bits = to == 64 ? ~uint64_t(0) : (uint64_t(1) << to) - 1;
+            covered += __builtin_popcountll(words[word] & bits & ~((uint64_t(1) << from) - 1));
+        }
+    }
+    return total ? double(covered) / total : 1.0;
+}
+
+double coverage_Map::coverage() const
+{
+    long covered = 0;
+    for (size_t i = 0; i < cells.words.size(); i++)
+    {
+        covered += __builtin_popcountll(cells.words[i]);
+    }
+    return double(covered) / (double(cells.rows) * cells.cols);
+}
+
+bool coverage_Map::merge(int rows, int cols, const std::vector<uint64_t> &words)
+{
+    if (rows != cells.rows || cols != cells.cols || words.size() != cells.words.size())
+    {
+        return false;
+    }
+    //the rows gaining cells are saved like the rows marked here, so a resumed mission keeps the fleet's coverage.
+    for (int row = 0; row < rows; row++)
+    {
+        uint64_t *own = cells.row(row);
+        const uint64_t *other = &words[row * cells.wordsPerRow];
+        bool gained = false;
+        for (int w = 0; w < cells.wordsPerRow; w++)
+        {
+            gained |= (other[w] & ~own[w]) != 0;
+            own[w] |= other[w];
+        }
+        if (gained)
+        {
+            markChanged(row);
+        }
+    }
+    return true;
+}
+
+void coverage_Map::takeChanged(int &begin, int &end)
+{
+    begin = changedBegin;
+    end = changedEnd;
+    changedBegin = changedEnd = 0;
+}
@@ -0,0 +1,133 @@
+#include "depth_scan.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Depth_scan;
+using Obstacle_avoidance::Obstacle_Point;
+
+namespace
+{
+    const uint16_t noDepthMm = std::numeric_limits<uint16_t>::max();
+
+    //keep the nearest depth of every column that is in [near, far]. written without branches, so the compiler
+    //vectorizes it, and no depth, 0 or NaN, is never in the band.
+    template <typename Depth>
+    void nearestInBand(const Depth *row, int width, Depth near, Depth far, Depth *nearest)
+    {
+        for (int c = 0; c < width; c++)
+        {
+            Depth depth = row[c];
+            bool closer = depth >= near && depth <= far && depth < nearest[c];
+            nearest[c] = closer ? depth : nearest[c];
+        }
+    }
+} // namespace
+
+void depth_Projector::configure(const Depth_camera &camera)
+{
+    config = camera;
+    slope.resize(camera.width);
+    for (int c = 0; c < camera.width; c++)
+    {
+        //columns right of the center are to the right of the robot, at negative y.
+        slope[c] = -(c - camera.cx) / camera.fx;
+    }
+
+    //a point at depth z in row r is z * (r - cy) / fy below the camera, so its height is in the band for the depths
+    //where z * (r - cy) / fy is in [mountHeight - maxHeight, mountHeight - minHeight].
+    double low = camera.mountHeight - camera.maxHeight;
+    double high = camera.mountHeight - camera.minHeight;
+    nearRow.resize(camera.height);
+    farRow.resize(camera.height);
+    nearRowMm.resize(camera.height);
+    farRowMm.resize(camera.height);
+    for (int r = 0; r < camera.height; r++)
+    {
+        double down = (r - camera.cy) / camera.fy;
+        double near = 0;
+        double far = camera.maxRange;
+        if (down > 0)
+        {
+            near = std::max(near, low / down);
+            far = std::min(far, high / down);
+        }
+        else if (down < 0)
+        {
+            near = std::max(near, high / down);
+            far = std::min(far, low / down);
+        }
+        else if (low > 0 || high < 0)
+        {
+            far = -1;
+        }
+
+        if (near > far)
+        {
+            nearRow[r] = 1;
+            farRow[r] = 0;
+            nearRowMm[r] = 1;
+            farRowMm[r] = 0;
+            continue;
+        }
+        nearRow[r] = near;
+        farRow[r] = far;
+        //0 is no depth in millimeters.
+        nearRowMm[r] = std::max(1.0, std::ceil(near * 1000));
+        farRowMm[r] = std::min(noDepthMm - 1.0, std::floor(far * 1000));
+    }
+}
+
+void depth_Projector::project(const uint16_t *data, size_t step, std::vector<Obstacle_Point> &points)
+{
+    nearestMm.assign(config.width, noDepthMm);
+    for (int r = 0; r < config.height; r++)
+    {
+        if (nearRowMm[r] <= farRowMm[r])
+        {
+            const uint16_t *row = reinterpret_cast<const uint16_t *>(reinterpret_cast<const uint8_t *>(data) + r * step);
+            nearestInBand(row, config.width, nearRowMm[r], farRowMm[r], nearestMm.data());
+        }
+    }
+
+    nearest.resize(config.width);
+    for (int c = 0; c < config.width; c++)
+    {
+        nearest[c] = nearestMm[c] == noDepthMm ? std::numeric_limits<float>::infinity() : nearestMm[c] * 0.001f;
+    }
+    columnPoints(points);
+}
+
+void depth_Projector::project(const float *data, size_t step, std::vector<Obstacle_Point> &points)
+{
+    nearest.assign(config.width, std::numeric_limits<float>::infinity());
+    for (int r = 0; r < config.height; r++)
+    {
+        if (nearRow[r] <= farRow[r])
+        {
+            const float *row = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(data) + r * step);
+            nearestInBand(row, config.width, nearRow[r], farRow[r], nearest.data());
+        }
+    }
+    columnPoints(points);
+}
+
+void depth_Projector::columnPoints(std::vector<Obstacle_Point> &points) const
+{
+    //from the right to the left, in the order of the angles of a scan.
+    points.clear();
+    for (int c = config.width - 1; c >= 0; c--)
+    {
+        if (std::isinf(nearest[c]))
+        {
+            continue;
+        }
+        Obstacle_Point p;
+        p.x = nearest[c];
+        p.y = nearest[c] * slope[c];
+        if (p.x * p.x + p.y * p.y < config.maxRange * config.maxRange)
+        {
+            points.push_back(p);
+        }
+    }
+}
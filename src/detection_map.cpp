@@ -0,0 +1,54 @@
+#include "detection_map.h"
+
+using namespace Detection_map;
+
+detection_Map::detection_Map(double merge_radius)
+    : merge_radius(merge_radius)
+{
+}
+
+Detection detection_Map::add(double x, double y)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    //merge with the closest detection within the merge radius.
+    int closest = -1;
+    double closest_distance = merge_radius * merge_radius;
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        double dx = list[i].x - x;
+        double dy = list[i].y - y;
+        double distance = dx * dx + dy * dy;
+        if (distance <= closest_distance)
+        {
+            closest = i;
+            closest_distance = distance;
+        }
+    }
+
+    if (closest < 0)
+    {
+        Detection detection = {int(list.size()), x, y, 1};
+        list.push_back(detection);
+        return detection;
+    }
+
+    //running average of the merged positions.
+    Detection &detection = list[closest];
+    detection.hits++;
+    detection.x += (x - detection.x) / detection.hits;
+    detection.y += (y - detection.y) / detection.hits;
+    return detection;
+}
+
+std::vector<Detection> detection_Map::detections() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return list;
+}
+
+void detection_Map::restore(const std::vector<Detection> &detections)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    list = detections;
+}
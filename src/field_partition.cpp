@@ -0,0 +1,65 @@
+#include "field_partition.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Field_partition;
+
+std::vector<Region> Field_partition::partitionLanes(int lanes, double laneSpacing, double width, double margin, const std::vector<Start> &starts)
+{
+    int robots = starts.size();
+    std::vector<Region> regions(robots);
+    if (robots == 0)
+    {
+        return regions;
+    }
+
+    //robots in order of their start along the field.
+    std::vector<int> byX(robots);
+    for (int r = 0; r < robots; r++)
+    {
+        byX[r] = r;
+    }
+    std::stable_sort(byX.begin(), byX.end(), [&](int a, int b) { return starts[a].x < starts[b].x; });
+
+    double laneLength = width - 2 * margin;
+    //cost of the k-th robot along the field driving the lanes [first, last].
+    auto cost = [&](int k, int first, int last) {
+        if (first > last)
+        {
+            return 0.0;
+        }
+        const Start &start = starts[byX[k]];
+        double x = laneSpacing / 2 + first * laneSpacing;
+        return (last - first + 1) * laneLength + (last - first) * laneSpacing + std::hypot(x - start.x, margin - start.y);
+    };
+
+    //best[k][l] is the smallest largest cost of the first k robots covering the first l lanes, split[k][l] the first lane of robot k - 1.
+    std::vector<std::vector<double>> best(robots + 1, std::vector<double>(lanes + 1, INFINITY));
+    std::vector<std::vector<int>> split(robots + 1, std::vector<int>(lanes + 1, 0));
+    best[0][0] = 0;
+    for (int k = 1; k <= robots; k++)
+    {
+        for (int l = 0; l <= lanes; l++)
+        {
+            for (int first = 0; first <= l; first++)
+            {
+                double value = std::max(best[k - 1][first], cost(k - 1, first, l - 1));
+                if (value < best[k][l])
+                {
+                    best[k][l] = value;
+                    split[k][l] = first;
+                }
+            }
+        }
+    }
+
+    int l = lanes;
+    for (int k = robots; k >= 1; k--)
+    {
+        int first = split[k][l];
+        Region region = {first, l - 1};
+        regions[byX[k - 1]] = region;
+        l = first;
+    }
+    return regions;
+}
@@ -0,0 +1,85 @@
+#include "fleet.h"
+#include <cmath>
+
+using namespace Fleet;
+
+namespace
+{
+    double number(XmlRpc::XmlRpcValue &entry, const char *key)
+    {
+        if (!entry.hasMember(key))
+        {
+            return 0;
+        }
+        XmlRpc::XmlRpcValue &value = entry[key];
+        if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+        {
+            return int(value);
+        }
+        return double(value);
+    }
+} // namespace
+
+std::vector<Robot> Fleet::loadRobots()
+{
+    std::vector<Robot> robots;
+    XmlRpc::XmlRpcValue list;
+    if (!ros::param::get("/fleet/robots", list) || list.getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+        return robots;
+    }
+    for (int i = 0; i < list.size(); i++)
+    {
+        XmlRpc::XmlRpcValue &entry = list[i];
+        Robot robot;
+        robot.name = entry.hasMember("name") ? std::string(entry["name"]) : std::string();
+        robot.x = number(entry, "x");
+        robot.y = number(entry, "y");
+        robot.theta = number(entry, "theta");
+        robots.push_back(robot);
+    }
+    return robots;
+}
+
+std::string Fleet::robotName()
+{
+    std::string name = ros::this_node::getNamespace();
+    size_t begin = name.find_first_not_of('/');
+    size_t end = name.find_last_not_of('/');
+    return begin == std::string::npos ? std::string() : name.substr(begin, end - begin + 1);
+}
+
+std::string Fleet::markerFrame()
+{
+    return loadRobots().empty() ? "/odom" : "field";
+}
+
+field_Frame field_Frame::load()
+{
+    std::string name = robotName();
+    std::vector<Robot> robots = loadRobots();
+    for (size_t i = 0; i < robots.size(); i++)
+    {
+        if (robots[i].name == name)
+        {
+            return field_Frame(robots[i].x, robots[i].y, robots[i].theta);
+        }
+    }
+    return field_Frame();
+}
+
+field_Frame field_Frame::matching(const Pose_history::Stamped_pose &field, const Pose_history::Stamped_pose &odom)
+{
+    double theta = remainder(field.theta - odom.theta, 2 * M_PI);
+    return field_Frame(field.x - odom.x * cos(theta) + odom.y * sin(theta), field.y - odom.x * sin(theta) - odom.y * cos(theta), theta);
+}
+
+Pose_history::Stamped_pose field_Frame::toField(const Pose_history::Stamped_pose &odom) const
+{
+    Pose_history::Stamped_pose field;
+    field.stamp = odom.stamp;
+    field.x = x + odom.x * cos(theta) - odom.y * sin(theta);
+    field.y = y + odom.x * sin(theta) + odom.y * cos(theta);
+    field.theta = remainder(odom.theta + theta, 2 * M_PI);
+    return field;
+}
@@ -0,0 +1,54 @@
+#include "frame_gate.h"
+#include "opencv2/imgproc/imgproc.hpp"
+
+using namespace Frame_gate;
+
+frame_Gate::frame_Gate(const Camera_model::Camera &camera, const Gate_config &config)
+    : camera(camera), config(config), primed(false), lastStamp(0)
+{
+}
+
+bool frame_Gate::shouldProcess(const cv::Mat &frame, const turtlesim::Pose &pose, double stamp)
+{
+    cv::Mat small;
+    thumbnail(frame, small);
+
+    bool process = !primed || stamp - lastStamp >= config.maxAge;
+    //moving the footprint is checked first, it does not need the image.
+    if (!process)
+    {
+        process = Camera_model::footprintShift(camera, lastPose, pose) >= config.minShift;
+    }
+    if (!process)
+    {
+        process = thumbnailChange(small, lastThumbnail) >= config.minChange;
+    }
+
+    if (process)
+    {
+        primed = true;
+        lastPose = pose;
+        lastStamp = stamp;
+        lastThumbnail = small;
+    }
+    return process;
+}
+
+void frame_Gate::reset()
+{
+    primed = false;
+}
+
+void Frame_gate::thumbnail(const cv::Mat &frame, cv::Mat &small)
+{
+    cv::resize(frame, small, cv::Size(32, 24), 0, 0, cv::INTER_AREA);
+}
+
+double Frame_gate::thumbnailChange(const cv::Mat &a, const cv::Mat &b)
+{
+    if (a.size() != b.size() || a.type() != b.type())
+    {
+        return 255;
+    }
+    return cv::norm(a, b, cv::NORM_L1) / double(a.total() * a.channels());
+}
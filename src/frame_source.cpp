@@ -0,0 +1,623 @@
+#include "frame_source.h"
+#include "ros/ros.h"
+#include "ros/callback_queue.h"
+#include "sensor_msgs/Image.h"
+#include "sensor_msgs/image_encodings.h"
+#include "opencv2/highgui/highgui.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+#include "mission_log.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+using namespace Frame_source;
+
+namespace
+{
+    //header of a raw file, the frames follow it.
+    struct Raw_header
+    {
+        char magic[8];
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t frameBytes;
+        double fps;
+    };
+    const char rawMagic[8] = {'M', 'D', 'F', 'R', 'A', 'M', 'E', '1'};
+    //format of a raw file, after the YUV formats.
+    const uint32_t formatBgr = 2;
+
+    uint32_t frameBytes(uint32_t format, uint32_t width, uint32_t height)
+    {
+        if (format == formatBgr)
+        {
+            return width * height * 3;
+        }
+        return format == Yuv_threshold::FORMAT_YUYV ? width * height * 2 : width * height * 3 / 2;
+    }
+
+    //point a YUV frame at tightly packed data.
+    void setYuv(Frame &frame, Yuv_threshold::Yuv_format format, int width, int height, const uint8_t *data, size_t step)
+    {
+        frame.isYuv = true;
+        frame.bgr = cv::Mat();
+        frame.yuv.format = format;
+        frame.yuv.width = width;
+        frame.yuv.height = height;
+        frame.yuv.data = data;
+        frame.yuv.step = step;
+        frame.yuv.uv = format == Yuv_threshold::FORMAT_NV12 ? data + height * step : NULL;
+        frame.yuv.uvStep = step;
+    }
+
+    //frames decoded to BGR by OpenCV.
+    class opencv_Source : public frame_Source
+    {
+    public:
+        bool open(const std::string &source)
+        {
+            if (!source.empty() && source.find_first_not_of("0123456789") == std::string::npos)
+            {
+                return cap.open(std::stoi(source));
+            }
+            return cap.open(source);
+        }
+
+        bool grab(Frame &frame)
+        {
+            frame.isYuv = false;
+            return cap.read(frame.bgr);
+        }
+
+    private:
+        cv::VideoCapture cap;
+    };
+
+    //a V4L2 device streaming into buffers mapped from the driver. a frame points into the buffer it was captured to,
+    //the buffer goes back to the driver when the frame is released.
+    class v4l2_Source : public frame_Source
+    {
+    public:
+        ~v4l2_Source()
+        {
+            if (fd < 0)
+            {
+                return;
+            }
+            if (streaming)
+            {
+                v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                control(VIDIOC_STREAMOFF, &type);
+            }
+            for (size_t i = 0; i < buffers.size(); i++)
+            {
+                munmap(buffers[i].start, buffers[i].length);
+            }
+            close(fd);
+        }
+
+        bool open(const std::string &device, Yuv_threshold::Yuv_format format, int width, int height)
+        {
+            this->format = format;
+            fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK);
+            if (fd < 0)
+            {
+                return fail("open " + device);
+            }
+
+            v4l2_capability capability;
+            std::memset(&capability, 0, sizeof(capability));
+            if (!control(VIDIOC_QUERYCAP, &capability))
+            {
+                return fail("query capabilities");
+            }
+            if (!(capability.capabilities & V4L2_CAP_VIDEO_CAPTURE) || !(capability.capabilities & V4L2_CAP_STREAMING))
+            {
+                ROS_ERROR("%s can not stream video", device.c_str());
+                return false;
+            }
+
+            //the driver may change the size, but not the format, the thresholding needs the YUV format.
+            v4l2_format requested;
+            std::memset(&requested, 0, sizeof(requested));
+            requested.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            requested.fmt.pix.width = width;
+            requested.fmt.pix.height = height;
+            requested.fmt.pix.pixelformat = format == Yuv_threshold::FORMAT_YUYV ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_NV12;
+            requested.fmt.pix.field = V4L2_FIELD_NONE;
+            if (!control(VIDIOC_S_FMT, &requested))
+            {
+                return fail("set format");
+            }
+            if (requested.fmt.pix.pixelformat != (format == Yuv_threshold::FORMAT_YUYV ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_NV12))
+            {
+                ROS_ERROR("%s does not support the %s format", device.c_str(), format == Yuv_threshold::FORMAT_YUYV ? "yuyv" : "nv12");
+                return false;
+            }
+            if (int(requested.fmt.pix.width) != width || int(requested.fmt.pix.height) != height)
+            {
+                ROS_WARN("%s streams %ux%u instead of %dx%d", device.c_str(), requested.fmt.pix.width, requested.fmt.pix.height, width, height);
+            }
+            this->width = requested.fmt.pix.width;
+            this->height = requested.fmt.pix.height;
+            step = requested.fmt.pix.bytesperline;
+
+            //a few buffers, so the driver can fill one while another is processed.
+            v4l2_requestbuffers request;
+            std::memset(&request, 0, sizeof(request));
+            request.count = 4;
+            request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            request.memory = V4L2_MEMORY_MMAP;
+            if (!control(VIDIOC_REQBUFS, &request) || request.count < 2)
+            {
+                return fail("request buffers");
+            }
+            for (unsigned i = 0; i < request.count; i++)
+            {
+                v4l2_buffer buffer = emptyBuffer(i);
+                if (!control(VIDIOC_QUERYBUF, &buffer))
+                {
+                    return fail("query buffer");
+                }
+                void *start = mmap(NULL, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buffer.m.offset);
+                if (start == MAP_FAILED)
+                {
+                    return fail("map buffer");
+                }
+                Mapped mapped = {static_cast<uint8_t *>(start), buffer.length};
+                buffers.push_back(mapped);
+                if (!control(VIDIOC_QBUF, &buffer))
+                {
+                    return fail("queue buffer");
+                }
+            }
+
+            v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            if (!control(VIDIOC_STREAMON, &type))
+            {
+                return fail("start streaming");
+            }
+            streaming = true;
+            return true;
+        }
+
+        bool grab(Frame &frame)
+        {
+            pollfd ready = {fd, POLLIN, 0};
+            int result;
+            do
+            {
+                result = poll(&ready, 1, 1000);
+            } while (result < 0 && errno == EINTR);
+            if (result == 0)
+            {
+                ROS_ERROR("V4L2 device gave no frame for a second");
+                return false;
+            }
+            if (result < 0)
+            {
+                return fail("wait for a frame");
+            }
+
+            v4l2_buffer buffer = emptyBuffer(0);
+            if (!control(VIDIOC_DQBUF, &buffer))
+            {
+                return fail("dequeue buffer");
+            }
+            frame.buffer = buffer.index;
+            setYuv(frame, format, width, height, buffers[buffer.index].start, step);
+            return true;
+        }
+
+        void release(Frame &frame)
+        {
+            if (frame.buffer < 0)
+            {
+                return;
+            }
+            v4l2_buffer buffer = emptyBuffer(frame.buffer);
+            if (!control(VIDIOC_QBUF, &buffer))
+            {
+                fail("queue buffer");
+            }
+            frame.buffer = -1;
+        }
+
+    private:
+        struct Mapped
+        {
+            uint8_t *start;
+            size_t length;
+        };
+
+        v4l2_buffer emptyBuffer(unsigned index) const
+        {
+            v4l2_buffer buffer;
+            std::memset(&buffer, 0, sizeof(buffer));
+            buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            buffer.memory = V4L2_MEMORY_MMAP;
+            buffer.index = index;
+            return buffer;
+        }
+
+        bool control(unsigned long request, void *argument)
+        {
+            int result;
+            do
+            {
+                result = ioctl(fd, request, argument);
+            } while (result < 0 && errno == EINTR);
+            return result >= 0;
+        }
+
+        bool fail(const std::string &what)
+        {
+            ROS_ERROR("V4L2 could not %s: %s", what.c_str(), std::strerror(errno));
+            return false;
+        }
+
+        int fd = -1;
+        bool streaming = false;
+        Yuv_threshold::Yuv_format format = Yuv_threshold::FORMAT_YUYV;
+        int width = 0;
+        int height = 0;
+        size_t step = 0;
+        std::vector<Mapped> buffers;
+    };
+
+    //replays a raw file mapped into memory, the frames point into the mapping. the mapping is private,
+    //so drawing on a BGR frame does not change the file.
+    class raw_Source : public frame_Source
+    {
+    public:
+        ~raw_Source()
+        {
+            if (map != MAP_FAILED)
+            {
+                munmap(map, length);
+            }
+        }
+
+        bool open(const std::string &path)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                ROS_ERROR("Could not open raw file %s: %s", path.c_str(), std::strerror(errno));
+                return false;
+            }
+            struct stat status;
+            if (fstat(fd, &status) == 0 && size_t(status.st_size) >= sizeof(Raw_header))
+            {
+                length = status.st_size;
+                map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            }
+            close(fd);
+            if (map == MAP_FAILED)
+            {
+                ROS_ERROR("Could not map raw file %s", path.c_str());
+                return false;
+            }
+
+            //a width or height of 0 gives frames of 0 bytes, which can not be counted.
+            std::memcpy(&header, map, sizeof(header));
+            if (std::memcmp(header.magic, rawMagic, sizeof(rawMagic)) != 0 || header.format > formatBgr || header.frameBytes == 0 ||
+                header.frameBytes != frameBytes(header.format, header.width, header.height))
+            {
+                ROS_ERROR("%s is not a raw frame file", path.c_str());
+                return false;
+            }
+            frames = (length - sizeof(header)) / header.frameBytes;
+            return true;
+        }
+
+        bool grab(Frame &frame)
+        {
+            if (next >= frames)
+            {
+                return false;
+            }
+
+            //keep the frame rate of the recording.
+            if (header.fps > 0)
+            {
+                if (next == 0)
+                {
+                    start = std::chrono::steady_clock::now();
+                }
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(next / header.fps)));
+            }
+
+            uint8_t *data = static_cast<uint8_t *>(map) + sizeof(header) + next * size_t(header.frameBytes);
+            if (header.format == formatBgr)
+            {
+                frame.isYuv = false;
+                frame.bgr = cv::Mat(header.height, header.width, CV_8UC3, data);
+            }
+            else
+            {
+                setYuv(frame, Yuv_threshold::Yuv_format(header.format), header.width, header.height, data,
+                       header.format == Yuv_threshold::FORMAT_YUYV ? header.width * 2 : header.width);
+            }
+            next++;
+            return true;
+        }
+
+    private:
+        void *map = MAP_FAILED;
+        size_t length = 0;
+        Raw_header header;
+        size_t frames = 0;
+        size_t next = 0;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    //replays the frames of one camera from a mission log. raw frames point into the mapping of the log.
+    class log_Source : public frame_Source
+    {
+    public:
+        bool open(const std::string &path, const std::string &camera)
+        {
+            this->camera = camera;
+            if (!log.open(path))
+            {
+                ROS_ERROR("Could not open mission log %s", path.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        bool grab(Frame &frame)
+        {
+            //with a simulated clock the replay is followed, starting at the time it is at.
+            if (first && ros::Time::isSimTime())
+            {
+                log.seek(ros::Time::now().toSec());
+            }
+            Mission_log::Record record;
+            do
+            {
+                if (!log.next(record))
+                {
+                    return false;
+                }
+            } while (record.type != Mission_log::RECORD_FRAME || (!camera.empty() && record.frame.camera != camera));
+            if (camera.empty())
+            {
+                camera = record.frame.camera;
+            }
+
+            if (ros::Time::isSimTime())
+            {
+                while (ros::ok() && ros::Time::now().toSec() < record.stamp)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            else
+            {
+                if (first)
+                {
+                    start = std::chrono::steady_clock::now();
+                    startStamp = record.stamp;
+                }
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(record.stamp - startStamp)));
+            }
+            first = false;
+
+            return unpackLogged(record.frame, frame);
+        }
+
+    private:
+        Mission_log::log_Reader log;
+        std::string camera;
+        bool first = true;
+        std::chrono::steady_clock::time_point start;
+        double startStamp = 0;
+    };
+
+    //the frames of a sensor_msgs/Image topic, like the camera of a robot simulated in Gazebo. the images are taken
+    //from a queue of the source on the grabbing thread, a frame points into its message until the next grab.
+    class topic_Source : public frame_Source
+    {
+    public:
+        bool open(const std::string &topic)
+        {
+            node.setCallbackQueue(&queue);
+            subscriber = node.subscribe(topic, 1, &topic_Source::imageCallback, this);
+            return true;
+        }
+
+        bool grab(Frame &frame)
+        {
+            image.reset();
+            while (!image && ros::ok())
+            {
+                queue.callAvailable(ros::WallDuration(0.1));
+            }
+            if (!image)
+            {
+                return false;
+            }
+
+            frame.isYuv = false;
+            cv::Mat view(image->height, image->width, CV_8UC3, const_cast<uint8_t *>(image->data.data()), image->step);
+            if (image->encoding == sensor_msgs::image_encodings::BGR8)
+            {
+                frame.bgr = view;
+            }
+            else if (image->encoding == sensor_msgs::image_encodings::RGB8)
+            {
+                cv::cvtColor(view, frame.bgr, cv::COLOR_RGB2BGR);
+            }
+            else
+            {
+                ROS_ERROR("Unsupported image encoding %s, use bgr8 or rgb8", image->encoding.c_str());
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        void imageCallback(const sensor_msgs::Image::ConstPtr &message)
+        {
+            image = message;
+        }
+
+        ros::NodeHandle node;
+        ros::CallbackQueue queue;
+        ros::Subscriber subscriber;
+        sensor_msgs::Image::ConstPtr image;
+    };
+} // namespace
+
+bool Frame_source::unpackLogged(const Mission_log::Frame &logged, Frame &frame)
+{
+    uint8_t *data = const_cast<uint8_t *>(logged.data);
+    if (logged.format == Mission_log::FRAME_JPEG)
+    {
+        frame.isYuv = false;
+        frame.bgr = cv::imdecode(cv::Mat(1, logged.bytes, CV_8UC1, data), cv::IMREAD_COLOR);
+        return !frame.bgr.empty();
+    }
+    if (logged.format == Mission_log::FRAME_BGR)
+    {
+        frame.isYuv = false;
+        frame.bgr = cv::Mat(logged.height, logged.width, CV_8UC3, data);
+        return true;
+    }
+    Yuv_threshold::Yuv_format format = Yuv_threshold::Yuv_format(logged.format);
+    setYuv(frame, format, logged.width, logged.height, data, format == Yuv_threshold::FORMAT_YUYV ? logged.width * 2 : logged.width);
+    return true;
+}
+
+std::unique_ptr<frame_Source> Frame_source::openSource(const std::string &source, const std::string &format, int width, int height)
+{
+    if (source.compare(0, 5, "v4l2:") == 0)
+    {
+        if (format != "yuyv" && format != "nv12")
+        {
+            ROS_ERROR("Unknown V4L2 format %s, use yuyv or nv12", format.c_str());
+            return std::unique_ptr<frame_Source>();
+        }
+        std::unique_ptr<v4l2_Source> device(new v4l2_Source());
+        if (!device->open(source.substr(5), format == "nv12" ? Yuv_threshold::FORMAT_NV12 : Yuv_threshold::FORMAT_YUYV, width, height))
+        {
+            return std::unique_ptr<frame_Source>();
+        }
+        return std::move(device);
+    }
+    if (source.compare(0, 4, "raw:") == 0)
+    {
+        std::unique_ptr<raw_Source> file(new raw_Source());
+        if (!file->open(source.substr(4)))
+        {
+            return std::unique_ptr<frame_Source>();
+        }
+        return std::move(file);
+    }
+
+    if (source.compare(0, 4, "log:") == 0)
+    {
+        size_t hash = source.rfind('#');
+        std::string path = source.substr(4, hash == std::string::npos ? std::string::npos : hash - 4);
+        std::unique_ptr<log_Source> log(new log_Source());
+        if (!log->open(path, hash == std::string::npos ? "" : source.substr(hash + 1)))
+        {
+            return std::unique_ptr<frame_Source>();
+        }
+        return std::move(log);
+    }
+
+    if (source.compare(0, 6, "topic:") == 0)
+    {
+        std::unique_ptr<topic_Source> topic(new topic_Source());
+        topic->open(source.substr(6));
+        return std::move(topic);
+    }
+
+    std::unique_ptr<opencv_Source> capture(new opencv_Source());
+    if (!capture->open(source))
+    {
+        return std::unique_ptr<frame_Source>();
+    }
+    return std::move(capture);
+}
+
+cv::Mat Frame_source::rawView(const Frame &frame)
+{
+    if (!frame.isYuv)
+    {
+        return frame.bgr;
+    }
+    int type = frame.yuv.format == Yuv_threshold::FORMAT_YUYV ? CV_8UC2 : CV_8UC1;
+    return cv::Mat(frame.yuv.height, frame.yuv.width, type, const_cast<uint8_t *>(frame.yuv.data), frame.yuv.step);
+}
+
+raw_Writer::~raw_Writer()
+{
+    if (file != NULL)
+    {
+        std::fclose(file);
+    }
+}
+
+bool raw_Writer::open(const std::string &path, const Frame &first, double fps)
+{
+    Raw_header header;
+    std::memcpy(header.magic, rawMagic, sizeof(rawMagic));
+    header.format = first.isYuv ? uint32_t(first.yuv.format) : formatBgr;
+    header.width = first.isYuv ? first.yuv.width : first.bgr.cols;
+    header.height = first.isYuv ? first.yuv.height : first.bgr.rows;
+    header.frameBytes = frameBytes(header.format, header.width, header.height);
+    header.fps = fps;
+
+    file = std::fopen(path.c_str(), "wb");
+    return file != NULL && std::fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool raw_Writer::write(const Frame &frame)
+{
+    if (file == NULL)
+    {
+        return false;
+    }
+    packFrame(frame, packed);
+    return std::fwrite(packed.data(), packed.size(), 1, file) == 1;
+}
+
+uint32_t Frame_source::packFrame(const Frame &frame, std::vector<uint8_t> &bytes)
+{
+    bytes.clear();
+    if (!frame.isYuv)
+    {
+        for (int y = 0; y < frame.bgr.rows; y++)
+        {
+            bytes.insert(bytes.end(), frame.bgr.ptr(y), frame.bgr.ptr(y) + frame.bgr.cols * 3);
+        }
+        return formatBgr;
+    }
+
+    const Yuv_threshold::Yuv_frame &yuv = frame.yuv;
+    size_t rowBytes = yuv.format == Yuv_threshold::FORMAT_YUYV ? yuv.width * 2 : yuv.width;
+    for (int y = 0; y < yuv.height; y++)
+    {
+        bytes.insert(bytes.end(), yuv.data + y * yuv.step, yuv.data + y * yuv.step + rowBytes);
+    }
+    for (int y = 0; yuv.format == Yuv_threshold::FORMAT_NV12 && y < yuv.height / 2; y++)
+    {
+        bytes.insert(bytes.end(), yuv.uv + y * yuv.uvStep, yuv.uv + y * yuv.uvStep + rowBytes);
+    }
+    return yuv.format;
+}
@@ -0,0 +1,251 @@
+#include "lane_order.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace Lane_order;
+
+namespace
+{
+    struct Position
+    {
+        double x;
+        double y;
+    };
+
+    double distance(const Position &a, const Position &b)
+    {
+        return std::hypot(b.x - a.x, b.y - a.y);
+    }
+
+    //the route being improved, with the ends of each placed segment in driving direction.
+    class route_Builder
+    {
+    public:
+        route_Builder(const Position &start, const std::vector<Segment> &segments, Route &route)
+            : start(start), segments(segments), route(route) {}
+
+        Position head(int k) const
+        {
+            const Segment &s = segments[route.order[k]];
+            return route.reversed[k] ? Position{s.endX, s.endY} : Position{s.startX, s.startY};
+        }
+        Position tail(int k) const
+        {
+            const Segment &s = segments[route.order[k]];
+            return route.reversed[k] ? Position{s.startX, s.startY} : Position{s.endX, s.endY};
+        }
+        //where the robot is before the segment at k.
+        Position before(int k) const
+        {
+            return k == 0 ? start : tail(k - 1);
+        }
+
+        //reverse the segments [i, j], shorter if the transits into i and out of j get shorter.
+        bool twoOpt(int i, int j)
+        {
+            int n = route.order.size();
+            Position previous = before(i);
+            double old = distance(previous, head(i));
+            double now = distance(previous, tail(j));
+            if (j + 1 < n)
+            {
+                old += distance(tail(j), head(j + 1));
+                now += distance(head(i), head(j + 1));
+            }
+            if (now >= old - 1e-9)
+            {
+                return false;
+            }
+            std::reverse(route.order.begin() + i, route.order.begin() + j + 1);
+            std::reverse(route.reversed.begin() + i, route.reversed.begin() + j + 1);
+            for (int k = i; k <= j; k++)
+            {
+                route.reversed[k] = !route.reversed[k];
+            }
+            return true;
+        }
+
+        //move the chain of segments [i, i + length) to the best other place, in either direction.
+        bool orOpt(int i, int length)
+        {
+            int n = route.order.size();
+            int last = i + length - 1;
+            Position previous = before(i);
+            //what removing the chain saves.
+            double gain = distance(previous, head(i));
+            if (last + 1 < n)
+            {
+                gain += distance(tail(last), head(last + 1)) - distance(previous, head(last + 1));
+            }
+
+            Position chainHead = head(i);
+            Position chainTail = tail(last);
+            double best = gain - 1e-9;
+            int bestPlace = -1;
+            bool bestReversed = false;
+            //insert before the segment at place, place n is after the last one.
+            for (int place = 0; place <= n; place++)
+            {
+                if (place >= i && place <= last + 1)
+                {
+                    continue;
+                }
+                Position from = place == 0 ? start : tail(place - 1);
+                for (int reversed = 0; reversed < 2; reversed++)
+                {
+                    Position in = reversed ? chainTail : chainHead;
+                    Position out = reversed ? chainHead : chainTail;
+                    double cost = distance(from, in);
+                    if (place < n)
+                    {
+                        cost += distance(out, head(place)) - distance(from, head(place));
+                    }
+                    if (cost < best)
+                    {
+                        best = cost;
+                        bestPlace = place;
+                        bestReversed = reversed;
+                    }
+                }
+            }
+            if (bestPlace < 0)
+            {
+                return false;
+            }
+
+            std::vector<int> order(route.order.begin() + i, route.order.begin() + last + 1);
+            std::vector<bool> reversed(route.reversed.begin() + i, route.reversed.begin() + last + 1);
+            if (bestReversed)
+            {
+                std::reverse(order.begin(), order.end());
+                std::reverse(reversed.begin(), reversed.end());
+                reversed.flip();
+            }
+            route.order.erase(route.order.begin() + i, route.order.begin() + last + 1);
+            route.reversed.erase(route.reversed.begin() + i, route.reversed.begin() + last + 1);
+            int place = bestPlace > last ? bestPlace - length : bestPlace;
+            route.order.insert(route.order.begin() + place, order.begin(), order.end());
+            route.reversed.insert(route.reversed.begin() + place, reversed.begin(), reversed.end());
+            return true;
+        }
+
+    private:
+        Position start;
+        const std::vector<Segment> &segments;
+        Route &route;
+    };
+
+    //improve the route by 2-opt and Or-opt moves until a whole pass finds nothing or the time is up.
+    void improve(const Position &start, const std::vector<Segment> &segments, Route &route,
+                 std::chrono::steady_clock::time_point deadline)
+    {
+        int n = route.order.size();
+        route_Builder builder(start, segments, route);
+        bool improved = true;
+        while (improved && std::chrono::steady_clock::now() < deadline)
+        {
+            improved = false;
+            for (int i = 0; i < n; i++)
+            {
+                for (int j = i + 1; j < n; j++)
+                {
+                    improved |= builder.twoOpt(i, j);
+                }
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    break;
+                }
+            }
+            for (int length = 1; length <= 3; length++)
+            {
+                for (int i = 0; i + length <= n; i++)
+                {
+                    improved |= builder.orOpt(i, length);
+                }
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    break;
+                }
+            }
+        }
+    }
+} // namespace
+
+Route Lane_order::planRoute(double startX, double startY, const std::vector<Segment> &segments, double timeBudget)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+                                                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeBudget));
+    int n = segments.size();
+    Route route;
+
+    //nearest neighbour: always drive to the closest end of a remaining segment.
+    std::vector<bool> used(n, false);
+    Position at = {startX, startY};
+    for (int k = 0; k < n; k++)
+    {
+        int best = -1;
+        bool bestReversed = false;
+        double bestDistance = INFINITY;
+        for (int s = 0; s < n; s++)
+        {
+            if (used[s])
+            {
+                continue;
+            }
+            double toStart = distance(at, Position{segments[s].startX, segments[s].startY});
+            double toEnd = distance(at, Position{segments[s].endX, segments[s].endY});
+            if (toStart < bestDistance)
+            {
+                bestDistance = toStart;
+                best = s;
+                bestReversed = false;
+            }
+            if (toEnd < bestDistance)
+            {
+                bestDistance = toEnd;
+                best = s;
+                bestReversed = true;
+            }
+        }
+        used[best] = true;
+        route.order.push_back(best);
+        route.reversed.push_back(bestReversed);
+        at = bestReversed ? Position{segments[best].startX, segments[best].startY} : Position{segments[best].endX, segments[best].endY};
+    }
+
+    //half of the budget for each start, the given order gets what nearest neighbour leaves.
+    std::chrono::steady_clock::time_point half = std::chrono::steady_clock::now() + (deadline - std::chrono::steady_clock::now()) / 2;
+    improve(Position{startX, startY}, segments, route, half);
+    route.transit = transitLength(startX, startY, segments, route);
+
+    //the segments in their given order, improved the same way. the moves only shorten a route, so the result is never
+    //longer than the given order, which nearest neighbour can be.
+    Route given;
+    for (int k = 0; k < n; k++)
+    {
+        given.order.push_back(k);
+        given.reversed.push_back(false);
+    }
+    improve(Position{startX, startY}, segments, given, deadline);
+    given.transit = transitLength(startX, startY, segments, given);
+    if (given.transit < route.transit)
+    {
+        return given;
+    }
+    return route;
+}
+
+double Lane_order::transitLength(double startX, double startY, const std::vector<Segment> &segments, const Route &route)
+{
+    double length = 0;
+    Position at = {startX, startY};
+    for (size_t k = 0; k < route.order.size(); k++)
+    {
+        const Segment &s = segments[route.order[k]];
+        Position head = route.reversed[k] ? Position{s.endX, s.endY} : Position{s.startX, s.startY};
+        length += distance(at, head);
+        at = route.reversed[k] ? Position{s.startX, s.startY} : Position{s.endX, s.endY};
+    }
+    return length;
+}
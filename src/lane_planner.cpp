@@ -0,0 +1,186 @@
+#include "lane_planner.h"
+#include <chrono>
+#include <cmath>
+#include "latency_trace.h"
+
+using namespace Lane_planner;
+using Obstacle_avoidance::Obstacle_Point;
+
+namespace
+{
+    const int stage_ahead = Latency_trace::stage("plan_ahead");
+
+    //an obstacle that moved less than this, in meters, keeps the plan made against it. the obstacle of every scan
+    //moves a little with the noise of the scan.
+    const double replan_distance = 0.05;
+} // namespace
+
+bool plan_Queue::push(std::unique_ptr<Lane_plan> &plan)
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == capacity)
+    {
+        return false;
+    }
+    slots[t % capacity] = std::move(plan);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool plan_Queue::pop(std::unique_ptr<Lane_plan> &plan)
+{
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    plan = std::move(slots[h % capacity]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+void lane_Planner::start(int lanesAhead, double reorderBudget)
+{
+    lanes_ahead = lanesAhead;
+    reorder_budget = reorderBudget;
+    stopping = false;
+    thread = std::thread(&lane_Planner::run, this);
+}
+
+void lane_Planner::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+void lane_Planner::request(const Path_plan::lane_Path &path, uint64_t version, size_t from, bool reorder)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (requested && version == this->version && from == this->from && reorder == this->reorder)
+        {
+            return;
+        }
+    }
+    //only the spans from the stop a reorder starts at on are planned. they are copied with their own points and
+    //without the lock, the stops of the flattened spans split them into the same spans again.
+    size_t first = from > 0 ? from - 1 : 0;
+    Path_plan::lane_Path ahead(path.flatten(first));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    this->path = std::move(ahead);
+    this->first = first;
+    this->version = version;
+    this->from = from;
+    this->reorder = reorder;
+    requested = true;
+    planned = false;
+    wake.notify_one();
+}
+
+void lane_Planner::obstacle(const Obstacle_Point &obstacle, double radius)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    current_obstacle = obstacle;
+    current_radius = radius;
+    if (!requested || !planned)
+    {
+        return;
+    }
+
+    //plan again only if the obstacle moved, and is near the lanes planned ahead or was detoured around.
+    bool moved = std::hypot(obstacle.x - planned_obstacle.x, obstacle.y - planned_obstacle.y) > replan_distance ||
+                 std::fabs(radius - planned_radius) > replan_distance;
+    if (moved && (planned_detours > 0 || planned_path.nearLanes(planned_from, lanes_ahead, obstacle, radius)))
+    {
+        planned = false;
+        wake.notify_one();
+    }
+}
+
+void lane_Planner::receive()
+{
+    std::unique_ptr<Lane_plan> plan;
+    while (finished.pop(plan))
+    {
+        newest = std::move(plan);
+    }
+}
+
+bool lane_Planner::take(uint64_t version, size_t from, bool reorder, Lane_plan &plan)
+{
+    receive();
+    if (!newest || newest->version != version || newest->from != from || newest->reorder != reorder)
+    {
+        return false;
+    }
+    plan = std::move(*newest);
+    newest.reset();
+    return true;
+}
+
+void lane_Planner::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping)
+    {
+        if (unsent)
+        {
+            finished.push(unsent);
+        }
+
+        if (requested && !planned)
+        {
+            //plan a copy of the request without the lock, the main loop may send a newer one meanwhile.
+            Path_plan::lane_Path ahead = path;
+            size_t ahead_first = first;
+            std::unique_ptr<Lane_plan> plan(new Lane_plan());
+            plan->version = version;
+            plan->from = from;
+            plan->reorder = reorder;
+            plan->reordered = false;
+            plan->transit = 0;
+            Obstacle_Point obstacle = current_obstacle;
+            double radius = current_radius;
+            planned = true;
+            lock.unlock();
+
+            uint64_t start = Latency_trace::now();
+            size_t s = plan->from - ahead_first;
+            if (plan->reorder && s > 0 && s < ahead.size() && reorder_budget > 0)
+            {
+                plan->reordered = ahead.reorderLanes(s, ahead.stop(s - 1).x, ahead.stop(s - 1).y, reorder_budget, plan->transit);
+            }
+            plan->detours = ahead.detourLanes(s, lanes_ahead, obstacle, radius);
+            plan->points = ahead.flatten(s);
+            Latency_trace::record(stage_ahead, start, Latency_trace::now() - start);
+
+            lock.lock();
+            planned_path = std::move(ahead);
+            planned_from = s;
+            planned_obstacle = obstacle;
+            planned_radius = radius;
+            planned_detours = plan->detours;
+            //a newer plan replaces one still waiting for room.
+            unsent = std::move(plan);
+            continue;
+        }
+
+        //the consumer empties the queue every loop, a plan waiting for room is sent soon.
+        if (unsent)
+        {
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        else
+        {
+            wake.wait(lock);
+        }
+    }
+}
@@ -1,28 +1,53 @@
 #include "ros/ros.h"
 #include "sensor_msgs/LaserScan.h"
+#include "sensor_msgs/Image.h"
+#include "sensor_msgs/CameraInfo.h"
+#include "sensor_msgs/image_encodings.h"
 #include <iostream>
 #include <vector>
 #include <math.h>
 #include <mine_detection/Obstacle.h>
 #include <visualization_msgs/Marker.h>
+#include <latency_diagnostics.h>
+#include <obstacle.h>
+#include <depth_scan.h>
+#include <mission_log.h>
+#include <trace_context.h>
 
-//#include "obstacle.h"
+using namespace Obstacle_avoidance;
 
-//define twodimensional point as struct. 
-struct Point
-{
-    double x;
-    double y;
-};
+//twodimensional point in the laser frame.
+typedef Obstacle_Point Point;
 
-std::vector<Point> pointsi;
+std::vector<Point> points;
+//the scan or depth image the points were measured in.
+mine_detection::TraceContext scan_trace;
 
 ros::Subscriber laser_sub;
+ros::Subscriber depth_sub;
+ros::Subscriber info_sub;
 ros::Publisher obstacle_pub;
 ros::Publisher rviz_pub;
 
+//latency stages of the obstacle detection.
+const int stage_scan = Latency_trace::stage("laser_callback");
+const int stage_circle = Latency_trace::stage("circle_fit");
+const int stage_depth = Latency_trace::stage("depth_callback");
+//hops of the obstacle chain, from the stamp of the scan.
+const int hop_scan = Latency_trace::stage("scan_received");
+const int hop_obstacle = Latency_trace::stage("obstacle_published");
+
+//in depth mode the points come from the depth image, projected with the intrinsics of the first camera info.
+Depth_scan::depth_Projector projector;
+Depth_scan::Depth_camera depth_camera;
+bool has_intrinsics = false;
+
+//scans as they arrive, for log_replay. only used with the ~log_file parameter.
+Mission_log::log_Writer mission_log;
+
 void laserCallback(const sensor_msgs::LaserScan::ConstPtr &laser_msg)
 {
+    Latency_trace::Scoped_timer timer(stage_scan);
     float angle;
     int count = 0;
     bool isInRangeRight;
@@ -31,6 +56,9 @@ void laserCallback(const sensor_msgs::LaserScan::ConstPtr &laser_msg)
 
     points.clear();
     points.shrink_to_fit();
+    scan_trace = Trace_context::begin("scan", laser_msg->header.stamp);
+    Trace_context::hop(hop_scan, scan_trace);
+    mission_log.scan(laser_msg->header.stamp.toSec(), laser_msg->angle_min, laser_msg->angle_increment, laser_msg->range_min, laser_msg->range_max, laser_msg->ranges);
     //std::cout << "New array:" << std::endl;
     for (int i = 0; i < laser_msg->ranges.size(); i++)
     {
@@ -59,31 +87,54 @@ void laserCallback(const sensor_msgs::LaserScan::ConstPtr &laser_msg)
     }
 }
 
-Point getCenterOfCircle(std::vector<Point> *points)
+//intrinsics of the depth camera, the ray table is built again only if they change.
+void infoCallback(const sensor_msgs::CameraInfo::ConstPtr &info)
 {
-    //get first, middle and last point of the ranges array which is on the obstacle.
-    Point f = (*points).at(0);
-    Point m = (*points).at(points->size() / 2);
-    Point l = (*points).at(points->size() - 1);
-
-    //calculate determinants
-    double A = f.x * (m.y - l.y) - f.y * (m.x - l.x) + m.x * l.y - l.x * m.y;
-    double B = (pow(f.x, 2) + pow(f.y, 2)) * (l.y - m.y) + (pow(m.x, 2) + pow(m.y, 2)) * (f.y - l.y) + (pow(l.x, 2) + pow(l.y, 2)) * (m.y - f.y);
-    double C = (pow(f.x, 2) + pow(f.y, 2)) * (m.x - l.x) + (pow(m.x, 2) + pow(m.y, 2)) * (l.x - f.x) + (pow(l.x, 2) + pow(l.y, 2)) * (f.x - m.x);
-
-    //Create center point.
-    Point center;
-    center.x = -B / (2 * A);
-    center.y = -C / (2 * A);
-
-    //return
-    return center;
+    if (has_intrinsics && int(info->width) == depth_camera.width && int(info->height) == depth_camera.height &&
+        info->K[0] == depth_camera.fx && info->K[4] == depth_camera.fy && info->K[2] == depth_camera.cx && info->K[5] == depth_camera.cy)
+    {
+        return;
+    }
+    depth_camera.width = info->width;
+    depth_camera.height = info->height;
+    depth_camera.fx = info->K[0];
+    depth_camera.fy = info->K[4];
+    depth_camera.cx = info->K[2];
+    depth_camera.cy = info->K[5];
+    projector.configure(depth_camera);
+    has_intrinsics = true;
 }
 
-//calculate radius from center to peripheral point.
-double obstacleRadius(Point center, Point per_coordinate)
+//the nearest point in the height band of every image column, as the points of a scan.
+void depthCallback(const sensor_msgs::Image::ConstPtr &depth_msg)
 {
-    return sqrt(pow(center.x - per_coordinate.x, 2) + pow(center.y - per_coordinate.y, 2));
+    Latency_trace::Scoped_timer timer(stage_depth);
+    if (!has_intrinsics)
+    {
+        ROS_WARN_THROTTLE(5, "No camera info for the depth image yet.");
+        return;
+    }
+    if (int(depth_msg->width) != depth_camera.width || int(depth_msg->height) != depth_camera.height)
+    {
+        ROS_WARN_THROTTLE(5, "Depth image is %ux%u, the camera info %dx%d.", depth_msg->width, depth_msg->height, depth_camera.width, depth_camera.height);
+        return;
+    }
+
+    if (depth_msg->encoding == sensor_msgs::image_encodings::TYPE_16UC1)
+    {
+        projector.project(reinterpret_cast<const uint16_t *>(depth_msg->data.data()), depth_msg->step, points);
+    }
+    else if (depth_msg->encoding == sensor_msgs::image_encodings::TYPE_32FC1)
+    {
+        projector.project(reinterpret_cast<const float *>(depth_msg->data.data()), depth_msg->step, points);
+    }
+    else
+    {
+        ROS_WARN_THROTTLE(5, "Unsupported depth encoding %s.", depth_msg->encoding.c_str());
+        return;
+    }
+    scan_trace = Trace_context::begin("depth", depth_msg->header.stamp);
+    Trace_context::hop(hop_scan, scan_trace);
 }
 
 int main(int argc, char *argv[])
@@ -93,11 +144,43 @@ int main(int argc, char *argv[])
     ros::NodeHandle n;
 
     //assign ros semantics.
-    laser_sub = n.subscribe<sensor_msgs::LaserScan>("/scan", 10, &laserCallback);
+    //"scan" uses the scan of the 3D sensor, "depth" its depth image, which also sees low and overhanging obstacles
+    //and does not need the depthimage_to_laserscan node.
+    std::string mode;
+    ros::NodeHandle("~").param("mode", mode, std::string("scan"));
+    if (mode == "depth")
+    {
+        ros::NodeHandle("~").param("camera_height", depth_camera.mountHeight, depth_camera.mountHeight);
+        ros::NodeHandle("~").param("min_height", depth_camera.minHeight, depth_camera.minHeight);
+        ros::NodeHandle("~").param("max_height", depth_camera.maxHeight, depth_camera.maxHeight);
+        ros::NodeHandle("~").param("max_range", depth_camera.maxRange, depth_camera.maxRange);
+        info_sub = n.subscribe<sensor_msgs::CameraInfo>("camera/depth/camera_info", 1, &infoCallback);
+        //only the newest image is wanted, an old one gives an old obstacle.
+        depth_sub = n.subscribe<sensor_msgs::Image>("camera/depth/image_raw", 1, &depthCallback);
+    }
+    else
+    {
+        laser_sub = n.subscribe<sensor_msgs::LaserScan>("scan", 10, &laserCallback);
+    }
+    //the scans are logged as they arrive, the depth images are not.
+    std::string log_file;
+    ros::NodeHandle("~").param("log_file", log_file, std::string());
+    if (!log_file.empty())
+    {
+        log_file = Mission_log::startPath(log_file);
+        if (!mission_log.open(log_file))
+        {
+            ROS_ERROR("Could not create the log %s.", log_file.c_str());
+        }
+    }
+
     //use custom obstacle message type.
-    obstacle_pub = n.advertise<mine_detection::Obstacle>("/obstacle", 10);
+    obstacle_pub = n.advertise<mine_detection::Obstacle>("obstacle", 10);
     ros::Rate loop_rate(10);
 
+    Latency_trace::diagnostics_Publisher diagnostics;
+    diagnostics.start(n, "laser");
+
     //initialize center point and radius of obstacle
     Point center;
     double radius;
@@ -106,14 +189,19 @@ int main(int argc, char *argv[])
     while (ros::ok())
     {
         ros::spinOnce();
-        if (points.size() > 3)
+        //the obstacle of a scan is published once, the loop runs again before the next scan arrives.
+        bool new_scan = scan_trace.seq != obstacle_msg.trace.seq || scan_trace.source != obstacle_msg.trace.source;
+        if (points.size() > 3 && new_scan)
         {
+            Latency_trace::Scoped_timer timer(stage_circle);
+
             //get center of obstacle.
             center = getCenterOfCircle(&points);
 
             //assign message point to the obstacle center.
             obstacle_msg.x = center.x;
             obstacle_msg.y = center.y;
+            obstacle_msg.trace = scan_trace;
             
             //get radius of obstacle and assign it to the message.
             radius = obstacleRadius(center, points[0]);
@@ -123,9 +211,11 @@ int main(int argc, char *argv[])
             if (radius < 0.35)
                 {
                     obstacle_pub.publish(obstacle_msg);
+                    Trace_context::hop(hop_obstacle, scan_trace);
                 }
         }
         loop_rate.sleep();
     }
+    mission_log.close();
     return 0;
 }
@@ -0,0 +1,76 @@
+#include "latency_diagnostics.h"
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <sstream>
+#include <iomanip>
+
+using namespace Latency_trace;
+
+void diagnostics_Publisher::start(ros::NodeHandle &n, const std::string &node_name)
+{
+    this->node_name = node_name;
+
+    ros::NodeHandle private_n("~");
+    double period;
+    std::string trace_file;
+    private_n.param("diagnostics_period", period, 5.0);
+    private_n.param("trace_file", trace_file, std::string(""));
+
+    if (!trace_file.empty())
+    {
+        tracing = open_trace(trace_file);
+        if (tracing)
+        {
+            ROS_INFO("Writing latency trace to %s", trace_file.c_str());
+        }
+        else
+        {
+            ROS_ERROR("Could not open latency trace file %s", trace_file.c_str());
+        }
+    }
+
+    if (period > 0)
+    {
+        diagnostics_pub = n.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 10);
+        timer = n.createTimer(ros::Duration(period), &diagnostics_Publisher::publish, this);
+    }
+}
+
+diagnostics_Publisher::~diagnostics_Publisher()
+{
+    if (tracing)
+    {
+        close_trace();
+    }
+}
+
+void diagnostics_Publisher::publish(const ros::TimerEvent &event)
+{
+    std::vector<Stage_summary> summaries = summarize();
+
+    //one status per node, with one value per stage.
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.name = node_name + ": latency";
+    status.message = summaries.empty() ? "No stages ran" : "Stage latency in ms since last report";
+
+    for (size_t i = 0; i < summaries.size(); i++)
+    {
+        std::ostringstream value;
+        value << std::fixed << std::setprecision(3)
+              << "n=" << summaries[i].count
+              << " p50=" << summaries[i].p50
+              << " p90=" << summaries[i].p90
+              << " p99=" << summaries[i].p99
+              << " max=" << summaries[i].max;
+
+        diagnostic_msgs::KeyValue key_value;
+        key_value.key = summaries[i].name;
+        key_value.value = value.str();
+        status.values.push_back(key_value);
+    }
+
+    diagnostic_msgs::DiagnosticArray array;
+    array.header.stamp = ros::Time::now();
+    array.status.push_back(status);
+    diagnostics_pub.publish(array);
+}
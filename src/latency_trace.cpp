@@ -0,0 +1,342 @@
+#include "latency_trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+using namespace Latency_trace;
+
+namespace
+{
+    //histogram buckets: 4 sub buckets for every power of two nanoseconds.
+    const int sub_bits = 2;
+    const int bucket_count = 64 << sub_bits;
+
+    //spans are buffered per thread and written to the trace file in blocks.
+    const size_t trace_block = 256;
+
+    //trace file record types.
+    const uint8_t record_stage = 0;
+    const uint8_t record_span = 1;
+    const uint8_t record_hop = 2;
+
+    struct Span
+    {
+        uint32_t stage;
+        uint32_t thread;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    struct Hop
+    {
+        uint32_t stage;
+        uint32_t source;
+        uint32_t seq;
+        uint32_t reserved;
+        uint64_t origin;
+        uint64_t at;
+    };
+
+    //histograms of one thread. only the owning thread writes the counters.
+    struct Thread_data
+    {
+        uint32_t thread;
+        std::atomic<uint64_t> counts[max_stages][bucket_count];
+        //longest duration since the previous summary.
+        std::atomic<uint64_t> max[max_stages];
+
+        //spans and hops waiting to be written to the trace file.
+        std::mutex trace_mutex;
+        std::vector<Span> spans;
+        std::vector<Hop> hops;
+    };
+
+    struct Registry
+    {
+        Registry() : tracing(false), file(nullptr), names_written(0) {}
+
+        std::mutex mutex;
+        std::vector<std::string> names;
+        //threads are never removed, so the histograms of finished threads stay in the summaries.
+        std::vector<Thread_data *> threads;
+        //bucket counts at the previous summary.
+        std::vector<uint64_t> reported;
+
+        std::atomic<bool> tracing;
+        std::mutex file_mutex;
+        FILE *file;
+        size_t names_written;
+    };
+
+    Registry &registry()
+    {
+        static Registry *r = new Registry();
+        return *r;
+    }
+
+    Thread_data *threadData()
+    {
+        static thread_local Thread_data *data = nullptr;
+        if (data == nullptr)
+        {
+            data = new Thread_data();
+            for (int s = 0; s < max_stages; s++)
+            {
+                for (int b = 0; b < bucket_count; b++)
+                {
+                    data->counts[s][b].store(0, std::memory_order_relaxed);
+                }
+                data->max[s].store(0, std::memory_order_relaxed);
+            }
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            data->thread = r.threads.size();
+            r.threads.push_back(data);
+        }
+        return data;
+    }
+
+    //map a duration to its histogram bucket.
+    int bucketOf(uint64_t ns)
+    {
+        if (ns < (1u << sub_bits))
+        {
+            return ns;
+        }
+        int exponent = 63 - __builtin_clzll(ns);
+        int sub = (ns >> (exponent - sub_bits)) & ((1 << sub_bits) - 1);
+        return ((exponent - sub_bits + 1) << sub_bits) + sub;
+    }
+
+    //upper bound of a histogram bucket in nanoseconds.
+    double bucketLimit(int bucket)
+    {
+        if (bucket < (1 << sub_bits))
+        {
+            return bucket + 1;
+        }
+        int exponent = (bucket >> sub_bits) + sub_bits - 1;
+        int sub = bucket & ((1 << sub_bits) - 1);
+        return double((uint64_t(1) << exponent) + (uint64_t(sub + 1) << (exponent - sub_bits)));
+    }
+
+    //write stage names registered since the last call. needs the file mutex.
+    void writeNames(Registry &r)
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (; r.names_written < r.names.size(); r.names_written++)
+        {
+            const std::string &name = r.names[r.names_written];
+            uint32_t id = r.names_written;
+            uint32_t length = name.size();
+            fwrite(&record_stage, 1, 1, r.file);
+            fwrite(&id, sizeof(id), 1, r.file);
+            fwrite(&length, sizeof(length), 1, r.file);
+            fwrite(name.data(), 1, length, r.file);
+        }
+    }
+
+    //write the buffered spans and hops of a thread. needs the thread's trace mutex.
+    void flushSpans(Thread_data *data)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.file_mutex);
+        if (r.file != nullptr)
+        {
+            writeNames(r);
+            for (size_t i = 0; i < data->spans.size(); i++)
+            {
+                fwrite(&record_span, 1, 1, r.file);
+                fwrite(&data->spans[i], sizeof(Span), 1, r.file);
+            }
+            for (size_t i = 0; i < data->hops.size(); i++)
+            {
+                fwrite(&record_hop, 1, 1, r.file);
+                fwrite(&data->hops[i], sizeof(Hop), 1, r.file);
+            }
+        }
+        data->spans.clear();
+        data->hops.clear();
+    }
+
+    //count a duration in the histograms of the calling thread.
+    void countDuration(Thread_data *data, int stage_id, uint64_t duration_ns)
+    {
+        //only this thread writes its counters, so a plain load and store is enough.
+        std::atomic<uint64_t> &count = data->counts[stage_id][bucketOf(duration_ns)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (duration_ns > data->max[stage_id].load(std::memory_order_relaxed))
+        {
+            data->max[stage_id].store(duration_ns, std::memory_order_relaxed);
+        }
+    }
+} // namespace
+
+uint64_t Latency_trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int Latency_trace::stage(const std::string &name)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (size_t i = 0; i < r.names.size(); i++)
+    {
+        if (r.names[i] == name)
+        {
+            return i;
+        }
+    }
+    if (r.names.size() == max_stages)
+    {
+        //share the last stage rather than writing out of bounds.
+        return max_stages - 1;
+    }
+    r.names.push_back(name);
+    return r.names.size() - 1;
+}
+
+void Latency_trace::record(int stage_id, uint64_t start_ns, uint64_t duration_ns)
+{
+    Thread_data *data = threadData();
+    countDuration(data, stage_id, duration_ns);
+
+    if (registry().tracing.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(data->trace_mutex);
+        Span span = {uint32_t(stage_id), data->thread, start_ns, duration_ns};
+        data->spans.push_back(span);
+        if (data->spans.size() + data->hops.size() >= trace_block)
+        {
+            flushSpans(data);
+        }
+    }
+}
+
+void Latency_trace::hop(int stage_id, int source_id, uint32_t seq, uint64_t origin_ns, uint64_t at_ns)
+{
+    Thread_data *data = threadData();
+    //the clock of another node may be a little behind.
+    countDuration(data, stage_id, at_ns > origin_ns ? at_ns - origin_ns : 0);
+
+    if (registry().tracing.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(data->trace_mutex);
+        Hop hop = {uint32_t(stage_id), uint32_t(source_id), seq, 0, origin_ns, at_ns};
+        data->hops.push_back(hop);
+        if (data->spans.size() + data->hops.size() >= trace_block)
+        {
+            flushSpans(data);
+        }
+    }
+}
+
+std::vector<Stage_summary> Latency_trace::summarize()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.reported.resize(max_stages * bucket_count, 0);
+
+    std::vector<Stage_summary> summaries;
+    std::vector<uint64_t> merged(bucket_count);
+    for (size_t s = 0; s < r.names.size(); s++)
+    {
+        //merge the histograms of all threads, and subtract what was already reported.
+        uint64_t total = 0;
+        uint64_t max = 0;
+        for (int b = 0; b < bucket_count; b++)
+        {
+            uint64_t sum = 0;
+            for (size_t t = 0; t < r.threads.size(); t++)
+            {
+                sum += r.threads[t]->counts[s][b].load(std::memory_order_relaxed);
+            }
+            uint64_t &reported = r.reported[s * bucket_count + b];
+            merged[b] = sum - reported;
+            reported = sum;
+            total += merged[b];
+        }
+        for (size_t t = 0; t < r.threads.size(); t++)
+        {
+            //reset the maximum for the next period. a duration recorded at the same moment may be lost from it.
+            uint64_t thread_max = r.threads[t]->max[s].exchange(0, std::memory_order_relaxed);
+            max = thread_max > max ? thread_max : max;
+        }
+        if (total == 0)
+        {
+            continue;
+        }
+
+        Stage_summary summary;
+        summary.name = r.names[s];
+        summary.count = total;
+        summary.max = max / 1e6;
+        double *percentiles[] = {&summary.p50, &summary.p90, &summary.p99};
+        double fractions[] = {0.50, 0.90, 0.99};
+        for (int p = 0; p < 3; p++)
+        {
+            uint64_t rank = uint64_t(fractions[p] * (total - 1));
+            uint64_t seen = 0;
+            int b = 0;
+            while (seen + merged[b] <= rank)
+            {
+                seen += merged[b];
+                b++;
+            }
+            //the bucket limit can overshoot the longest duration actually recorded.
+            double limit = bucketLimit(b) / 1e6;
+            *percentiles[p] = limit < summary.max ? limit : summary.max;
+        }
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+bool Latency_trace::open_trace(const std::string &path)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.file_mutex);
+    if (r.file != nullptr)
+    {
+        return false;
+    }
+    r.file = fopen(path.c_str(), "wb");
+    if (r.file == nullptr)
+    {
+        return false;
+    }
+    const char magic[8] = {'M', 'D', 'T', 'R', 'A', 'C', 'E', '1'};
+    fwrite(magic, 1, sizeof(magic), r.file);
+    r.names_written = 0;
+    r.tracing.store(true);
+    return true;
+}
+
+void Latency_trace::close_trace()
+{
+    Registry &r = registry();
+    r.tracing.store(false);
+
+    std::vector<Thread_data *> threads;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        threads = r.threads;
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+    {
+        std::lock_guard<std::mutex> lock(threads[t]->trace_mutex);
+        flushSpans(threads[t]);
+    }
+
+    std::lock_guard<std::mutex> lock(r.file_mutex);
+    if (r.file != nullptr)
+    {
+        fclose(r.file);
+        r.file = nullptr;
+    }
+}
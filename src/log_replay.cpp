@@ -0,0 +1,149 @@
+#include "ros/ros.h"
+#include "rosgraph_msgs/Clock.h"
+#include "sensor_msgs/LaserScan.h"
+#include <nav_msgs/Odometry.h>
+#include <math.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mission_log.h>
+
+//replays mission logs into the nodes, with the ROS clock set to the time of the records. the nodes need
+///use_sim_time, the cameras of paper_detection read their frames from the logs with "log:" sources.
+//usage: rosrun mine_detection log_replay path_basis.mdlog laser.mdlog _rate:=0 _start:=30
+//~rate is the speed of the replay, 1 is the speed of the run and 0 as fast as the logs can be read.
+//~start is the time to start at, in seconds after the start of the logs.
+
+ros::Publisher clock_pub;
+ros::Publisher odom_pub;
+ros::Publisher scan_pub;
+
+//publish the pose of an odometry record, the way the mobile base does.
+void publishOdom(const Mission_log::Record &record)
+{
+    nav_msgs::Odometry msg;
+    msg.header.stamp.fromSec(record.stamp);
+    msg.header.frame_id = "odom";
+    msg.child_frame_id = "base_footprint";
+    msg.pose.pose.position.x = record.odom.x;
+    msg.pose.pose.position.y = record.odom.y;
+    msg.pose.pose.orientation.z = sin(record.odom.theta / 2);
+    msg.pose.pose.orientation.w = cos(record.odom.theta / 2);
+    odom_pub.publish(msg);
+}
+
+void publishScan(const Mission_log::Record &record)
+{
+    sensor_msgs::LaserScan msg;
+    msg.header.stamp.fromSec(record.stamp);
+    msg.header.frame_id = "camera_depth_frame";
+    msg.angle_min = record.scan.angleMin;
+    msg.angle_increment = record.scan.angleIncrement;
+    msg.angle_max = record.scan.angleMin + record.scan.angleIncrement * (record.scan.count - 1);
+    msg.range_min = record.scan.rangeMin;
+    msg.range_max = record.scan.rangeMax;
+    msg.ranges.resize(record.scan.count);
+    for (int i = 0; i < record.scan.count; i++)
+    {
+        msg.ranges[i] = record.scan.range(i);
+    }
+    scan_pub.publish(msg);
+}
+
+int main(int argc, char *argv[])
+{
+    ros::init(argc, argv, "log_replay");
+    ros::NodeHandle n;
+
+    double rate;
+    double start;
+    ros::NodeHandle("~").param("rate", rate, 1.0);
+    ros::NodeHandle("~").param("start", start, 0.0);
+
+    //the logs of all nodes of a run, replayed together in the order of their stamps.
+    std::vector<std::unique_ptr<Mission_log::log_Reader>> logs;
+    double begin = INFINITY;
+    size_t bytes = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::unique_ptr<Mission_log::log_Reader> log(new Mission_log::log_Reader());
+        if (!log->open(argv[i]))
+        {
+            ROS_ERROR("%s is not a mission log.", argv[i]);
+            return 1;
+        }
+        begin = std::min(begin, log->begin());
+        bytes += log->size();
+        logs.push_back(std::move(log));
+    }
+    if (logs.empty())
+    {
+        ROS_ERROR("Usage: log_replay LOG...");
+        return 1;
+    }
+
+    clock_pub = n.advertise<rosgraph_msgs::Clock>("/clock", 10);
+    odom_pub = n.advertise<nav_msgs::Odometry>("odom", 100);
+    scan_pub = n.advertise<sensor_msgs::LaserScan>("scan", 100);
+
+    //the next record of every log.
+    std::vector<Mission_log::Record> pending(logs.size());
+    std::vector<bool> has(logs.size());
+    for (size_t l = 0; l < logs.size(); l++)
+    {
+        logs[l]->seek(begin + start);
+        has[l] = logs[l]->next(pending[l]);
+    }
+
+    //give the nodes time to connect, a replay at full speed would be over before they are.
+    ros::WallDuration(1.0).sleep();
+
+    ros::WallTime wall_start = ros::WallTime::now();
+    double log_start = begin + start;
+    size_t records = 0;
+    while (ros::ok())
+    {
+        //the log with the oldest pending record.
+        int next = -1;
+        for (size_t l = 0; l < logs.size(); l++)
+        {
+            if (has[l] && (next < 0 || pending[l].stamp < pending[next].stamp))
+            {
+                next = l;
+            }
+        }
+        if (next < 0)
+        {
+            break;
+        }
+        const Mission_log::Record &record = pending[next];
+
+        if (rate > 0)
+        {
+            ros::WallDuration wait((record.stamp - log_start) / rate - (ros::WallTime::now() - wall_start).toSec());
+            if (wait.toSec() > 0)
+            {
+                wait.sleep();
+            }
+        }
+
+        rosgraph_msgs::Clock clock;
+        clock.clock.fromSec(record.stamp);
+        clock_pub.publish(clock);
+        //frames are read by the cameras from the log, the clock tells them which one is due.
+        if (record.type == Mission_log::RECORD_ODOM)
+        {
+            publishOdom(record);
+        }
+        else if (record.type == Mission_log::RECORD_SCAN)
+        {
+            publishScan(record);
+        }
+        records++;
+        has[next] = logs[next]->next(pending[next]);
+    }
+
+    double seconds = (ros::WallTime::now() - wall_start).toSec();
+    ROS_INFO("Replayed %zu records in %.2f s, %.1f MB of logs.", records, seconds, bytes / 1e6);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "marker_sidecar.h"
+#include <visualization_msgs/MarkerArray.h>
+
+using namespace Marker_sidecar;
+
+void marker_Sidecar::start(ros::NodeHandle &n)
+{
+    double rate;
+    ros::NodeHandle("~").param("marker_rate", rate, 5.0);
+    if (rate <= 0)
+    {
+        return;
+    }
+
+    marker_pub = n.advertise<visualization_msgs::MarkerArray>("/visualization_marker_array", 10);
+    running = true;
+    thread = std::thread(&marker_Sidecar::run, this, rate);
+}
+
+void marker_Sidecar::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+marker_Sidecar::~marker_Sidecar()
+{
+    stop();
+}
+
+void marker_Sidecar::update(visualization_msgs::Marker &marker)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running)
+    {
+        return;
+    }
+
+    Entry &entry = markers[std::make_pair(marker.ns, marker.id)];
+    entry.marker = std::move(marker);
+    if (!entry.dirty)
+    {
+        entry.dirty = true;
+        dirty_count++;
+    }
+}
+
+void marker_Sidecar::run(double rate)
+{
+    const std::chrono::duration<double> period(1.0 / rate);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running)
+    {
+        wake.wait_for(lock, period);
+        if (!running)
+        {
+            break;
+        }
+
+        //without subscribers the markers are kept, and all of them are sent to the next subscriber.
+        lock.unlock();
+        bool now_subscribed = marker_pub.getNumSubscribers() != 0;
+        lock.lock();
+        if (!now_subscribed)
+        {
+            subscribed.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        if (!subscribed.load(std::memory_order_relaxed))
+        {
+            subscribed.store(true, std::memory_order_relaxed);
+            for (std::map<std::pair<std::string, int>, Entry>::iterator it = markers.begin(); it != markers.end(); ++it)
+            {
+                it->second.dirty = true;
+            }
+            dirty_count = markers.size();
+        }
+        if (dirty_count == 0)
+        {
+            continue;
+        }
+
+        //copy the changed markers, so the publishing does not hold up update().
+        visualization_msgs::MarkerArray array;
+        array.markers.reserve(dirty_count);
+        for (std::map<std::pair<std::string, int>, Entry>::iterator it = markers.begin(); it != markers.end(); ++it)
+        {
+            if (it->second.dirty)
+            {
+                array.markers.push_back(it->second.marker);
+                it->second.dirty = false;
+            }
+        }
+        dirty_count = 0;
+
+        lock.unlock();
+        marker_pub.publish(array);
+        lock.lock();
+    }
+}
@@ -0,0 +1,540 @@
+#include "mission_log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Mission_log;
+
+namespace
+{
+    const uint32_t version = 1;
+    const char logMagic[8] = {'M', 'D', 'L', 'O', 'G', 'V', '0', '1'};
+    const char chunkMagic[4] = {'C', 'H', 'N', 'K'};
+    const char indexMagic[8] = {'M', 'D', 'L', 'O', 'G', 'I', 'D', 'X'};
+
+    //a chunk is written when it holds this many bytes or this many seconds.
+    const size_t chunkBytes = 1 << 20;
+    const double chunkSeconds = 1.0;
+
+    struct Log_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    //followed by the records of the chunk.
+    struct Chunk_header
+    {
+        char magic[4];
+        uint32_t bytes;
+        uint32_t records;
+        uint32_t streams;
+        //stamps of the records are microseconds after base.
+        double base;
+        double first;
+        double last;
+    };
+
+    struct Index_entry
+    {
+        uint64_t offset;
+        double first;
+        double last;
+    };
+
+    //the index entries come before it, at indexOffset.
+    struct Log_footer
+    {
+        uint64_t indexOffset;
+        uint32_t chunks;
+        uint32_t reserved;
+        char magic[8];
+    };
+
+    void putVarint(std::vector<uint8_t> &bytes, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back(uint8_t(value) | 0x80);
+            value >>= 7;
+        }
+        bytes.push_back(uint8_t(value));
+    }
+
+    //small negative deltas are small numbers too.
+    void putSigned(std::vector<uint8_t> &bytes, int64_t value)
+    {
+        putVarint(bytes, (uint64_t(value) << 1) ^ uint64_t(value >> 63));
+    }
+
+    void putBytes(std::vector<uint8_t> &bytes, const void *data, size_t size)
+    {
+        const uint8_t *begin = static_cast<const uint8_t *>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+
+    //the decoders return false past the end of the chunk.
+    bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7)
+        {
+            uint8_t byte = *p++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool getSigned(const uint8_t *&p, const uint8_t *end, int64_t &value)
+    {
+        uint64_t zigzag;
+        if (!getVarint(p, end, zigzag))
+        {
+            return false;
+        }
+        value = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+        return true;
+    }
+
+    bool getBytes(const uint8_t *&p, const uint8_t *end, void *data, size_t size)
+    {
+        if (size_t(end - p) < size)
+        {
+            return false;
+        }
+        std::memcpy(data, p, size);
+        p += size;
+        return true;
+    }
+
+    //millimeters and 1e-4 radians of the odometry.
+    const double odomScale[3] = {1e3, 1e3, 1e4};
+} // namespace
+
+float Scan::range(int i) const
+{
+    uint16_t mm = ranges[2 * i] | (ranges[2 * i + 1] << 8);
+    if (mm == 0)
+    {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    if (mm == 0xffff)
+    {
+        return std::numeric_limits<float>::infinity();
+    }
+    return mm * 0.001f;
+}
+
+bool log_Writer::open(const std::string &path)
+{
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    Log_header header = {};
+    std::memcpy(header.magic, logMagic, sizeof(logMagic));
+    header.version = version;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        std::fclose(file);
+        file = NULL;
+        return false;
+    }
+    offset = sizeof(header);
+    index.clear();
+    chunks = 0;
+    current = Chunk();
+    closing = false;
+    writer = std::thread(&log_Writer::writeLoop, this);
+    return true;
+}
+
+void log_Writer::begin(int type, double stamp)
+{
+    if (current.records > 0 && (current.bytes.size() >= chunkBytes || std::fabs(stamp - current.base) >= chunkSeconds))
+    {
+        queueChunk();
+    }
+    if (current.records == 0)
+    {
+        current.base = current.first = current.last = stamp;
+    }
+    current.first = std::min(current.first, stamp);
+    current.last = std::max(current.last, stamp);
+    current.records++;
+    current.streams |= 1u << type;
+
+    int64_t micros = std::llround((stamp - current.base) * 1e6);
+    current.bytes.push_back(uint8_t(type));
+    putSigned(current.bytes, micros - current.stamp);
+    current.stamp = micros;
+}
+
+void log_Writer::odom(double stamp, double x, double y, double theta)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == NULL)
+    {
+        return;
+    }
+    begin(RECORD_ODOM, stamp);
+    double values[3] = {x, y, theta};
+    for (int i = 0; i < 3; i++)
+    {
+        int64_t quantized = std::llround(values[i] * odomScale[i]);
+        putSigned(current.bytes, quantized - current.odom[i]);
+        current.odom[i] = quantized;
+    }
+}
+
+void log_Writer::scan(double stamp, float angleMin, float angleIncrement, float rangeMin, float rangeMax, const std::vector<float> &ranges)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == NULL)
+    {
+        return;
+    }
+    begin(RECORD_SCAN, stamp);
+    float angles[4] = {angleMin, angleIncrement, rangeMin, rangeMax};
+    putBytes(current.bytes, angles, sizeof(angles));
+    putVarint(current.bytes, ranges.size());
+    size_t at = current.bytes.size();
+    current.bytes.resize(at + 2 * ranges.size());
+    uint8_t *out = &current.bytes[at];
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        //no return, NaN or 0, is 0 and a range past the last millimeter is 0xffff.
+        uint16_t mm = !(ranges[i] > 0) ? 0 : ranges[i] >= 65.535f ? 0xffff : uint16_t(std::max(1.0f, std::round(ranges[i] * 1000)));
+        out[2 * i] = uint8_t(mm);
+        out[2 * i + 1] = uint8_t(mm >> 8);
+    }
+}
+
+void log_Writer::frame(double stamp, const std::string &camera, int format, int width, int height, const uint8_t *data, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == NULL)
+    {
+        return;
+    }
+    begin(RECORD_FRAME, stamp);
+    putVarint(current.bytes, camera.size());
+    putBytes(current.bytes, camera.data(), camera.size());
+    putVarint(current.bytes, format);
+    putVarint(current.bytes, width);
+    putVarint(current.bytes, height);
+    putVarint(current.bytes, bytes);
+    putBytes(current.bytes, data, bytes);
+}
+
+void log_Writer::queueChunk()
+{
+    full.push_back(std::move(current));
+    current = Chunk();
+    queued.notify_one();
+}
+
+void log_Writer::writeLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        queued.wait(lock, [this] { return closing || !full.empty(); });
+        if (full.empty())
+        {
+            return;
+        }
+        Chunk chunk = std::move(full.front());
+        full.pop_front();
+        lock.unlock();
+
+        //the chunks stay 8 byte aligned in the mapping, the padding reads as the end of the chunk.
+        chunk.bytes.resize((chunk.bytes.size() + 7) & ~size_t(7), 0);
+
+        Chunk_header header;
+        std::memcpy(header.magic, chunkMagic, sizeof(chunkMagic));
+        header.bytes = chunk.bytes.size();
+        header.records = chunk.records;
+        header.streams = chunk.streams;
+        header.base = chunk.base;
+        header.first = chunk.first;
+        header.last = chunk.last;
+        //the chunk is flushed whole, a crash loses at most the chunks not written yet.
+        if (std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(chunk.bytes.data(), 1, chunk.bytes.size(), file) == chunk.bytes.size())
+        {
+            std::fflush(file);
+            Index_entry entry = {offset, chunk.first, chunk.last};
+            putBytes(index, &entry, sizeof(entry));
+            chunks++;
+            offset += sizeof(header) + chunk.bytes.size();
+        }
+
+        lock.lock();
+    }
+}
+
+void log_Writer::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file == NULL)
+        {
+            return;
+        }
+        if (current.records > 0)
+        {
+            queueChunk();
+        }
+        closing = true;
+        queued.notify_one();
+    }
+    writer.join();
+
+    Log_footer footer = {};
+    footer.indexOffset = offset;
+    footer.chunks = chunks;
+    std::memcpy(footer.magic, indexMagic, sizeof(indexMagic));
+    std::fwrite(index.data(), 1, index.size(), file);
+    std::fwrite(&footer, sizeof(footer), 1, file);
+    std::fclose(file);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    file = NULL;
+}
+
+bool log_Reader::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(Log_header))
+    {
+        ::close(fd);
+        return false;
+    }
+    //a private mapping, so the frames can be used in place by code that expects writable images.
+    void *start = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (start == MAP_FAILED)
+    {
+        return false;
+    }
+    map = static_cast<uint8_t *>(start);
+    length = info.st_size;
+
+    const Log_header *header = reinterpret_cast<const Log_header *>(map);
+    if (std::memcmp(header->magic, logMagic, sizeof(logMagic)) != 0 || header->version != version)
+    {
+        close();
+        return false;
+    }
+
+    //the index of a closed log, otherwise walk the chunks that were written whole.
+    const Log_footer *footer = reinterpret_cast<const Log_footer *>(map + length - sizeof(Log_footer));
+    if (length >= sizeof(Log_header) + sizeof(Log_footer) && std::memcmp(footer->magic, indexMagic, sizeof(indexMagic)) == 0 &&
+        footer->indexOffset + footer->chunks * sizeof(Index_entry) + sizeof(Log_footer) == length)
+    {
+        const Index_entry *entries = reinterpret_cast<const Index_entry *>(map + footer->indexOffset);
+        for (uint32_t c = 0; c < footer->chunks; c++)
+        {
+            Entry entry = {entries[c].offset, entries[c].first, entries[c].last};
+            chunks.push_back(entry);
+        }
+    }
+    else
+    {
+        size_t at = sizeof(Log_header);
+        while (at + sizeof(Chunk_header) <= length)
+        {
+            const Chunk_header *chunkHeader = reinterpret_cast<const Chunk_header *>(map + at);
+            if (std::memcmp(chunkHeader->magic, chunkMagic, sizeof(chunkMagic)) != 0 || at + sizeof(Chunk_header) + chunkHeader->bytes > length)
+            {
+                break;
+            }
+            Entry entry = {at, chunkHeader->first, chunkHeader->last};
+            chunks.push_back(entry);
+            at += sizeof(Chunk_header) + chunkHeader->bytes;
+        }
+    }
+    seek(-std::numeric_limits<double>::infinity());
+    return true;
+}
+
+void log_Reader::close()
+{
+    if (map)
+    {
+        munmap(map, length);
+        map = NULL;
+        length = 0;
+    }
+    chunks.clear();
+    position = chunkEnd = NULL;
+}
+
+double log_Reader::begin() const
+{
+    double first = std::numeric_limits<double>::infinity();
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        first = std::min(first, chunks[c].first);
+    }
+    return first;
+}
+
+double log_Reader::end() const
+{
+    double last = -std::numeric_limits<double>::infinity();
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        last = std::max(last, chunks[c].last);
+    }
+    return last;
+}
+
+void log_Reader::seek(double stamp)
+{
+    //chunks are in logging order, the first one reaching the stamp holds the first record at or after it.
+    chunk = 0;
+    while (chunk < chunks.size() && chunks[chunk].last < stamp)
+    {
+        chunk++;
+    }
+    position = chunkEnd = NULL;
+    skipBefore = stamp;
+}
+
+void log_Reader::enterChunk(size_t c)
+{
+    const Chunk_header *header = reinterpret_cast<const Chunk_header *>(map + chunks[c].offset);
+    position = reinterpret_cast<const uint8_t *>(header + 1);
+    chunkEnd = position + header->bytes;
+    base = header->base;
+    stamp = 0;
+    odom[0] = odom[1] = odom[2] = 0;
+}
+
+bool log_Reader::next(Record &record)
+{
+    while (true)
+    {
+        if (position == chunkEnd)
+        {
+            if (chunk >= chunks.size())
+            {
+                return false;
+            }
+            enterChunk(chunk++);
+            continue;
+        }
+
+        const uint8_t *p = position;
+        int64_t delta;
+        record.type = *p++;
+        bool ok = getSigned(p, chunkEnd, delta);
+        stamp += delta;
+        record.stamp = base + stamp * 1e-6;
+        if (ok && record.type == RECORD_ODOM)
+        {
+            for (int i = 0; ok && i < 3; i++)
+            {
+                ok = getSigned(p, chunkEnd, delta);
+                odom[i] += delta;
+            }
+            record.odom.x = odom[0] / odomScale[0];
+            record.odom.y = odom[1] / odomScale[1];
+            record.odom.theta = odom[2] / odomScale[2];
+        }
+        else if (ok && record.type == RECORD_SCAN)
+        {
+            float angles[4];
+            uint64_t count;
+            ok = getBytes(p, chunkEnd, angles, sizeof(angles)) && getVarint(p, chunkEnd, count) && size_t(chunkEnd - p) / 2 >= count;
+            if (ok)
+            {
+                record.scan.angleMin = angles[0];
+                record.scan.angleIncrement = angles[1];
+                record.scan.rangeMin = angles[2];
+                record.scan.rangeMax = angles[3];
+                record.scan.count = count;
+                record.scan.ranges = p;
+                p += 2 * count;
+            }
+        }
+        else if (ok && record.type == RECORD_FRAME)
+        {
+            uint64_t name, format, width, height, bytes;
+            ok = getVarint(p, chunkEnd, name) && size_t(chunkEnd - p) >= name;
+            if (ok)
+            {
+                record.frame.camera.assign(reinterpret_cast<const char *>(p), name);
+                p += name;
+                ok = getVarint(p, chunkEnd, format) && getVarint(p, chunkEnd, width) && getVarint(p, chunkEnd, height) &&
+                     getVarint(p, chunkEnd, bytes) && size_t(chunkEnd - p) >= bytes;
+            }
+            if (ok)
+            {
+                record.frame.format = format;
+                record.frame.width = width;
+                record.frame.height = height;
+                record.frame.bytes = bytes;
+                record.frame.data = p;
+                p += bytes;
+            }
+        }
+        else
+        {
+            ok = false;
+        }
+
+        //a damaged chunk, or its padding, is left, the next one starts its deltas again.
+        if (!ok)
+        {
+            position = chunkEnd;
+            continue;
+        }
+        position = p;
+        if (record.stamp >= skipBefore)
+        {
+            skipBefore = -std::numeric_limits<double>::infinity();
+            return true;
+        }
+    }
+}
+
+std::string Mission_log::startPath(const std::string &path)
+{
+    char start[64];
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    size_t length = strftime(start, sizeof(start), "-%Y%m%d-%H%M%S", &local);
+    snprintf(start + length, sizeof(start) - length, "-%d", int(getpid()));
+
+    //the extension is the part of the file name after its last dot.
+    size_t name = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (name != std::string::npos && dot < name) || dot == (name == std::string::npos ? 0 : name + 1))
+    {
+        return path + start;
+    }
+    return path.substr(0, dot) + start + path.substr(dot);
+}
@@ -0,0 +1,423 @@
+#include "mission_state.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Mission_state;
+using Points_gen::Point;
+
+namespace
+{
+    //bump the version when a record changes, files of other versions are not resumed.
+    const uint32_t version = 1;
+    const char missionMagic[8] = {'M', 'D', 'M', 'I', 'S', 'S', 'N', '1'};
+    const char mineMagic[8] = {'M', 'D', 'M', 'I', 'N', 'E', 'S', '1'};
+
+    //FNV-1a, enough to find a torn record.
+    uint32_t checksum(const void *data, size_t size, uint32_t hash = 2166136261u)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    //a record written to two slots in turn. the slot with the highest sequence and a good checksum is the newest.
+    template <typename Record>
+    struct Slot
+    {
+        uint64_t sequence;
+        Record record;
+        uint32_t checksum;
+
+        uint32_t sum() const { return ::checksum(&record, sizeof(record), ::checksum(&sequence, sizeof(sequence))); }
+    };
+
+    template <typename Record>
+    void writeSlot(Slot<Record> slots[2], uint64_t &sequence, const Record &record)
+    {
+        //the slot of the older record is overwritten, the newest stays valid until the checksum is written.
+        Slot<Record> &slot = slots[++sequence & 1];
+        slot.checksum = 0;
+        slot.record = record;
+        slot.sequence = sequence;
+        slot.checksum = slot.sum();
+    }
+
+    //the newest valid slot, NULL if there is none.
+    template <typename Record>
+    const Slot<Record> *readSlot(const Slot<Record> slots[2])
+    {
+        const Slot<Record> *newest = NULL;
+        for (int i = 0; i < 2; i++)
+        {
+            if (slots[i].sequence != 0 && slots[i].checksum == slots[i].sum() &&
+                (!newest || slots[i].sequence > newest->sequence))
+            {
+                newest = &slots[i];
+            }
+        }
+        return newest;
+    }
+
+    struct Mission_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t finished;
+        Field field;
+        int32_t rows;
+        int32_t wordsPerRow;
+        int32_t cols;
+        int32_t padding;
+        Slot<Progress> progress[2];
+        //the path follows the coverage words at the end of the file, so it can grow.
+        uint64_t coverageOffset;
+        uint64_t pathOffset;
+    };
+
+    //followed by the points and the spans.
+    struct Path_header
+    {
+        uint64_t sequence;
+        uint32_t points;
+        uint32_t spans;
+        uint32_t checksum;
+    };
+
+    struct Mine_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t capacity;
+        Slot<Pose> pose[2];
+    };
+
+    //record id of the mine file, unused records have 0 hits.
+    struct Mine_record
+    {
+        Detection_map::Detection detection;
+        uint32_t checksum;
+    };
+
+    uint32_t pathChecksum(const Path_header &header, const uint8_t *data, size_t size)
+    {
+        uint32_t hash = checksum(&header.sequence, sizeof(header.sequence));
+        hash = checksum(&header.points, sizeof(header.points), hash);
+        hash = checksum(&header.spans, sizeof(header.spans), hash);
+        return checksum(data, size, hash);
+    }
+
+    size_t pathBytes(size_t points, size_t spans)
+    {
+        return sizeof(Path_header) + points * sizeof(Point) + spans * sizeof(Path_plan::Span);
+    }
+
+    const size_t mineCapacity = 64;
+} // namespace
+
+bool mapped_File::open(const std::string &path, size_t size, bool truncate)
+{
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close();
+        return false;
+    }
+    //an existing file keeps its size if it is larger.
+    if (size_t(info.st_size) >= size)
+    {
+        size = info.st_size;
+    }
+    else if (ftruncate(fd, size) != 0)
+    {
+        close();
+        return false;
+    }
+    void *start = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (start == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    map = static_cast<uint8_t *>(start);
+    length = size;
+    return true;
+}
+
+bool mapped_File::resize(size_t size)
+{
+    if (size <= length)
+    {
+        return true;
+    }
+    if (ftruncate(fd, size) != 0)
+    {
+        return false;
+    }
+    void *start = mremap(map, length, size, MREMAP_MAYMOVE);
+    if (start == MAP_FAILED)
+    {
+        return false;
+    }
+    map = static_cast<uint8_t *>(start);
+    length = size;
+    return true;
+}
+
+void mapped_File::sync()
+{
+    if (map)
+    {
+        msync(map, length, MS_SYNC);
+    }
+}
+
+void mapped_File::close()
+{
+    if (map)
+    {
+        munmap(map, length);
+        map = NULL;
+        length = 0;
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool mission_File::create(const std::string &path, const Field &field, const Coverage_map::coverage_Map &coverage)
+{
+    const Bit_mask::bit_Mask &cells = coverage.covered();
+    size_t coverageBytes = cells.words.size() * sizeof(uint64_t);
+    size_t pathOffset = sizeof(Mission_header) + coverageBytes;
+    if (!file.open(path, pathOffset + pathBytes(0, 0), true))
+    {
+        return false;
+    }
+
+    Mission_header *header = reinterpret_cast<Mission_header *>(file.data());
+    header->version = version;
+    header->field = field;
+    header->rows = cells.rows;
+    header->wordsPerRow = cells.wordsPerRow;
+    header->cols = cells.cols;
+    header->coverageOffset = sizeof(Mission_header);
+    header->pathOffset = pathOffset;
+    std::memcpy(file.data() + header->coverageOffset, cells.words.data(), coverageBytes);
+    //the magic goes last, a file cut short while it is created is not resumed.
+    std::memcpy(header->magic, missionMagic, sizeof(missionMagic));
+    progressSequence = 0;
+    pathSequence = 0;
+    file.sync();
+    return true;
+}
+
+bool mission_File::open(const std::string &path, const Field &field)
+{
+    if (access(path.c_str(), F_OK) != 0 || !file.open(path, 0, false))
+    {
+        return false;
+    }
+    const Mission_header *header = reinterpret_cast<const Mission_header *>(file.data());
+    bool valid = file.size() >= sizeof(Mission_header) && std::memcmp(header->magic, missionMagic, sizeof(missionMagic)) == 0 &&
+                 header->version == version && !header->finished &&
+                 header->field.length == field.length && header->field.width == field.width && header->field.resolution == field.resolution &&
+                 header->pathOffset == header->coverageOffset + size_t(header->rows) * header->wordsPerRow * sizeof(uint64_t) &&
+                 file.size() >= header->pathOffset + sizeof(Path_header);
+    if (!valid)
+    {
+        file.close();
+        return false;
+    }
+    const Slot<Progress> *progress = readSlot(header->progress);
+    progressSequence = progress ? progress->sequence : 0;
+    pathSequence = reinterpret_cast<const Path_header *>(file.data() + header->pathOffset)->sequence;
+    return true;
+}
+
+Field mission_File::field() const
+{
+    return reinterpret_cast<const Mission_header *>(file.data())->field;
+}
+
+bool mission_File::loadProgress(Progress &progress) const
+{
+    const Slot<Progress> *slot = readSlot(reinterpret_cast<const Mission_header *>(file.data())->progress);
+    if (!slot)
+    {
+        return false;
+    }
+    progress = slot->record;
+    return true;
+}
+
+bool mission_File::loadPath(Path_plan::lane_Path &path) const
+{
+    const Mission_header *header = reinterpret_cast<const Mission_header *>(file.data());
+    const Path_header *saved = reinterpret_cast<const Path_header *>(file.data() + header->pathOffset);
+    if (saved->sequence == 0 || file.size() < header->pathOffset + pathBytes(saved->points, saved->spans))
+    {
+        return false;
+    }
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(saved + 1);
+    if (saved->checksum != pathChecksum(*saved, data, pathBytes(saved->points, saved->spans) - sizeof(Path_header)))
+    {
+        return false;
+    }
+    const Point *points = reinterpret_cast<const Point *>(data);
+    const Path_plan::Span *spans = reinterpret_cast<const Path_plan::Span *>(points + saved->points);
+    path = Path_plan::lane_Path(std::vector<Point>(points, points + saved->points), std::vector<Path_plan::Span>(spans, spans + saved->spans));
+    return true;
+}
+
+void mission_File::loadCoverage(Coverage_map::coverage_Map &coverage) const
+{
+    const Mission_header *header = reinterpret_cast<const Mission_header *>(file.data());
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(file.data() + header->coverageOffset);
+    coverage.merge(header->rows, header->cols, std::vector<uint64_t>(words, words + size_t(header->rows) * header->wordsPerRow));
+}
+
+void mission_File::saveProgress(const Progress &progress)
+{
+    writeSlot(reinterpret_cast<Mission_header *>(file.data())->progress, progressSequence, progress);
+}
+
+void mission_File::savePath(const Path_plan::lane_Path &path)
+{
+    std::vector<Point> points;
+    std::vector<Path_plan::Span> spans;
+    path.compact(points, spans);
+
+    size_t pathOffset = reinterpret_cast<Mission_header *>(file.data())->pathOffset;
+    if (!file.resize(pathOffset + pathBytes(points.size(), spans.size())))
+    {
+        return;
+    }
+    //the header is written after the points, a path cut short has the wrong checksum.
+    Path_header *saved = reinterpret_cast<Path_header *>(file.data() + pathOffset);
+    uint8_t *data = reinterpret_cast<uint8_t *>(saved + 1);
+    saved->checksum = 0;
+    std::memcpy(data, points.data(), points.size() * sizeof(Point));
+    std::memcpy(data + points.size() * sizeof(Point), spans.data(), spans.size() * sizeof(Path_plan::Span));
+    saved->sequence = ++pathSequence;
+    saved->points = points.size();
+    saved->spans = spans.size();
+    saved->checksum = pathChecksum(*saved, data, pathBytes(points.size(), spans.size()) - sizeof(Path_header));
+}
+
+void mission_File::saveCoverage(Coverage_map::coverage_Map &coverage)
+{
+    int begin, end;
+    coverage.takeChanged(begin, end);
+    if (begin == end)
+    {
+        return;
+    }
+    //cells are only ever set, a torn row loses a little coverage and nothing else.
+    const Mission_header *header = reinterpret_cast<const Mission_header *>(file.data());
+    const Bit_mask::bit_Mask &cells = coverage.covered();
+    uint64_t *words = reinterpret_cast<uint64_t *>(file.data() + header->coverageOffset);
+    std::memcpy(words + size_t(begin) * cells.wordsPerRow, cells.row(begin), size_t(end - begin) * cells.wordsPerRow * sizeof(uint64_t));
+}
+
+void mission_File::finish()
+{
+    reinterpret_cast<Mission_header *>(file.data())->finished = 1;
+    file.sync();
+}
+
+bool mine_File::open(const std::string &path, bool resume)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (resume && access(path.c_str(), F_OK) == 0 && file.open(path, 0, false))
+    {
+        const Mine_header *header = reinterpret_cast<const Mine_header *>(file.data());
+        if (file.size() >= sizeof(Mine_header) && std::memcmp(header->magic, mineMagic, sizeof(mineMagic)) == 0 &&
+            header->version == version && file.size() >= sizeof(Mine_header) + header->capacity * sizeof(Mine_record))
+        {
+            const Slot<Pose> *pose = readSlot(header->pose);
+            poseSequence = pose ? pose->sequence : 0;
+            return true;
+        }
+    }
+
+    if (!file.open(path, sizeof(Mine_header) + mineCapacity * sizeof(Mine_record), true))
+    {
+        return false;
+    }
+    Mine_header *header = reinterpret_cast<Mine_header *>(file.data());
+    header->version = version;
+    header->capacity = mineCapacity;
+    std::memcpy(header->magic, mineMagic, sizeof(mineMagic));
+    poseSequence = 0;
+    return true;
+}
+
+std::vector<Detection_map::Detection> mine_File::loadMines() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const Mine_header *header = reinterpret_cast<const Mine_header *>(file.data());
+    const Mine_record *records = reinterpret_cast<const Mine_record *>(header + 1);
+    std::vector<Detection_map::Detection> mines;
+    for (uint32_t i = 0; i < header->capacity; i++)
+    {
+        const Mine_record &record = records[i];
+        if (record.detection.hits > 0 && record.checksum == checksum(&record.detection, sizeof(record.detection)))
+        {
+            mines.push_back(record.detection);
+            mines.back().id = mines.size() - 1;
+        }
+    }
+    return mines;
+}
+
+bool mine_File::loadPose(Pose &pose) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const Slot<Pose> *slot = readSlot(reinterpret_cast<const Mine_header *>(file.data())->pose);
+    if (!slot)
+    {
+        return false;
+    }
+    pose = slot->record;
+    return true;
+}
+
+void mine_File::saveMine(const Detection_map::Detection &detection)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t capacity = reinterpret_cast<Mine_header *>(file.data())->capacity;
+    if (uint32_t(detection.id) >= capacity)
+    {
+        capacity = std::max(2 * capacity, uint32_t(detection.id) + 1);
+        if (!file.resize(sizeof(Mine_header) + capacity * sizeof(Mine_record)))
+        {
+            return;
+        }
+        reinterpret_cast<Mine_header *>(file.data())->capacity = capacity;
+    }
+    Mine_record &record = reinterpret_cast<Mine_record *>(file.data() + sizeof(Mine_header))[detection.id];
+    record.checksum = 0;
+    record.detection = detection;
+    record.checksum = checksum(&record.detection, sizeof(record.detection));
+}
+
+void mine_File::savePose(const Pose &pose)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    writeSlot(reinterpret_cast<Mine_header *>(file.data())->pose, poseSequence, pose);
+}
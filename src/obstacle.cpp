@@ -0,0 +1,54 @@
+#include "obstacle.h"
+#include <cmath>
+
+using namespace Obstacle_avoidance;
+
+Obstacle_Point Obstacle_avoidance::getCenterOfCircle(std::vector<Obstacle_Point> *points)
+{
+    //get first, middle and last point of the ranges array which is on the obstacle.
+    Obstacle_Point f = (*points).at(0);
+    Obstacle_Point m = (*points).at(points->size() / 2);
+    Obstacle_Point l = (*points).at(points->size() - 1);
+
+    //calculate determinants
+    double A = f.x * (m.y - l.y) - f.y * (m.x - l.x) + m.x * l.y - l.x * m.y;
+    double B = (pow(f.x, 2) + pow(f.y, 2)) * (l.y - m.y) + (pow(m.x, 2) + pow(m.y, 2)) * (f.y - l.y) + (pow(l.x, 2) + pow(l.y, 2)) * (m.y - f.y);
+    double C = (pow(f.x, 2) + pow(f.y, 2)) * (m.x - l.x) + (pow(m.x, 2) + pow(m.y, 2)) * (l.x - f.x) + (pow(l.x, 2) + pow(l.y, 2)) * (f.x - m.x);
+
+    //Create center point.
+    Obstacle_Point center;
+    center.x = -B / (2 * A);
+    center.y = -C / (2 * A);
+
+    //return
+    return center;
+}
+
+double Obstacle_avoidance::obstacleRadius(Obstacle_Point center, Obstacle_Point per_coordinate)
+{
+    return sqrt(pow(center.x - per_coordinate.x, 2) + pow(center.y - per_coordinate.y, 2));
+}
+
+bool Obstacle_avoidance::isInObstacle(Points_gen::Point p, Obstacle_Point obstacle, double r)
+{
+    return sqrt(pow(p.x - obstacle.x, 2) + pow(p.y - obstacle.y, 2)) < r;
+}
+
+Points_gen::Point Obstacle_avoidance::offsetPointInObstacle(Points_gen::Point path_point, double r, Obstacle_Point obstacle)
+{
+    //get angle to offset the point to the edge.
+    double angle = asin((obstacle.y - path_point.y) / r);
+
+    //if in the left side of the obstacle, offset points to the left.
+    //this ensures the shortest path around the obstacle.
+    if (path_point.x > obstacle.x)
+    {
+        path_point.x = obstacle.x + r * cos(angle);
+        return path_point;
+    }
+    else
+    {
+        path_point.x = obstacle.x + r * (-cos(angle));
+        return path_point;
+    }
+}
@@ -10,203 +10,732 @@
 #include <kobuki_msgs/Led.h>
 #include <std_msgs/Empty.h>
 #include <yocs_controllers/default_controller.hpp>
+#include <pose_history.h>
+#include <latency_diagnostics.h>
+#include <quaternion.h>
+#include <camera_model.h>
+#include <paper_vision.h>
+#include <colour_lut.h>
+#include <thread_pool.h>
+#include <detection_map.h>
+#include <frame_gate.h>
+#include <strip_detection.h>
+#include <adaptive_level.h>
+#include <frame_source.h>
+#include <marker_sidecar.h>
+#include <fleet.h>
+#include <mission_state.h>
+#include <mission_log.h>
+#include <trace_context.h>
+#include "opencv2/imgcodecs.hpp"
+#include "mine_detection/FleetMine.h"
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 using namespace std;
+using namespace Camera_model;
 
-ros::Publisher point_pub;
+//markers of the detections, published on a background thread so the camera threads do not wait for them.
+Marker_sidecar::marker_Sidecar markers;
 //ros::Publisher led_pub;
 ros::Subscriber sub_pose;
-turtlesim::Pose cur_pose;
-int iterationCount = 0;
-class point
-{
-public:
-     double x;
-     double y;
-};
+//mines found by the robots of a fleet.
+ros::Publisher mine_pub;
+ros::Subscriber mine_sub;
+//recent odometry poses, used to look up where the robot was when a frame was captured.
+Pose_history::pose_Buffer pose_history;
+
+//latency stages of the vision pipeline.
+const int stageCapture = Latency_trace::stage("capture");
+const int stageThreshold = Latency_trace::stage("threshold");
+const int stageMorphology = Latency_trace::stage("morphology");
+const int stageContours = Latency_trace::stage("contours");
+const int stageBands = Latency_trace::stage("bands");
+const int stageClasses = Latency_trace::stage("classes");
+const int stageDisplay = Latency_trace::stage("display");
+const int stagePublish = Latency_trace::stage("publish");
+const int stageFrame = Latency_trace::stage("frame");
+const int stageStrip = Latency_trace::stage("strip");
+const int stageRefresh = Latency_trace::stage("refresh");
+const int stageGate = Latency_trace::stage("gate");
+//processing time of the frames at each pipeline level, the counts show how often each level was chosen.
+const int stageLevel[] = {Latency_trace::stage("level0"), Latency_trace::stage("level1"), Latency_trace::stage("level2"), Latency_trace::stage("level3")};
+const int stageSkipped = Latency_trace::stage("skipped_frame");
+//frames placed at the newest pose as the history did not reach back to them, and frames without any odometry.
+const int stagePoseFallback = Latency_trace::stage("pose_fallback");
+const int stageNoPose = Latency_trace::stage("no_pose_frame");
+//hops of the mine chain, from the stamp of the frame.
+const int hopProcessed = Latency_trace::stage("frame_processed");
+const int hopMine = Latency_trace::stage("mine_marked");
+const int hopFleetMine = Latency_trace::stage("fleet_mine_received");
 
-double getTheta(double angle);
 void poseCallback(const nav_msgs::Odometry::ConstPtr &pose_message);
-double degreesToRadians(double angleDegrees);
-point pixelsToMeters(point coordInPixels, double length);
-point rotatePointByAngle(double angle, point coord);
-point convertCoordinatesOfPoint(point Coord);
-visualization_msgs::Marker pointToMark(point markcalc);
-
-visualization_msgs::Marker marker_msg;
-
-#pragma region Quaternion To Euler Angles conversion
-struct Quaternion
+void mineCallback(const mine_detection::FleetMine::ConstPtr &mine);
+visualization_msgs::Marker pointToMark(const Detection_map::Detection &detection);
+
+//colour of the paper. set from the trackbars in the main thread, read by the camera threads.
+std::mutex rangeMutex;
+Paper_vision::Hsv_range paperRange = {0, 179, 170, 255, 150, 255};
+
+//detections of all cameras, and in a fleet of the other robots, in the field frame.
+Detection_map::detection_Map detectionMap;
+
+//where the odometry of this robot starts in the field frame, and the frame and namespace of its markers.
+Fleet::field_Frame fieldFrame;
+std::string robotName;
+std::string markerFrame = "/odom";
+std::string markerNs = "paper_pose";
+bool inFleet = false;
+
+//the mines and the last pose saved as they change, so a restarted node keeps its mines. only used with ~state_file.
+Mission_state::mine_File mineFile;
+bool minesSaved = false;
+//on resume the field frame is set by the first odometry pose, so that pose is the last saved one.
+bool resumeFrame = false;
+Pose_history::Stamped_pose resumePose;
+
+//how the camera threads process their frames.
+struct Worker_config
 {
-     double x, y, z, w;
+     double cameraLatency = 0;                //delay between the exposure of a frame and it being returned by the capture, in seconds.
+     Thread_pool::thread_Pool *pool = NULL;    //with a pool the frames are processed in bands on it.
+     int bands = 1;
+     bool motionGate = false;                 //without the gate every frame gets a full pass.
+     Frame_gate::Gate_config gate;
+     bool incremental = false;                //only process the newly seen part of a frame.
+     Strip_detection::Strip_config strips;
+     Adaptive_level::Level_config levels;     //pipeline levels chosen to keep the frame budget.
+     Mission_log::log_Writer *log = NULL;     //with a log a frame is logged every logPeriod seconds, raw or as JPEG.
+     double logPeriod = 1.0;
+     bool logJpeg = false;
+     const Colour_lut::colour_Table *classes = NULL; //with colour classes BGR frames are classified by them instead of the colour range.
 };
 
-struct EulerAngles
+//a camera and the thread processing its frames.
+class camera_Worker
 {
-     double roll, pitch, yaw;
+public:
+     camera_Worker(const std::string &name, const std::string &source, const Camera &camera,
+                   const std::string &format = "yuyv", const std::string &record = "")
+         : name(name), source(source), format(format), record(record), camera(camera), running(false), debugNew(false) {}
+
+     //open the source, see Frame_source::openSource.
+     bool open();
+
+     //start processing frames.
+     void start(const Worker_config &config);
+     void stop();
+
+     //get the newest annotated frame and mask. returns false if there is no new frame since the last call.
+     bool debugFrames(cv::Mat &original, cv::Mat &thresholded);
+
+     const std::string name;
+
+private:
+     void run();
+     void logFrame(const Frame_source::Frame &frame, double stamp);
+
+     std::string source;
+     std::string format;
+     //raw file the frames are recorded to, empty for none.
+     std::string record;
+     Camera camera;
+     std::unique_ptr<Frame_source::frame_Source> capture;
+     std::thread thread;
+     std::atomic<bool> running;
+
+     Worker_config config;
+     std::unique_ptr<Frame_gate::frame_Gate> gate;
+     std::unique_ptr<Strip_detection::strip_Detector> strips;
+
+     //frame data packed for the log.
+     std::vector<uint8_t> logBytes;
+
+     std::mutex debugMutex;
+     cv::Mat debugOriginal;
+     cv::Mat debugThresholded;
+     bool debugNew;
 };
 
-EulerAngles angles;
+bool camera_Worker::open()
+{
+     capture = Frame_source::openSource(source, format, camera.imageWidth, camera.imageHeight);
+     return capture != NULL;
+}
 
-//convert quarternion into eulerangles.
-EulerAngles ToEulerAngles(Quaternion q)
+void camera_Worker::start(const Worker_config &config)
 {
-     EulerAngles angles;
-
-     //roll (x axis rotation)
-     double sinr_cosp = 2 * (q.w * q.x - q.y * q.z);
-     double cosr_cosp = 1 - 2 * (q.x * q.x + q.y * q.y);
-     angles.roll = atan2(sinr_cosp, cosr_cosp);
-
-     //pitch (y axis rotation)
-     double sinp = 2 * (q.w * q.y - q.z * q.x);
-     if (abs(sinp) >= 1)
-          //copysign returns the magnitude of M_PI/2 with the sign of sinp
-          angles.pitch = copysign(M_PI / 2, sinp); // use 90 degrees if out of range
-     else
-          angles.pitch = asin(sinp);
-
-     // yaw (z-axis rotation)
-     double siny_cosp = 2 * (q.w * q.z + q.x * q.y);
-     double cosy_cosp = 1 - 2 * (q.y * q.y + q.z * q.z);
-     //calculate yaw, and make the yaw angle be 0 < yaw < 2pi.
-     angles.yaw = std::atan2(siny_cosp, cosy_cosp);
-
-     return angles;
+     this->config = config;
+     if (config.motionGate)
+     {
+          gate.reset(new Frame_gate::frame_Gate(camera, config.gate));
+     }
+     if (config.incremental)
+     {
+          strips.reset(new Strip_detection::strip_Detector(camera, config.strips));
+     }
+     running = true;
+     thread = std::thread(&camera_Worker::run, this);
 }
-#pragma endregion
 
-int main(int argc, char **argv)
+void camera_Worker::stop()
+{
+     running = false;
+     if (thread.joinable())
+     {
+          thread.join();
+     }
+}
+
+bool camera_Worker::debugFrames(cv::Mat &original, cv::Mat &thresholded)
 {
+     std::lock_guard<std::mutex> lock(debugMutex);
+     if (!debugNew)
+     {
+          return false;
+     }
+     original = debugOriginal;
+     thresholded = debugThresholded;
+     debugNew = false;
+     return true;
+}
 
-     vector<int> lastRectSurface; //surface area of boundingbox last frame
-     vector<bool> shouldPublish;
+void camera_Worker::run()
+{
+     Paper_vision::mine_Trigger trigger;
      int boundColour[] = {0, 0, 255};
      int contourColour[] = {0, 255, 0};
-     int surflimit = 250;            //surflimit defines the lower boundary, where an object will be countoured and for which a bounding box will be made
-     int upperLimitOfdecrease = 100; // this defines the upper limit for the change of the size of the bounding boxes
-     int surfacedif;
+     Paper_vision::Hsv_range lastRange = {-1, -1, -1, -1, -1, -1};
+     vector<cv::Rect> lastBoundbox; //bounding boxes of the last processed frame, drawn on skipped frames.
 
-     ros::init(argc, argv, "paper_detector");
-     ros::NodeHandle n;
-     point_pub = n.advertise<visualization_msgs::Marker>("/visualization_marker", 100); //visualization_msgs::Marker /visualization_marker
-     //led_pub = n.advertise<kobuki_msgs::Led>("/commands/led1", 10); //visualization_msgs::Marker /visualization_marker
-     sub_pose = n.subscribe("/odom", 100, &poseCallback);
+     //level 1 skips the debug drawing, level 2 also uses the 3x3 morphology and level 3 also processes the frame at half resolution.
+     //the incremental strips are cheap already and only skip the drawing.
+     Adaptive_level::level_Controller levels(config.levels);
 
-     cv::VideoCapture cap(0); //Capture the video from webcam.
-     //If the webcam cannot open, it is likely due to the iindex is wrong, thus it is trying to open a webcam that is not accessible through that index.
+     //YUV frames are thresholded with the YUV colours of the colour range, rebuilt when the range changes.
+     Paper_vision::Hsv_range yuvFrom = {-1, -1, -1, -1, -1, -1};
+     Yuv_threshold::Yuv_range yuvRange;
+     Frame_source::raw_Writer recorder;
+     bool recording = false;
+     double lastLogged = 0;
 
-     if (!cap.isOpened()) //If not success, exit program.
+     //the colour classes run on the calling thread without a pool.
+     Thread_pool::thread_Pool callerPool(1);
+     cv::Mat imgClasses;
+     vector<vector<Blob_runs::Blob>> classBlobs;
+
+     //the frames of every camera are a source of their own.
+     const std::string traceSource = "camera_" + name;
+
+     while (running && ros::ok())
      {
-          std::cout << "Cannot open the web cam" << endl;
-          return -1;
-     }
+          uint64_t frameStart = Latency_trace::now();
+          Frame_source::Frame frame;
 
-     cv::namedWindow("Control", CV_WINDOW_AUTOSIZE); //Create a window called "Control".
+          bool bSuccess = capture->grab(frame); //Read a new frame from video.
+          Latency_trace::record(stageCapture, frameStart, Latency_trace::now() - frameStart);
 
-     int iLowH = 0;
-     int iHighH = 179;
+          if (!bSuccess) //If not success, stop this camera.
+          {
+               ROS_ERROR("Cannot read a frame from camera %s", name.c_str());
+               break;
+          }
+          //the buffer of the frame goes back to the source at the end of the iteration.
+          Frame_source::frame_Lease lease(*capture, frame);
+          //a BGR frame, YUV frames are only converted when needed.
+          cv::Mat imgOriginal = frame.bgr;
 
-     int iLowS = 170;
-     int iHighS = 255;
+          if (!record.empty() && !recording)
+          {
+               recording = recorder.open(record, frame, 30);
+               if (!recording)
+               {
+                    ROS_ERROR("Cannot record camera %s to %s", name.c_str(), record.c_str());
+                    record.clear();
+               }
+          }
+          if (recording)
+          {
+               recorder.write(frame);
+          }
+          //frames are logged with the time they were grabbed, the log source replays them at that time.
+          ros::Time grabStamp = ros::Time::now();
+          if (config.log && grabStamp.toSec() - lastLogged >= config.logPeriod)
+          {
+               logFrame(frame, grabStamp.toSec());
+               lastLogged = grabStamp.toSec();
+          }
+          ros::Time frameStamp = grabStamp - ros::Duration(config.cameraLatency);
+          mine_detection::TraceContext trace = Trace_context::begin(traceSource, frameStamp);
 
-     int iLowV = 150;
-     int iHighV = 255;
+          //the pose of the robot when the frame was captured. at startup or after a gap in the odometry the history
+          //may not reach back to the frame, the frame is placed at the newest pose then, as path_basis does with scans.
+          Pose_history::Stamped_pose stampedPose;
+          if (!pose_history.lookup(frameStamp.toSec(), stampedPose))
+          {
+               if (!pose_history.latest(stampedPose))
+               {
+                    ROS_WARN_THROTTLE(1, "No odometry for frame of camera %s", name.c_str());
+                    Latency_trace::record(stageNoPose, frameStart, Latency_trace::now() - frameStart);
+                    continue;
+               }
+               Latency_trace::record(stagePoseFallback, frameStart, Latency_trace::now() - frameStart);
+          }
+          turtlesim::Pose framePose;
+          framePose.x = stampedPose.x;
+          framePose.y = stampedPose.y;
+          framePose.theta = stampedPose.theta;
 
-     //Create trackbars in "Control" window.
-     cv::createTrackbar("LowH", "Control", &iLowH, 179); //Hue (0 - 179)
-     cv::createTrackbar("HighH", "Control", &iHighH, 179);
+          Paper_vision::Hsv_range range;
+          {
+               std::lock_guard<std::mutex> lock(rangeMutex);
+               range = paperRange;
+          }
 
-     cv::createTrackbar("LowS", "Control", &iLowS, 255); //Saturation (0 - 255)
-     cv::createTrackbar("HighS", "Control", &iHighS, 255);
+          if (frame.isYuv && memcmp(&range, &yuvFrom, sizeof(range)) != 0)
+          {
+               yuvRange = Yuv_threshold::rangeOfHsv(range.lowH, range.highH, range.lowS, range.highS, range.lowV, range.highV);
+               yuvFrom = range;
+          }
 
-     cv::createTrackbar("LowV", "Control", &iLowV, 255); //Value (0 - 255)
-     cv::createTrackbar("HighV", "Control", &iHighV, 255);
+          if (gate)
+          {
+               Latency_trace::Scoped_timer timer(stageGate);
+               //a new colour range changes the mask of the same view, so the next frame is processed.
+               if (memcmp(&range, &lastRange, sizeof(range)) != 0)
+               {
+                    gate->reset();
+                    lastRange = range;
+               }
 
-     while (ros::ok())
-     {
-          ros::spinOnce(); //process odom callback.
+               if (!gate->shouldProcess(Frame_source::rawView(frame), framePose, frameStamp.toSec()))
+               {
+                    //YUV frames are not converted only to be shown.
+                    if (frame.isYuv)
+                    {
+                         Latency_trace::record(stageSkipped, frameStart, Latency_trace::now() - frameStart);
+                         continue;
+                    }
+                    //the camera sees the same ground as in the last processed frame, only show it.
+                    for (size_t i = 0; i < lastBoundbox.size(); i++)
+                    {
+                         rectangle(imgOriginal, lastBoundbox[i].tl(), lastBoundbox[i].br(), (boundColour[0], boundColour[1], boundColour[2]), 2, 8, 0);
+                    }
+                    std::lock_guard<std::mutex> lock(debugMutex);
+                    debugOriginal = imgOriginal;
+                    debugNew = true;
+                    Latency_trace::record(stageSkipped, frameStart, Latency_trace::now() - frameStart);
+                    continue;
+               }
+          }
 
-          cv::Mat imgOriginal;
+          uint64_t processStart = Latency_trace::now();
+          int level = levels.level();
+          int radius = level >= 2 ? 1 : 2;
+          int scale = level >= 3 ? 2 : 1;
 
-          bool bSuccess = cap.read(imgOriginal); //Read a new frame from video.
+          //the strips and the half resolution work on BGR frames, otherwise YUV frames are thresholded as they are.
+          //the colour classes are looked up by BGR.
+          bool yuvNative = frame.isYuv && !strips && scale == 1 && !config.classes;
+          if (frame.isYuv && !yuvNative)
+          {
+               Paper_vision::yuvToBgr(frame.yuv, imgOriginal);
+          }
 
-          if (!bSuccess) //If not success, break loop.
+          cv::Mat imgProcessed = imgOriginal;
+          if (scale > 1 && !strips)
           {
-               std::cout << "Cannot read a frame from video stream" << endl;
-               break;
+               cv::resize(imgOriginal, imgProcessed, cv::Size(imgOriginal.cols / scale, imgOriginal.rows / scale), 0, 0, cv::INTER_NEAREST);
           }
 
-          cv::Mat imgHSV;
-          cvtColor(imgOriginal, imgHSV, cv::COLOR_BGR2HSV); //Convert the captured frame from BGR to HSV.
           cv::Mat imgThresholded;
-          cv::inRange(imgHSV, cv::Scalar(iLowH, iLowS, iLowV), cv::Scalar(iHighH, iHighS, iHighV), imgThresholded); //Threshold the image.
+          vector<cv::Rect> boundbox;
+          vector<vector<cv::Point>> contours_poly;
+          if (strips)
+          {
+               //only the ground that came into view since the last frame, or the full frame every few frames.
+               uint64_t start = Latency_trace::now();
+               bool full = strips->process(imgOriginal, range, framePose, config.pool, config.bands, imgThresholded, boundbox);
+               Latency_trace::record(full ? stageRefresh : stageStrip, start, Latency_trace::now() - start);
+          }
+          else if (config.classes)
+          {
+               //all colour classes in one pass over the frame, the blobs of every class are mines.
+               Latency_trace::Scoped_timer timer(stageClasses);
+               Thread_pool::thread_Pool &pool = config.pool ? *config.pool : callerPool;
+               Paper_vision::processClasses(imgProcessed, *config.classes, pool, config.pool ? config.bands : 1, imgClasses, classBlobs, radius);
+               cv::compare(imgClasses, 0, imgThresholded, cv::CMP_NE);
+               for (size_t k = 0; k < classBlobs.size(); k++)
+               {
+                    vector<cv::Rect> classBoxes;
+                    Paper_vision::blobBoxes(classBlobs[k], classBoxes);
+                    boundbox.insert(boundbox.end(), classBoxes.begin(), classBoxes.end());
+               }
+          }
+          else if (config.pool && yuvNative)
+          {
+               Latency_trace::Scoped_timer timer(stageBands);
+               Paper_vision::processBands(frame.yuv, yuvRange, *config.pool, config.bands, imgThresholded, boundbox, radius);
+          }
+          else if (config.pool)
+          {
+               //threshold, morphology and blob extraction in one parallel pass.
+               Latency_trace::Scoped_timer timer(stageBands);
+               Paper_vision::processBands(imgProcessed, range, *config.pool, config.bands, imgThresholded, boundbox, radius);
+          }
+          else
+          {
+               {
+                    Latency_trace::Scoped_timer timer(stageThreshold);
+                    if (yuvNative)
+                    {
+                         Paper_vision::thresholdYuv(frame.yuv, yuvRange, imgThresholded);
+                    }
+                    else
+                    {
+                         Paper_vision::thresholdFrame(imgProcessed, range, imgThresholded);
+                    }
+               }
 
-          //Morphological opening (removes small objects from the foreground).
-          erode(imgThresholded, imgThresholded, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5)));
-          dilate(imgThresholded, imgThresholded, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5)));
+               {
+                    Latency_trace::Scoped_timer timer(stageMorphology);
+                    Paper_vision::filterMask(imgThresholded, radius);
+               }
 
-          //Morphological closing (removes small holes from the foreground).
-          dilate(imgThresholded, imgThresholded, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5)));
-          erode(imgThresholded, imgThresholded, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5)));
+               {
+                    Latency_trace::Scoped_timer timer(stageContours);
+                    Paper_vision::findBoundingBoxes(imgThresholded, contours_poly, boundbox);
+               }
+          }
 
-          vector<vector<cv::Point>> contours; // makes a 2D vector containing points
+          //back to the pixels of the full frame.
+          if (scale > 1 && !strips)
+          {
+               for (size_t i = 0; i < boundbox.size(); i++)
+               {
+                    boundbox[i] = cv::Rect(boundbox[i].x * scale, boundbox[i].y * scale, boundbox[i].width * scale, boundbox[i].height * scale);
+               }
+               contours_poly.clear();
+          }
 
-          findContours(imgThresholded, contours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE, cv::Point(0, 0));
+          {
+               Latency_trace::Scoped_timer timer(stageDisplay);
 
-          vector<cv::Rect> boundbox(contours.size());
-          vector<vector<cv::Point>> contours_poly(contours.size());
+               //a YUV frame is converted for showing only while there is time for the drawing, from level 1 only its mask is shown.
+               if (imgOriginal.empty() && level < 1)
+               {
+                    Paper_vision::yuvToBgr(frame.yuv, imgOriginal);
+               }
+
+               //from level 1 the frames are shown without the drawing.
+               if (!contours_poly.empty() && level < 1)
+               {
+                    drawContours(imgOriginal, contours_poly, -1, (contourColour[0], contourColour[1], contourColour[2]), 3);
+               }
+               for (size_t i = 0; i < boundbox.size() && level < 1; i++)
+               {
+                    rectangle(imgOriginal, boundbox[i].tl(), boundbox[i].br(), (boundColour[0], boundColour[1], boundColour[2]), 2, 8, 0);
+                    //std::cout << boundbox[i].tl() << boundbox[i].br() <<  std::endl;
+               }
 
-          for (size_t i = 0; i < contours.size(); i++)
+               //hand the images to the main thread for display.
+               std::lock_guard<std::mutex> lock(debugMutex);
+               debugOriginal = imgOriginal;
+               debugThresholded = imgThresholded;
+               debugNew = true;
+          }
+
+          Trace_context::hop(hopProcessed, trace);
+          uint64_t publishStart = Latency_trace::now();
+
+          //a bounding rectangle smaller than in the last frame is a mine.
+          vector<cv::Rect> mineBoxes;
+          trigger.update(boundbox, mineBoxes);
+          for (size_t i = 0; i < mineBoxes.size(); i++)
           {
+               point centerCoord;
+               centerCoord.x = mineBoxes[i].x + (mineBoxes[i].width / 2);
+               centerCoord.y = mineBoxes[i].y + (mineBoxes[i].height / 2);
+
+               //add to the shared map, where it is merged with earlier detections of the same paper by any camera.
+               point paperPoint = convertCoordinatesOfPoint(centerCoord, framePose, camera);
+               Detection_map::Detection detection = detectionMap.add(paperPoint.x, paperPoint.y);
+               if (minesSaved)
+               {
+                    mineFile.saveMine(detection);
+               }
+               visualization_msgs::Marker marker = pointToMark(detection);
+               markers.update(marker);
+               Trace_context::hop(hopMine, trace);
+               if (inFleet)
+               {
+                    mine_detection::FleetMine mine;
+                    mine.robot = robotName;
+                    mine.id = detection.id;
+                    mine.x = detection.x;
+                    mine.y = detection.y;
+                    mine.trace = trace;
+                    mine_pub.publish(mine);
+               }
+          }
+          lastBoundbox.swap(boundbox);
+          Latency_trace::record(stagePublish, publishStart, Latency_trace::now() - publishStart);
 
-               approxPolyDP(cv::Mat(contours[i]), contours_poly[i], 3, true);
-               boundbox[i] = boundingRect(contours_poly[i]);
+          //choose the level of the next frame from the time this one took, without waiting for the camera.
+          uint64_t processTime = Latency_trace::now() - processStart;
+          Latency_trace::record(stageLevel[level], processStart, processTime);
+          if (levels.update(processTime * 1e-9) != level)
+          {
+               ROS_INFO("Camera %s pipeline level %d -> %d, frame took %.1f ms of %.1f ms", name.c_str(), level, levels.level(),
+                        processTime * 1e-6, config.levels.budget * 1e3);
           }
+          Latency_trace::record(stageFrame, frameStart, Latency_trace::now() - frameStart);
+     }
+}
 
-          for (size_t i = 0; i < contours.size(); i++)
+void camera_Worker::logFrame(const Frame_source::Frame &frame, double stamp)
+{
+     if (config.logJpeg)
+     {
+          cv::Mat bgr = frame.bgr;
+          if (frame.isYuv)
           {
-               drawContours(imgOriginal, contours_poly, -1, (contourColour[0], contourColour[1], contourColour[2]), 3);
-               rectangle(imgOriginal, boundbox[i].tl(), boundbox[i].br(), (boundColour[0], boundColour[1], boundColour[2]), 2, 8, 0);
-               //std::cout << boundbox[i].tl() << boundbox[i].br() <<  std::endl;
+               Paper_vision::yuvToBgr(frame.yuv, bgr);
           }
+          std::vector<uchar> jpeg;
+          cv::imencode(".jpg", bgr, jpeg);
+          config.log->frame(stamp, name, Mission_log::FRAME_JPEG, bgr.cols, bgr.rows, jpeg.data(), jpeg.size());
+          return;
+     }
+     int format = Frame_source::packFrame(frame, logBytes);
+     int width = frame.isYuv ? frame.yuv.width : frame.bgr.cols;
+     int height = frame.isYuv ? frame.yuv.height : frame.bgr.rows;
+     config.log->frame(stamp, name, format, width, height, logBytes.data(), logBytes.size());
+}
 
-          imshow("Thresholded Image", imgThresholded); //show the thresholded image
-          imshow("Original", imgOriginal);             //show the original image
+//create the cameras listed in the ~cameras parameter, for example
+//cameras: [{name: left, source: "0", forward: 0.21, lateral: -0.15}, {name: right, source: "1", forward: 0.21, lateral: 0.15}]
+//without the parameter the single camera 0 is used.
+void loadCameras(vector<std::unique_ptr<camera_Worker>> &workers)
+{
+     XmlRpc::XmlRpcValue list;
+     if (!ros::NodeHandle("~").getParam("cameras", list) || list.getType() != XmlRpc::XmlRpcValue::TypeArray)
+     {
+          workers.push_back(std::unique_ptr<camera_Worker>(new camera_Worker("0", "0", Camera())));
+          return;
+     }
 
-          vector<cv::Point> rectCenter(boundbox.size()); //current boundingbox center coordinates
-          //shouldPublish.resize(rectCenter.size(), true);
-          //for (int j = 0; j =< rectCenter.size(); j++)
-          //cout << " "
-          vector<int> rectSurface(boundbox.size()); //surface area of boundingbox last frame
-          lastRectSurface.resize(boundbox.size());  //surface area of boundingbox last frame
+     for (int i = 0; i < list.size(); i++)
+     {
+          XmlRpc::XmlRpcValue &entry = list[i];
+          Camera camera = cameraOfEntry(entry);
 
-          for (size_t i = 0; i < boundbox.size(); i++)
+          std::string source = std::to_string(i);
+          if (entry.hasMember("source"))
           {
-               rectSurface[i] = boundbox[i].width * boundbox[i].height;
-               surfacedif = lastRectSurface[i] - rectSurface[i];
-               if (surfacedif > surflimit) //if bounding rectangle is smaller than last frame save coordinated of bounding rectangle
-               {
-                    rectCenter[i] = {boundbox[i].x + (boundbox[i].width / 2), boundbox[i].y + (boundbox[i].height / 2)};
+               XmlRpc::XmlRpcValue &value = entry["source"];
+               source = value.getType() == XmlRpc::XmlRpcValue::TypeInt ? std::to_string(int(value)) : std::string(value);
+          }
+          std::string name = entry.hasMember("name") ? std::string(entry["name"]) : source;
+          std::string format = entry.hasMember("format") ? std::string(entry["format"]) : "yuyv";
+          std::string record = entry.hasMember("record") ? std::string(entry["record"]) : "";
+
+          workers.push_back(std::unique_ptr<camera_Worker>(new camera_Worker(name, source, camera, format, record)));
+     }
+}
+
+int main(int argc, char **argv)
+{
+     ros::init(argc, argv, "paper_detector");
+     ros::NodeHandle n;
+     markers.start(n);
+     //led_pub = n.advertise<kobuki_msgs::Led>("/commands/led1", 10); //visualization_msgs::Marker /visualization_marker
+     //in a fleet the odometry is converted to the field frame, so it has to be known before the first pose arrives.
+     robotName = Fleet::robotName();
+     fieldFrame = Fleet::field_Frame::load();
+     inFleet = !Fleet::loadRobots().empty();
+     if (inFleet)
+     {
+          markerFrame = Fleet::markerFrame();
+          markerNs += robotName;
+          mine_pub = n.advertise<mine_detection::FleetMine>("/fleet/mines", 100);
+          mine_sub = n.subscribe("/fleet/mines", 100, &mineCallback);
+     }
 
-                    for (size_t i = 0; i < rectCenter.size(); i++)
+     //with a state file the mines are saved as they are found, a restarted node keeps them and its field frame.
+     std::string stateFile;
+     bool resume;
+     ros::NodeHandle("~").param("state_file", stateFile, std::string());
+     ros::NodeHandle("~").param("resume", resume, true);
+     if (!stateFile.empty())
+     {
+          minesSaved = mineFile.open(stateFile, resume);
+          if (!minesSaved)
+          {
+               ROS_ERROR("Could not open the state file %s, the mines are not saved.", stateFile.c_str());
+          }
+     }
+     if (minesSaved && resume)
+     {
+          std::vector<Detection_map::Detection> mines = mineFile.loadMines();
+          detectionMap.restore(mines);
+          for (size_t i = 0; i < mines.size(); i++)
+          {
+               //the ids may have been renumbered around a torn record.
+               mineFile.saveMine(mines[i]);
+               visualization_msgs::Marker marker = pointToMark(mines[i]);
+               markers.update(marker);
+          }
+          Mission_state::Pose pose;
+          if (mineFile.loadPose(pose))
+          {
+               Pose_history::Stamped_pose saved = {0, pose.x, pose.y, pose.theta};
+               resumePose = saved;
+               resumeFrame = true;
+          }
+          ROS_INFO("Resumed %zu mines.", mines.size());
+     }
+     sub_pose = n.subscribe("odom", 100, &poseCallback);
+
+     //odometry is handled on a background thread, so the pose history stays current while the main thread shows images.
+     ros::AsyncSpinner spinner(1);
+     spinner.start();
+
+     Worker_config config;
+     ros::NodeHandle("~").param("camera_latency", config.cameraLatency, config.cameraLatency);
+
+     Latency_trace::diagnostics_Publisher diagnostics;
+     diagnostics.start(n, "paper_detection");
+
+     //with more than one vision thread the frames are processed in horizontal bands on a thread pool shared by the cameras.
+     int visionThreads;
+     int visionBands;
+     ros::NodeHandle("~").param("vision_threads", visionThreads, 1);
+     ros::NodeHandle("~").param("vision_bands", visionBands, 2 * visionThreads);
+     std::unique_ptr<Thread_pool::thread_Pool> visionPool;
+     if (visionThreads > 1)
+     {
+          visionPool.reset(new Thread_pool::thread_Pool(visionThreads));
+          cv::setNumThreads(0); //the bands are the parallelism, keep OpenCV from starting its own threads per call.
+          ROS_INFO("Processing frames in %d bands on %d threads", visionBands, visionThreads);
+     }
+     config.pool = visionPool.get();
+     config.bands = visionBands;
+
+     //skip the full pass on frames that show the ground of the last processed frame again, e.g. while turning on the spot or waiting.
+     //off by default, every frame gets a full pass like before the gate.
+     ros::NodeHandle("~").param("motion_gate", config.motionGate, false);
+     ros::NodeHandle("~").param("gate_shift", config.gate.minShift, config.gate.minShift);
+     ros::NodeHandle("~").param("gate_change", config.gate.minChange, config.gate.minChange);
+     ros::NodeHandle("~").param("gate_max_age", config.gate.maxAge, config.gate.maxAge);
+
+     //process only the strip of each frame that came into view, predicted from the odometry.
+     ros::NodeHandle("~").param("incremental", config.incremental, false);
+     ros::NodeHandle("~").param("refresh_frames", config.strips.refreshFrames, config.strips.refreshFrames);
+     ros::NodeHandle("~").param("strip_max_error", config.strips.maxError, config.strips.maxError);
+
+     //processing time per frame in seconds. frames over it make the pipeline cheaper, 0 always runs the full pipeline.
+     ros::NodeHandle("~").param("frame_budget", config.levels.budget, config.levels.budget);
+     ros::NodeHandle("~").param("max_level", config.levels.maxLevel, config.levels.maxLevel);
+     config.levels.maxLevel = std::max(0, std::min(config.levels.maxLevel, 3));
+
+     //any number of mine colours, compiled into one lookup table. the incremental strips keep the colour range.
+     Colour_lut::colour_Table colourTable;
+     if (Colour_lut::loadClasses(ros::NodeHandle("~"), colourTable))
+     {
+          config.classes = &colourTable;
+          if (config.incremental)
+          {
+               ROS_WARN("The incremental strips use the colour range, not the colour classes.");
+          }
+     }
+
+     //frames of all cameras go to one log, replayed with "log:" camera sources.
+     std::string logFile;
+     ros::NodeHandle("~").param("log_file", logFile, std::string());
+     ros::NodeHandle("~").param("log_frame_period", config.logPeriod, config.logPeriod);
+     ros::NodeHandle("~").param("log_jpeg", config.logJpeg, config.logJpeg);
+     Mission_log::log_Writer missionLog;
+     if (!logFile.empty())
+     {
+          logFile = Mission_log::startPath(logFile);
+          if (missionLog.open(logFile))
+          {
+               config.log = &missionLog;
+          }
+          else
+          {
+               ROS_ERROR("Could not create the log %s.", logFile.c_str());
+          }
+     }
+
+     vector<std::unique_ptr<camera_Worker>> workers;
+     loadCameras(workers);
+     for (size_t i = 0; i < workers.size(); i++)
+     {
+          //If the webcam cannot open, it is likely due to the iindex is wrong, thus it is trying to open a webcam that is not accessible through that index.
+          if (!workers[i]->open()) //If not success, exit program.
+          {
+               ROS_ERROR("Cannot open camera %s", workers[i]->name.c_str());
+               return -1;
+          }
+     }
+
+     cv::namedWindow("Control", CV_WINDOW_AUTOSIZE); //Create a window called "Control".
+
+     int iLowH = paperRange.lowH;
+     int iHighH = paperRange.highH;
+
+     int iLowS = paperRange.lowS;
+     int iHighS = paperRange.highS;
+
+     int iLowV = paperRange.lowV;
+     int iHighV = paperRange.highV;
+
+     //Create trackbars in "Control" window.
+     cv::createTrackbar("LowH", "Control", &iLowH, 179); //Hue (0 - 179)
+     cv::createTrackbar("HighH", "Control", &iHighH, 179);
+
+     cv::createTrackbar("LowS", "Control", &iLowS, 255); //Saturation (0 - 255)
+     cv::createTrackbar("HighS", "Control", &iHighS, 255);
+
+     cv::createTrackbar("LowV", "Control", &iLowV, 255); //Value (0 - 255)
+     cv::createTrackbar("HighV", "Control", &iHighV, 255);
+
+     for (size_t i = 0; i < workers.size(); i++)
+     {
+          workers[i]->start(config);
+     }
+     ROS_INFO("Detecting with %zu cameras", workers.size());
+
+     //the main thread only handles the windows, highgui is not thread safe.
+     while (ros::ok())
+     {
+          {
+               std::lock_guard<std::mutex> lock(rangeMutex);
+               Paper_vision::Hsv_range range = {iLowH, iHighH, iLowS, iHighS, iLowV, iHighV};
+               paperRange = range;
+          }
+
+          for (size_t i = 0; i < workers.size(); i++)
+          {
+               cv::Mat imgOriginal;
+               cv::Mat imgThresholded;
+               if (workers[i]->debugFrames(imgOriginal, imgThresholded))
+               {
+                    //the original is missing for YUV frames above level 0, and the mask for the first skipped frames.
+                    if (!imgThresholded.empty())
+                    {
+                         imshow("Thresholded Image " + workers[i]->name, imgThresholded); //show the thresholded image
+                    }
+                    if (!imgOriginal.empty())
                     {
-                         point centerCoord;
-                         centerCoord.x = double(rectCenter.at(i).x);
-                         centerCoord.y = double(rectCenter.at(i).y);
-
-                         if (centerCoord.x && centerCoord.y != 0 && shouldPublish[i] == true)
-                         {
-                              point_pub.publish(pointToMark(convertCoordinatesOfPoint(centerCoord)));
-                         }
+                         imshow("Original " + workers[i]->name, imgOriginal); //show the original image
                     }
                }
-               //if(i > 2 && rectsurf[i-2]<rectsurf[i-1]>rectsurf[i])
-               /*if (surfacedif < surflimit)
-               {
-               shouldPublish[i] = false;
-               }*/
-               lastRectSurface[i] = rectSurface[i];
           }
 
           if (cv::waitKey(30) == 27) //wait for 'esc' key press for 30ms. If 'esc' key is pressed, break loop
@@ -215,6 +744,13 @@ int main(int argc, char **argv)
                break;
           }
      }
+
+     for (size_t i = 0; i < workers.size(); i++)
+     {
+          workers[i]->stop();
+     }
+     missionLog.close();
+     markers.stop();
      return 0;
 }
 
@@ -222,9 +758,12 @@ int main(int argc, char **argv)
 void poseCallback(const nav_msgs::Odometry::ConstPtr &pose_message)
 {
      //std::cout << "Callback" << std::endl;
+     Pose_history::Stamped_pose stamped;
+     stamped.stamp = pose_message->header.stamp.toSec();
+
      // Get the x,y position.
-     cur_pose.x = pose_message->pose.pose.position.x;
-     cur_pose.y = pose_message->pose.pose.position.y;
+     stamped.x = pose_message->pose.pose.position.x;
+     stamped.y = pose_message->pose.pose.position.y;
 
      // Quaternion object q.
      Quaternion q;
@@ -236,121 +775,53 @@ void poseCallback(const nav_msgs::Odometry::ConstPtr &pose_message)
      q.w = pose_message->pose.pose.orientation.w;
 
      // Retrieve Euler angles from quaternion pose message.
-     angles = ToEulerAngles(q);
+     EulerAngles angles = ToEulerAngles(q);
 
-     cur_pose.theta = angles.yaw;
-     //std::cout << "Recieved point: " << cur_pose.x << " : " << cur_pose.y << " - angle: " << cur_pose.theta << std::endl;
-}
+     stamped.theta = angles.yaw;
 
-double getTheta(double angle)
-{
-     //If theta is negative it is converted to the corresponding positive angle (Theta becomes negative when the turtle rotates clockwise).
-     double theta = angle < 0 ? angle + 2 * M_PI : angle;
-     //cout << "Got theta: " << theta << endl;
-     return theta;
-}
-
-//Converts degrees to radians.
-double degreesToRadians(double angleDegrees)
-{
-     return angleDegrees * M_PI / 180;
-}
-
-//Converts a pioint from pixels to meters, based on the ratio between side length and number of pixels.
-point pixelsToMeters(point coordInPixels, double length)
-{
-     point coordInMeters;
-     coordInMeters.x = coordInPixels.x * (length / 640);
-     coordInMeters.y = coordInPixels.y * (length / 640);
-     return coordInMeters;
-}
+     //the odometry may have been reset with the robot, the saved pose is where it is in the field.
+     if (resumeFrame)
+     {
+          fieldFrame = Fleet::field_Frame::matching(resumePose, stamped);
+          resumeFrame = false;
+     }
 
-//Rotates a vector by a given angle.
-point rotatePointByAngle(double angle, point coord)
-{
-     point rotatedPoint;
-     rotatedPoint.x = coord.x * cos(angle - M_PI_2) + coord.y * (-sin(angle - M_PI_2));
-     rotatedPoint.y = coord.x * sin(angle - M_PI_2) + coord.y * cos(angle - M_PI_2);
-     return rotatedPoint;
+     //store the stamped pose in the history, the camera threads read it from there.
+     Pose_history::Stamped_pose field = fieldFrame.toField(stamped);
+     pose_history.push(field);
+     if (minesSaved)
+     {
+          Mission_state::Pose pose = {field.x, field.y, field.theta};
+          mineFile.savePose(pose);
+     }
+     //std::cout << "Recieved point: " << stamped.x << " : " << stamped.y << " - angle: " << stamped.theta << std::endl;
 }
 
-point convertCoordinatesOfPoint(point Coord)
+//mines of the other robots go into the map, so a paper seen by several robots is one detection. their markers are published by the robot that found them.
+void mineCallback(const mine_detection::FleetMine::ConstPtr &mine)
 {
-     // Changable variables: Diagonal FOV of the camera, and the camera distance to the ground.
-     double FOV = 64; //78
-     double distFromGroundCam = 0.35;
-
-     //The following determines the measurements (length and width) of the area that the camera projects.
-     double halfFOV = degreesToRadians(FOV / 2);
-     double B = M_PI - M_PI_2 - halfFOV;
-     double a = (distFromGroundCam / sin(B)) * sin(halfFOV);
-     double alpha = atan2(3, 4);
-
-     double length = 2 * cos(alpha) * a;
-     double width = 2 * sin(alpha) * a;
-     //std::cout << "Dimensions: " << length << " ; " << width << "\n";
-
-     //The coordinates of the found point in pixels.
-     point coordInPixel; //Use the coordinates that will be published, the current values are for testing only.
-     coordInPixel.x = Coord.x;
-     coordInPixel.y = Coord.y;
-
-     //Converts the point's coordinates from pixels to meters using the pixelsToMeters function.
-     point coordInMeters = pixelsToMeters(coordInPixel, length);
-
-     //Since the camera determines the coordinates of the point using the y-axis going downwards. The y-axis is reverted by adding a negative sign.
-     coordInMeters.y = -coordInMeters.y;
-
-     // The vector from the middle of the camera to the center of the robot. Measured as difference in x and y respectively and is changable.
-     point camCenterToRobotCenter;
-     camCenterToRobotCenter.x = 0;
-     camCenterToRobotCenter.y = -0.21;
-
-     //The vector of the area projected by the camera from Origo to the center of the area/camera.
-     point camOrigoToCamCenter;
-     camOrigoToCamCenter.x = 1.0 / 2.0 * length;
-     camOrigoToCamCenter.y = -1.0 / 2.0 * width;
-     //std::cout << "camOrigoToCamCenter: " << camOrigoToCamCenter.x << " ; " << camOrigoToCamCenter.y << "\n";
-
-     //The vector from the projected area's Origo to the center of the robot.
-     //This is done to shift the coodinate-system of the camera to a coodinate-system with Origo in the robot's centre.
-     point camOrigoToRobot;
-     camOrigoToRobot.x = camCenterToRobotCenter.x + camOrigoToCamCenter.x;
-     camOrigoToRobot.y = camCenterToRobotCenter.y + camOrigoToCamCenter.y;
-     //std::cout << "camOrigoToRobot: " << camOrigoToRobot.x << " ; " << camOrigoToRobot.y << "\n";
-
-     //The vector of the found point from the robot centre (in meters).
-     point coordInMetersToRobotOrigo;
-     coordInMetersToRobotOrigo.x = coordInMeters.x - camOrigoToRobot.x;
-     coordInMetersToRobotOrigo.y = coordInMeters.y - camOrigoToRobot.y;
-     //std::cout << "coordInMetersToRobotOrigo: " << coordInMetersToRobotOrigo.x << " ; " << coordInMetersToRobotOrigo.y << "\n";
-
-     //The found point is rotated to fit with the robots coodinate-system.
-     //It is then rotated with the current angle of the robot measured from the x-axis to determine the correct position of the point compared to the robot.
-     point rotatedPoint = rotatePointByAngle(getTheta(cur_pose.theta), coordInMetersToRobotOrigo); // if the first argument for rotatePointByAngle is not
-     // getTheta(cur_pose.theta) then it is in test-mode
-     //std::cout << "RotatedPoint: " << rotatedPoint.x << " ; " << rotatedPoint.y << "\n";
-
-     //The coordinates of the found paper from the robots Origin point.
-     //Determined from the coordinates of the robot from its Origin + the vector from the robot centre to the found point.
-
-     point paperPoint;
-     paperPoint.x = cur_pose.x + rotatedPoint.x; //cur_pose.x
-     paperPoint.y = cur_pose.y + rotatedPoint.y; //cur_pose.y
-     return paperPoint;
+     if (mine->robot != robotName)
+     {
+          Trace_context::hop(hopFleetMine, mine->trace);
+          Detection_map::Detection detection = detectionMap.add(mine->x, mine->y);
+          if (minesSaved)
+          {
+               mineFile.saveMine(detection);
+          }
+     }
 }
 
-visualization_msgs::Marker pointToMark(point markcalc)
+visualization_msgs::Marker pointToMark(const Detection_map::Detection &detection)
 {
      visualization_msgs::Marker marker;
      // Set the frame ID and timestamp.  See the TF tutorials for information on these.
-     marker.header.frame_id = "/odom";
+     marker.header.frame_id = markerFrame;
      marker.header.stamp = ros::Time();
 
      // Set the namespace and id for this marker.  This serves to create a unique ID
-     // Any marker sent with the same namespace and id will overwrite the old one
-     marker.ns = "paper_pose";
-     marker.id = iterationCount;
+     // Any marker sent with the same namespace and id will overwrite the old one, so a merged detection moves its marker.
+     marker.ns = markerNs;
+     marker.id = detection.id;
 
      // Set the marker type.  Initially this is CUBE, and cycles between that and SPHERE, ARROW, and CYLINDER
      marker.type = visualization_msgs::Marker::CUBE;
@@ -359,8 +830,8 @@ visualization_msgs::Marker pointToMark(point markcalc)
      marker.action = visualization_msgs::Marker::ADD;
 
      // Set the pose of the marker.  This is a full 6DOF pose relative to the frame/time specified in the header
-     marker.pose.position.x = markcalc.x;
-     marker.pose.position.y = markcalc.y;
+     marker.pose.position.x = detection.x;
+     marker.pose.position.y = detection.y;
      marker.pose.position.z = 0;
 
      marker.pose.orientation.w = 1.0;
@@ -377,6 +848,5 @@ visualization_msgs::Marker pointToMark(point markcalc)
 
      marker.lifetime = ros::Duration();
 
-     iterationCount++;
      return marker;
 }
\ No newline at end of file
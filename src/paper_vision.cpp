@@ -0,0 +1,282 @@
+#include "paper_vision.h"
+#include "bit_mask.h"
+#include "blob_runs.h"
+#include <algorithm>
+#include <functional>
+
+using namespace Paper_vision;
+
+void Paper_vision::thresholdFrame(const cv::Mat &frame, const Hsv_range &range, cv::Mat &mask)
+{
+    cv::Mat imgHSV;
+    cv::cvtColor(frame, imgHSV, cv::COLOR_BGR2HSV); //Convert the captured frame from BGR to HSV.
+    if (range.lowH <= range.highH)
+    {
+        cv::inRange(imgHSV, cv::Scalar(range.lowH, range.lowS, range.lowV), cv::Scalar(range.highH, range.highS, range.highV), mask); //Threshold the image.
+        return;
+    }
+    //a hue box wrapping around red is the hues from lowH up and the hues up to highH.
+    cv::Mat lower;
+    cv::inRange(imgHSV, cv::Scalar(range.lowH, range.lowS, range.lowV), cv::Scalar(179, range.highS, range.highV), mask);
+    cv::inRange(imgHSV, cv::Scalar(0, range.lowS, range.lowV), cv::Scalar(range.highH, range.highS, range.highV), lower);
+    cv::bitwise_or(mask, lower, mask);
+}
+
+void Paper_vision::thresholdYuv(const Yuv_threshold::Yuv_frame &frame, const Yuv_threshold::Yuv_range &range, cv::Mat &mask)
+{
+    mask.create(frame.height, frame.width, CV_8UC1);
+    Yuv_threshold::threshold(frame, 0, frame.height, range, mask.data, mask.step);
+}
+
+void Paper_vision::yuvToBgr(const Yuv_threshold::Yuv_frame &frame, cv::Mat &bgr)
+{
+    if (frame.format == Yuv_threshold::FORMAT_YUYV)
+    {
+        cv::Mat yuyv(frame.height, frame.width, CV_8UC2, const_cast<uint8_t *>(frame.data), frame.step);
+        cv::cvtColor(yuyv, bgr, cv::COLOR_YUV2BGR_YUYV);
+        return;
+    }
+
+    //OpenCV wants the chroma plane right below the luma plane.
+    cv::Mat nv12;
+    if (frame.uv == frame.data + frame.height * frame.step && frame.uvStep == frame.step)
+    {
+        nv12 = cv::Mat(frame.height * 3 / 2, frame.width, CV_8UC1, const_cast<uint8_t *>(frame.data), frame.step);
+    }
+    else
+    {
+        nv12.create(frame.height * 3 / 2, frame.width, CV_8UC1);
+        cv::Mat luma = nv12.rowRange(0, frame.height);
+        cv::Mat chroma = nv12.rowRange(frame.height, nv12.rows);
+        cv::Mat(frame.height, frame.width, CV_8UC1, const_cast<uint8_t *>(frame.data), frame.step).copyTo(luma);
+        cv::Mat(frame.height / 2, frame.width, CV_8UC1, const_cast<uint8_t *>(frame.uv), frame.uvStep).copyTo(chroma);
+    }
+    cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+}
+
+void Paper_vision::filterMask(cv::Mat &mask, int radius)
+{
+    Bit_mask::bit_Mask bits;
+    Bit_mask::pack(mask.data, mask.step, mask.cols, 0, mask.rows, bits);
+    Bit_mask::filter(bits, radius);
+    Bit_mask::unpack(bits, 0, mask.rows, mask.data, mask.step);
+}
+
+void Paper_vision::filterMaskBytes(cv::Mat &mask)
+{
+    static const cv::Mat element = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
+
+    //Morphological opening (removes small objects from the foreground).
+    cv::erode(mask, mask, element);
+    cv::dilate(mask, mask, element);
+
+    //Morphological closing (removes small holes from the foreground).
+    cv::dilate(mask, mask, element);
+    cv::erode(mask, mask, element);
+}
+
+namespace
+{
+    //boxes top to bottom, then left to right.
+    bool boxBefore(const cv::Rect &a, const cv::Rect &b)
+    {
+        if (a.y != b.y)
+        {
+            return a.y < b.y;
+        }
+        if (a.x != b.x)
+        {
+            return a.x < b.x;
+        }
+        return a.width != b.width ? a.width < b.width : a.height < b.height;
+    }
+} // namespace
+
+void Paper_vision::findBoundingBoxes(cv::Mat &mask, std::vector<std::vector<cv::Point>> &contoursPoly, std::vector<cv::Rect> &boundbox)
+{
+    std::vector<std::vector<cv::Point>> contours; // makes a 2D vector containing points
+    std::vector<cv::Vec4i> hierarchy;
+
+    //the contours of the blobs and of their holes. a blob in the hole of another is a blob of its own, the contour of
+    //a blob has no parent. its box is the box of the blob's pixels, as blobBoxes gives it.
+    cv::findContours(mask, contours, hierarchy, cv::RETR_CCOMP, cv::CHAIN_APPROX_SIMPLE, cv::Point(0, 0));
+
+    std::vector<std::pair<cv::Rect, size_t>> order;
+    for (size_t i = 0; i < contours.size(); i++)
+    {
+        if (hierarchy[i][3] < 0)
+        {
+            order.push_back(std::make_pair(cv::boundingRect(contours[i]), i));
+        }
+    }
+    std::sort(order.begin(), order.end(), [](const std::pair<cv::Rect, size_t> &a, const std::pair<cv::Rect, size_t> &b) {
+        return boxBefore(a.first, b.first);
+    });
+
+    boundbox.resize(order.size());
+    contoursPoly.resize(order.size());
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        cv::approxPolyDP(cv::Mat(contours[order[i].second]), contoursPoly[i], 3, true);
+        boundbox[i] = order[i].first;
+    }
+}
+
+void Paper_vision::processBands(const cv::Mat &frame, const Hsv_range &range, Thread_pool::thread_Pool &pool, int bands,
+                                cv::Mat &mask, std::vector<cv::Rect> &boundbox, int radius)
+{
+    std::vector<Blob_runs::Blob> blobs;
+    processBands(frame, range, pool, bands, mask, blobs, radius);
+    blobBoxes(blobs, boundbox);
+}
+
+namespace
+{
+    //processBands for any frame format. threshold writes the mask of the frame rows [rowBegin, rowEnd) to the band mask.
+    void processBandsWith(int rows, int cols, const std::function<void(int, int, cv::Mat &)> &threshold, Thread_pool::thread_Pool &pool,
+                          int bands, cv::Mat &mask, std::vector<Blob_runs::Blob> &blobs, int radius)
+    {
+        bands = std::max(1, std::min(bands, rows));
+        mask.create(rows, cols, CV_8UC1);
+
+        std::vector<std::vector<Blob_runs::Run>> runs(bands);
+        std::vector<std::vector<int>> parents(bands);
+
+        pool.parallelFor(bands, [&](int band) {
+            int rowBegin = rows * band / bands;
+            int rowEnd = rows * (band + 1) / bands;
+
+            //process the band with its halo rows, so the band rows do not see the cut.
+            int haloBegin = std::max(0, rowBegin - bandHalo);
+            int haloEnd = std::min(rows, rowEnd + bandHalo);
+            cv::Mat bandMask;
+            threshold(haloBegin, haloEnd, bandMask);
+            Bit_mask::bit_Mask bits;
+            Bit_mask::pack(bandMask.data, bandMask.step, bandMask.cols, 0, bandMask.rows, bits);
+            Bit_mask::filter(bits, radius);
+
+            //keep only the band rows, the runs are read from the packed mask.
+            Bit_mask::unpack(bits, rowBegin - haloBegin, rowEnd - haloBegin, mask.ptr(rowBegin), mask.step);
+            Bit_mask::extractRuns(bits, rowBegin - haloBegin, rowEnd - haloBegin, haloBegin, runs[band]);
+            Blob_runs::connectRuns(runs[band], parents[band]);
+        });
+
+        Blob_runs::mergeBands(runs, parents, blobs);
+    }
+} // namespace
+
+void Paper_vision::processBands(const cv::Mat &frame, const Hsv_range &range, Thread_pool::thread_Pool &pool, int bands,
+                                cv::Mat &mask, std::vector<Blob_runs::Blob> &blobs, int radius)
+{
+    processBandsWith(frame.rows, frame.cols, [&](int rowBegin, int rowEnd, cv::Mat &bandMask) {
+        thresholdFrame(frame.rowRange(rowBegin, rowEnd), range, bandMask);
+    }, pool, bands, mask, blobs, radius);
+}
+
+void Paper_vision::processBands(const Yuv_threshold::Yuv_frame &frame, const Yuv_threshold::Yuv_range &range, Thread_pool::thread_Pool &pool, int bands,
+                                cv::Mat &mask, std::vector<cv::Rect> &boundbox, int radius)
+{
+    std::vector<Blob_runs::Blob> blobs;
+    processBandsWith(frame.height, frame.width, [&](int rowBegin, int rowEnd, cv::Mat &bandMask) {
+        bandMask.create(rowEnd - rowBegin, frame.width, CV_8UC1);
+        Yuv_threshold::threshold(frame, rowBegin, rowEnd, range, bandMask.data, bandMask.step);
+    }, pool, bands, mask, blobs, radius);
+    blobBoxes(blobs, boundbox);
+}
+
+void Paper_vision::processClasses(const cv::Mat &frame, const Colour_lut::colour_Table &table, Thread_pool::thread_Pool &pool, int bands,
+                                  cv::Mat &classes, std::vector<std::vector<Blob_runs::Blob>> &blobs, int radius)
+{
+    int rows = frame.rows;
+    int count = table.classes().size();
+    bands = std::max(1, std::min(bands, rows));
+    classes.create(rows, frame.cols, CV_8UC1);
+
+    //runs[k][band] are the runs of class k in the band.
+    std::vector<std::vector<std::vector<Blob_runs::Run>>> runs(count, std::vector<std::vector<Blob_runs::Run>>(bands));
+    std::vector<std::vector<std::vector<int>>> parents(count, std::vector<std::vector<int>>(bands));
+
+    pool.parallelFor(bands, [&](int band) {
+        int rowBegin = rows * band / bands;
+        int rowEnd = rows * (band + 1) / bands;
+        int haloBegin = std::max(0, rowBegin - bandHalo);
+        int haloEnd = std::min(rows, rowEnd + bandHalo);
+
+        cv::Mat bandClasses(haloEnd - haloBegin, frame.cols, CV_8UC1);
+        table.classify(frame.data, frame.step, frame.cols, haloBegin, haloEnd, bandClasses.data, bandClasses.step);
+        cv::Mat bandRows = classes.rowRange(rowBegin, rowEnd);
+        bandClasses.rowRange(rowBegin - haloBegin, rowEnd - haloBegin).copyTo(bandRows);
+
+        Bit_mask::bit_Mask bits[Colour_lut::max_classes];
+        Bit_mask::packClasses(bandClasses.data, bandClasses.step, bandClasses.cols, 0, bandClasses.rows, count, bits);
+        for (int k = 0; k < count; k++)
+        {
+            if (radius > 0)
+            {
+                Bit_mask::filter(bits[k], radius);
+            }
+            Bit_mask::extractRuns(bits[k], rowBegin - haloBegin, rowEnd - haloBegin, haloBegin, runs[k][band]);
+            Blob_runs::connectRuns(runs[k][band], parents[k][band]);
+        }
+    });
+
+    blobs.resize(count);
+    for (int k = 0; k < count; k++)
+    {
+        Blob_runs::mergeBands(runs[k], parents[k], blobs[k]);
+    }
+}
+
+void Paper_vision::processRegion(const cv::Mat &frame, const Hsv_range &range, const cv::Rect &region, cv::Mat &mask)
+{
+    //extend the region by the halo on all sides, as far as the frame goes.
+    int x0 = std::max(0, region.x - bandHalo);
+    int y0 = std::max(0, region.y - bandHalo);
+    int x1 = std::min(frame.cols, region.x + region.width + bandHalo);
+    int y1 = std::min(frame.rows, region.y + region.height + bandHalo);
+    cv::Rect halo(x0, y0, x1 - x0, y1 - y0);
+
+    cv::Mat regionMask;
+    thresholdFrame(frame(halo), range, regionMask);
+    filterMask(regionMask);
+
+    cv::Mat regionRows = mask(region);
+    regionMask(cv::Rect(region.x - x0, region.y - y0, region.width, region.height)).copyTo(regionRows);
+}
+
+void Paper_vision::labelRows(const cv::Mat &mask, int rowBegin, int rowEnd, std::vector<Blob_runs::Blob> &blobs)
+{
+    std::vector<std::vector<Blob_runs::Run>> runs(1);
+    std::vector<std::vector<int>> parents(1);
+    Blob_runs::extractRuns(mask.data, mask.step, mask.cols, rowBegin, rowEnd, runs[0]);
+    Blob_runs::connectRuns(runs[0], parents[0]);
+
+    std::vector<Blob_runs::Blob> found;
+    Blob_runs::mergeBands(runs, parents, found);
+    blobs.insert(blobs.end(), found.begin(), found.end());
+}
+
+void Paper_vision::blobBoxes(const std::vector<Blob_runs::Blob> &blobs, std::vector<cv::Rect> &boundbox)
+{
+    boundbox.resize(blobs.size());
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        boundbox[i] = cv::Rect(blobs[i].minX, blobs[i].minY, blobs[i].maxX - blobs[i].minX + 1, blobs[i].maxY - blobs[i].minY + 1);
+    }
+    std::sort(boundbox.begin(), boundbox.end(), boxBefore);
+}
+
+void Paper_vision::mine_Trigger::update(const std::vector<cv::Rect> &boundbox, std::vector<cv::Rect> &mines)
+{
+    lastSurface.resize(boundbox.size());
+    for (size_t i = 0; i < boundbox.size(); i++)
+    {
+        int surface = boundbox[i].width * boundbox[i].height;
+        if (lastSurface[i] - surface > surfaceLimit)
+        {
+            mines.push_back(boundbox[i]);
+        }
+        lastSurface[i] = surface;
+    }
+}
@@ -1,33 +1,69 @@
 //include packages
 
 #include "ros/ros.h"
+#include "ros/callback_queue.h"
 #include "geometry_msgs/Twist.h"
 #include "std_msgs/Float32.h"
 #include "mine_detection/Obstacle.h"
+#include "mine_detection/FleetState.h"
 
 #include <math.h>
 #include <iostream>
 #include <turtlesim/Pose.h>
 #include <nav_msgs/Odometry.h>
-#include <std_msgs/Empty.h>
 #include <visualization_msgs/Marker.h>
 #include <move.h>
 #include <points_gen.h>
+#include <pose_history.h>
+#include <obstacle.h>
+#include <quaternion.h>
+#include <latency_diagnostics.h>
+#include <marker_sidecar.h>
+#include <coverage_map.h>
+#include <path_plan.h>
+#include <fleet.h>
+#include <field_partition.h>
+#include <camera_model.h>
+#include <mission_state.h>
+#include <mission_log.h>
+#include <startup_sequence.h>
+#include <lane_planner.h>
+#include <trace_context.h>
+#include <memory>
 
 //include namespaces.
 using namespace std;
 using namespace N;
 using namespace Points_gen;
+using Obstacle_avoidance::Obstacle_Point;
 
 //Initialize ros semantics.
-ros::Publisher reset_pub;
 ros::Publisher vel_pub;
+//connects the base, resets its odometry and waits for the start of the mission.
+Startup_sequence::startup_Sequence startup;
 ros::Subscriber sub_pose;
-ros::Publisher points_pub;
+//markers of the path and the obstacle, published on a background thread.
+Marker_sidecar::marker_Sidecar markers;
+ros::Publisher coverage_pub;
+ros::Publisher fleet_pub;
+ros::Subscriber fleet_sub;
+
+//odometry is handled on its own queue and thread, so the pose keeps updating while the control loops run.
+ros::CallbackQueue odom_queue;
 
 ros::Subscriber obstacle_sub;
 
-ros::Publisher *pointPtr;
+//latency stages of the planner and the control loops.
+const int stage_odom = Latency_trace::stage("odom_callback");
+const int stage_obstacle = Latency_trace::stage("obstacle_callback");
+const int stage_plan = Latency_trace::stage("plan_lane");
+const int stage_rotate = Latency_trace::stage("rotate_iteration");
+const int stage_move = Latency_trace::stage("move2goal_iteration");
+const int stage_reorder = Latency_trace::stage("reorder_lanes");
+//hops of the obstacle chain, from the stamp of the scan to the velocity command of the detour.
+const int hop_obstacle = Latency_trace::stage("obstacle_received");
+const int hop_detour = Latency_trace::stage("detour_planned");
+const int hop_velocity = Latency_trace::stage("detour_cmd_vel");
 
 //create a vector2D struct
 struct Vector2D
@@ -44,12 +80,15 @@ Vector2D vectorByAngle(double angle);
 double getTheta(double angle);
 void rotate(Point goal);
 void poseCallback(const nav_msgs::Odometry::ConstPtr &pose_message);
+bool updatePose();
+void updateCoverage();
 visualization_msgs::Marker getRvizObstacle(const Vector2D *center, double radius);
 double euclidean_distance(double x1, double y1, double x2, double y2);
 double linear_velocity(Point goal);
 double angular_velocity(Point goal);
 double getAngle(Point goal);
 void move2goal(Point goal, Point stop_goal);
+void publishVelocity(const geometry_msgs::Twist &vel_msg);
 
 //point distance tolerance.
 const double distance_tolerance = 0.10;
@@ -60,59 +99,64 @@ Vector2D offset = {0.08, 0.025};
 Vector2D obstacle_odom;
 //obstacle radius
 double radius;
+//the scan of the obstacle, and of the detour whose first velocity command is not sent yet.
+mine_detection::TraceContext obstacle_trace;
+mine_detection::TraceContext detour_trace;
 double contour_offset = 0.25; //robot offset in meters
 double robot_radius = 0.175;  //robot radius in meters
+//set the path radius to be around the obstacle, with a contour offset.
+double path_radius = radius + robot_radius + contour_offset;
 
 //current turtlebot pose using the turtlesim object type.
+//only the main thread uses it, updatePose() refreshes it from the odometry thread.
 turtlesim::Pose cur_pose;
 
-#pragma region Quaternion To Euler Angles conversion
-struct Quaternion
-{
-    double x, y, z, w;
-};
-
-struct EulerAngles
-{
-    double roll, pitch, yaw;
-};
-
-EulerAngles angles;
-
-//convert quarternion into eulerangles.
-EulerAngles ToEulerAngles(Quaternion q)
-{
-    EulerAngles angles;
-
-    //roll (x axis rotation)
-    double sinr_cosp = 2 * (q.w * q.x - q.y * q.z);
-    double cosr_cosp = 1 - 2 * (q.x * q.x + q.y * q.y);
-    angles.roll = atan2(sinr_cosp, cosr_cosp);
-
-    //pitch (y axis rotation)
-    double sinp = 2 * (q.w * q.y - q.z * q.x);
-    if (abs(sinp) >= 1)
-        //copysign returns the magnitude of M_PI/2 with the sign of sinp
-        angles.pitch = copysign(M_PI / 2, sinp); // use 90 degrees if out of range
-    else
-        angles.pitch = asin(sinp);
-
-    // yaw (z-axis rotation)
-    double siny_cosp = 2 * (q.w * q.z + q.x * q.y);
-    double cosy_cosp = 1 - 2 * (q.y * q.y + q.z * q.z);
-    //calculate yaw, and make the yaw angle be 0 < yaw < 2pi.
-    angles.yaw = std::atan2(siny_cosp, cosy_cosp);
-
-    return angles;
-}
-#pragma endregion
-
-//Callback function when a odometry message is recieved.
+//recent odometry poses, written by the odometry thread.
+//used to read the newest pose without locking, and to look up where the robot was when a sensor measurement was taken.
+Pose_history::pose_Buffer pose_history;
+
+//where the odometry of this robot starts in the field frame. all planning is done in the field frame.
+Fleet::field_Frame field_frame;
+//name of this robot in the fleet, and the frame and namespace of its markers.
+std::string robot_name;
+std::string marker_frame = "/odom";
+std::string marker_ns = "Path namespace";
+//the lanes of this robot.
+Field_partition::Region region = {0, 0};
+
+//ground covered by the robot and the camera, in the field frame. only the main thread uses it.
+std::unique_ptr<Coverage_map::coverage_Map> coverage_map;
+//the cameras whose footprints count as covered.
+std::vector<Camera_model::Camera> coverage_cameras;
+//pose the coverage was last marked at.
+turtlesim::Pose coverage_pose;
+bool coverage_marked = false;
+//distance the robot moves before the coverage is marked again, half a cell of ~coverage_resolution.
+double coverage_step = 0.01;
+
+//the mission saved as it goes, so a restarted node continues it. only used with the ~state_file parameter.
+Mission_state::mission_File mission;
+bool mission_saved = false;
+//odometry as it arrives, for log_replay. only used with the ~log_file parameter.
+Mission_log::log_Writer mission_log;
+
+//plans the lanes ahead of the robot while it drives, only used with ~plan_lanes_ahead above 0.
+Lane_planner::lane_Planner lane_planner;
+
+//on resume the field frame is set by the first odometry pose, so that pose is the last saved one.
+bool resume_frame = false;
+Pose_history::Stamped_pose resume_pose;
+
+//Callback function when a odometry message is recieved. Runs on the odometry thread.
 void poseCallback(const nav_msgs::Odometry::ConstPtr &pose_message)
 {
+    Latency_trace::Scoped_timer timer(stage_odom);
+    Pose_history::Stamped_pose stamped;
+    stamped.stamp = pose_message->header.stamp.toSec();
+
     // Get the x,y position.
-    cur_pose.x = pose_message->pose.pose.position.x;
-    cur_pose.y = pose_message->pose.pose.position.y;
+    stamped.x = pose_message->pose.pose.position.x;
+    stamped.y = pose_message->pose.pose.position.y;
 
     // Quaternion object q.
     Quaternion q;
@@ -124,32 +168,193 @@ void poseCallback(const nav_msgs::Odometry::ConstPtr &pose_message)
     q.w = pose_message->pose.pose.orientation.w;
 
     // Retrieve Euler angles from quaternion pose message.
-    angles = ToEulerAngles(q);
+    EulerAngles angles = ToEulerAngles(q);
     
     //assign the yaw angle to current orientation.
-    cur_pose.theta = angles.yaw;
+    stamped.theta = angles.yaw;
+    mission_log.odom(stamped.stamp, stamped.x, stamped.y, stamped.theta);
+    startup.odometry(stamped.stamp);
 
-    //std::cout << "angle: " << angles.yaw << " x: " << cur_pose.x << " y: " << cur_pose.y << std::endl;
+    //the odometry may have been reset with the robot, the saved pose is where it is in the field.
+    if (resume_frame)
+    {
+        field_frame = Fleet::field_Frame::matching(resume_pose, stamped);
+        resume_frame = false;
+    }
+
+    //publish the pose to the control thread.
+    pose_history.push(field_frame.toField(stamped));
+
+    //std::cout << "angle: " << angles.yaw << " x: " << stamped.x << " y: " << stamped.y << std::endl;
+}
+
+//copy the newest odometry pose into cur_pose. returns false if no odometry has been received yet.
+bool updatePose()
+{
+    Pose_history::Stamped_pose latest;
+    if (!pose_history.latest(latest))
+    {
+        return false;
+    }
+    cur_pose.x = latest.x;
+    cur_pose.y = latest.y;
+    cur_pose.theta = latest.theta;
+    updateCoverage();
+    return true;
+}
+
+//mark the ground swept by the robot and seen by the camera since the last call.
+void updateCoverage()
+{
+    if (!coverage_map)
+    {
+        return;
+    }
+    //wait until the robot moved half a cell or turned, the control loops call this much faster than that.
+    if (coverage_marked && euclidean_distance(coverage_pose.x, coverage_pose.y, cur_pose.x, cur_pose.y) < coverage_step &&
+        fabs(remainder(cur_pose.theta - coverage_pose.theta, 2 * M_PI)) < 0.05)
+    {
+        return;
+    }
+    if (!coverage_marked)
+    {
+        coverage_pose = cur_pose;
+        coverage_marked = true;
+    }
+    coverage_map->markSwept(coverage_pose.x, coverage_pose.y, cur_pose.x, cur_pose.y, robot_radius);
+
+    for (size_t c = 0; c < coverage_cameras.size(); c++)
+    {
+        const Camera_model::Camera &camera = coverage_cameras[c];
+        //the corners of the image, in order around it.
+        double corners[4][2] = {{0, 0}, {double(camera.imageWidth), 0}, {double(camera.imageWidth), double(camera.imageHeight)}, {0, double(camera.imageHeight)}};
+        std::vector<Camera_model::point> footprint(4);
+        for (int i = 0; i < 4; i++)
+        {
+            Camera_model::point corner;
+            corner.x = corners[i][0];
+            corner.y = corners[i][1];
+            footprint[i] = Camera_model::convertCoordinatesOfPoint(corner, cur_pose, camera);
+        }
+        coverage_map->markPolygon(footprint);
+    }
+
+    coverage_pose = cur_pose;
+}
+
+//true if the ground of the points of span s is covered already.
+bool isCovered(const Path_plan::lane_Path &path, size_t s, double min_coverage)
+{
+    const Path_plan::Span &span = path.span(s);
+    for (int i = span.begin; i < span.end; i++)
+    {
+        if (coverage_map->diskCoverage(path.point(i).x, path.point(i).y, robot_radius) < min_coverage)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//the first span of the lane after the lane of span s, or the end of the path.
+size_t nextLaneStart(const Path_plan::lane_Path &path, size_t s)
+{
+    s++;
+    while (s < path.size() && !path.laneStart(s))
+    {
+        s++;
+    }
+    return s;
+}
+
+//save where the mission is. the kernel writes the pages back, at the end of a span they are synced.
+void saveCheckpoint(size_t s, int offset)
+{
+    Mission_state::Progress progress = {int32_t(s), offset, {cur_pose.x, cur_pose.y, cur_pose.theta}, obstacle_odom.x, obstacle_odom.y, radius};
+    mission.saveProgress(progress);
+    mission.saveCoverage(*coverage_map);
+}
+
+//share this robot's state with the fleet. runs on the main thread while it spins.
+void publishFleetState(const ros::TimerEvent &)
+{
+    mine_detection::FleetState msg;
+    msg.robot = robot_name;
+    msg.x = cur_pose.x;
+    msg.y = cur_pose.y;
+    msg.theta = cur_pose.theta;
+    msg.first_lane = region.firstLane;
+    msg.last_lane = region.lastLane;
+    msg.coverage = coverage_map->coverage();
+    const Bit_mask::bit_Mask &covered = coverage_map->covered();
+    msg.rows = covered.rows;
+    msg.cols = covered.cols;
+    msg.covered = covered.words;
+    fleet_pub.publish(msg);
+}
+
+//add the ground covered by the other robots, so lanes they already covered are skipped.
+void fleetStateCallback(const mine_detection::FleetState::ConstPtr &msg)
+{
+    if (msg->robot == robot_name)
+    {
+        return;
+    }
+    if (!coverage_map->merge(msg->rows, msg->cols, msg->covered))
+    {
+        ROS_WARN_THROTTLE(10, "Coverage of %s has a different grid, is the field the same?", msg->robot.c_str());
+    }
+}
+
+//publish and print the part of the field covered.
+void reportCoverage()
+{
+    std_msgs::Float32 msg;
+    msg.data = coverage_map->coverage() * 100;
+    coverage_pub.publish(msg);
+    std::cout << std::fixed << std::setprecision(2) << msg.data << "% covered." << std::endl;
 }
 
 //Callback function when an obstacle message is recieved.
 void obstacleCallback(const mine_detection::Obstacle::ConstPtr &obs_msg)
 {
+    Latency_trace::Scoped_timer timer(stage_obstacle);
+
+    Trace_context::hop(hop_obstacle, obs_msg->trace);
+    obstacle_trace = obs_msg->trace;
+
     //Obstacle position compared to the robot base.
     Vector2D obstacle_robot;
     obstacle_robot.x = obs_msg->x - offset.x;
     obstacle_robot.y = obs_msg->y - offset.y;
-    
+
+    //use the pose the robot had when the scan was taken, fall back to the current pose if it is too old.
+    double scan_stamp = obs_msg->trace.origin.toSec();
+    Pose_history::Stamped_pose scan_pose = {scan_stamp, cur_pose.x, cur_pose.y, cur_pose.theta};
+    if (!pose_history.lookup(scan_stamp, scan_pose))
+    {
+        ROS_WARN_THROTTLE(1, "No odometry for obstacle scan, using current pose.");
+    }
+
     //rotate obstacle center around the robot center, to match the odometry orientation.
-    Vector2D obstacle_robot_rotated = rotateVectorByAngle(getTheta(cur_pose.theta), obstacle_robot);
-    
+    Vector2D obstacle_robot_rotated = rotateVectorByAngle(getTheta(scan_pose.theta), obstacle_robot);
+
     //assign the obstacle to the obstacle odom object.
-    obstacle_odom.x = cur_pose.x + obstacle_robot_rotated.x;
-    obstacle_odom.y = cur_pose.y + obstacle_robot_rotated.y;
+    obstacle_odom.x = scan_pose.x + obstacle_robot_rotated.x;
+    obstacle_odom.y = scan_pose.y + obstacle_robot_rotated.y;
     radius = obs_msg->r;
+    if (lane_planner.running())
+    {
+        Obstacle_Point obstacle = {obstacle_odom.x, obstacle_odom.y};
+        lane_planner.obstacle(obstacle, path_radius);
+    }
     
-    //call rviz publish pointer to publish the returned rviz obstacle from getRvizObstacle().
-    pointPtr->publish(getRvizObstacle(&obstacle_odom, obs_msg->r));
+    //the obstacle is replaced with every scan, so its marker is only built while rviz shows it.
+    if (markers.wanted())
+    {
+        visualization_msgs::Marker marker = getRvizObstacle(&obstacle_odom, obs_msg->r);
+        markers.update(marker);
+    }
 }
 
 //get cylinder to publish in rviz.
@@ -157,8 +362,8 @@ visualization_msgs::Marker getRvizObstacle(const Vector2D *center, double radius
 {
     //define a visualization marker with the obstacle center and a radius, and make it white.
     visualization_msgs::Marker points;
-    points.header.frame_id = "/odom";
-    points.ns = "obstacle namespace";
+    points.header.frame_id = marker_frame;
+    points.ns = "obstacle namespace" + robot_name;
     points.action = visualization_msgs::Marker::ADD;
 
     points.pose.orientation.w = 1.0;
@@ -188,33 +393,11 @@ visualization_msgs::Marker getRvizObstacle(const Vector2D *center, double radius
     return points;
 }
 
-//Return new path point which is offset to the edge of the obstacle.
-Point offsetPointInObstacle(Point path_point, double r, Vector2D obstacle)
-{
-    //get angle to offset the point to the edge.
-    double angle = asin((obstacle.y - path_point.y) / r); 
-    
-    //if in the left side of the obstacle, offset points to the left.
-    //this ensures the shortest path around the obstacle.
-    if (path_point.x > obstacle.x)
-    {
-        
-        path_point.x = obstacle.x + r * cos(angle);
-        return path_point;
-    }
-    else
-    {
-        path_point.x = obstacle.x + r * (-cos(angle));
-        return path_point;
-    }
-}
-//set the path radius to be around the obstacle, with a contour offset.
-double path_radius = radius + robot_radius + contour_offset;
-
 //if the point is in obstacle.
 bool isInObstacle(Point p)
 {
-    return euclidean_distance(p.x, p.y, obstacle_odom.x, obstacle_odom.y) < path_radius;
+    Obstacle_Point obstacle = {obstacle_odom.x, obstacle_odom.y};
+    return Obstacle_avoidance::isInObstacle(p, obstacle, path_radius);
 }
 
 int main(int argc, char *argv[])
@@ -224,26 +407,73 @@ int main(int argc, char *argv[])
     ros::NodeHandle n;
 
     //assign semantics to the right topics and with the right queue sizes. 
-    points_pub = n.advertise<visualization_msgs::Marker>("/visualization_marker", 200);
-    reset_pub = n.advertise<std_msgs::Empty>("/mobile_base/commands/reset_odometry", 10);
-    vel_pub = n.advertise<geometry_msgs::Twist>("/cmd_vel_mux/input/navi", 10);
-    sub_pose = n.subscribe("/odom", 1000, &poseCallback);
-    obstacle_sub = n.subscribe("/obstacle", 10, &obstacleCallback);
-
-    //assign the reference of points_pub to pointPtr.
-    pointPtr = &points_pub;
-
-    //wait untill the mobile base is connected to reset odometry. 
-    ROS_INFO("Resetting odometry...");
-    while (reset_pub.getNumSubscribers() == 0)
+    //the robot's topics are relative, so several robots can run in their own namespaces. the markers of all robots go to one rviz.
+    markers.start(n);
+    obstacle_sub = n.subscribe("obstacle", 10, &obstacleCallback);
+    coverage_pub = n.advertise<std_msgs::Float32>("coverage", 10);
+
+    //in a fleet the odometry is converted to the field frame, so it has to be known before the first pose arrives.
+    std::vector<Fleet::Robot> robots = Fleet::loadRobots();
+    robot_name = Fleet::robotName();
+    field_frame = Fleet::field_Frame::load();
+    if (!robots.empty())
     {
-        ros::spinOnce();
+        marker_frame = Fleet::markerFrame();
+        marker_ns += robot_name;
+    }
+
+    //size of the field in meters, x along the length and y along the width.
+    double field_length;
+    double field_width;
+    ros::NodeHandle("~").param("field_length", field_length, 3.0);
+    ros::NodeHandle("~").param("field_width", field_width, 2.9);
+    double coverage_resolution;
+    ros::NodeHandle("~").param("coverage_resolution", coverage_resolution, 0.02);
+    coverage_step = coverage_resolution / 2;
+
+    //with a state file the mission is saved as it goes, and is resumed if the node is restarted before it is done.
+    std::string state_file;
+    bool resume;
+    ros::NodeHandle("~").param("state_file", state_file, std::string());
+    ros::NodeHandle("~").param("resume", resume, true);
+    Mission_state::Field field = {field_length, field_width, coverage_resolution, 0, 0};
+    Mission_state::Progress progress = {};
+    bool resuming = !state_file.empty() && resume && mission.open(state_file, field) && mission.loadProgress(progress);
+    if (resuming)
+    {
+        Pose_history::Stamped_pose saved = {0, progress.pose.x, progress.pose.y, progress.pose.theta};
+        resume_pose = saved;
+        resume_frame = true;
+    }
+
+    //the odometry is logged before it is converted to the field frame, so a replay gives the node what the base sent.
+    std::string log_file;
+    ros::NodeHandle("~").param("log_file", log_file, std::string());
+    if (!log_file.empty())
+    {
+        log_file = Mission_log::startPath(log_file);
+        if (!mission_log.open(log_file))
+        {
+            ROS_ERROR("Could not create the log %s.", log_file.c_str());
+        }
     }
 
-    //publish empty string to reset odometry.
-    std_msgs::Empty e;
-    reset_pub.publish(e);
-    ROS_INFO("Reset succesfully");
+    //subscribe to odometry on its own queue with room for only the newest message, so no backlog of old poses builds up.
+    ros::SubscribeOptions odom_options = ros::SubscribeOptions::create<nav_msgs::Odometry>("odom", 1, &poseCallback, ros::VoidPtr(), &odom_queue);
+    sub_pose = n.subscribe(odom_options);
+    ros::AsyncSpinner odom_spinner(1, &odom_queue);
+    odom_spinner.start();
+
+    Latency_trace::diagnostics_Publisher diagnostics;
+    diagnostics.start(n, "path_basis");
+
+    //the odometry is reset as soon as the mobile base connects, while the mission is planned below.
+    //a resumed mission keeps the odometry, its field frame is matched to the saved pose instead.
+    //a new mission starts with the start_mission service, or right away with ~auto_start, a resumed one right away.
+    bool auto_start;
+    ros::NodeHandle("~").param("auto_start", auto_start, false);
+    startup.start(n, !resuming, auto_start || resuming);
+    vel_pub = startup.velocity();
 
     ros::Rate loop_rate(10);
 
@@ -255,114 +485,294 @@ int main(int argc, char *argv[])
     //create a vector of points.
     std::vector<Points_gen::Point> vec;
 
+    //the lanes are as far apart as the cameras allow, see config/cameras.yaml for ~cameras. neighbouring lanes share
+    //~lane_overlap of the strip the cameras see.
+    coverage_cameras = Camera_model::loadCameras(ros::NodeHandle("~"));
+    double lane_overlap;
+    ros::NodeHandle("~").param("lane_overlap", lane_overlap, 0.0);
+    double lane_spacing = Points_gen::laneSpacing(coverage_cameras, lane_overlap, 2 * robot_radius);
+
     //retrieve points from pointsgen.cpp file.
-    vec = points_instance.gen_Point_list();
+    vec = points_instance.gen_Point_list(field_length, field_width, lane_spacing);
+
+    //lanes whose points are covered to this part, e.g. by a detour or the camera on the neighbouring lane, are skipped.
+    //above 1 nothing is skipped.
+    double skip_coverage;
+    ros::NodeHandle("~").param("skip_coverage", skip_coverage, 0.98);
+
+    //after a detour or skipped lanes the remaining lanes are reordered at the next lane start, within this many seconds.
+    //0 keeps the original order.
+    double reorder_budget;
+    ros::NodeHandle("~").param("reorder_budget", reorder_budget, 0.05);
+    bool route_changed = false;
+
+    //the lanes after the current one are reordered and detoured by the planner thread while the robot drives, this many
+    //lanes ahead. 0 plans every lane at its start, with the robot standing.
+    int plan_lanes_ahead;
+    ros::NodeHandle("~").param("plan_lanes_ahead", plan_lanes_ahead, 1);
+    if (plan_lanes_ahead > 0)
+    {
+        lane_planner.start(plan_lanes_ahead, reorder_budget);
+    }
+    //counts the changes of the path, a plan made for an older path is not used.
+    uint64_t path_version = 0;
+    coverage_map.reset(new Coverage_map::coverage_Map(0, 0, field_length, field_width, coverage_resolution));
+    if (resuming)
+    {
+        mission.loadCoverage(*coverage_map);
+    }
 
-    //check if points pub has subscribers.
+    //in a fleet every robot drives its own block of lanes, and the robots share what they covered.
+    region.lastLane = vec.empty() ? -1 : vec.back().lane;
+    ros::Timer fleet_timer;
+    if (!robots.empty())
+    {
+        std::vector<Field_partition::Start> starts;
+        int index = -1;
+        for (size_t r = 0; r < robots.size(); r++)
+        {
+            Field_partition::Start start = {robots[r].x, robots[r].y};
+            starts.push_back(start);
+            if (robots[r].name == robot_name)
+            {
+                index = r;
+            }
+        }
 
-    ros::Rate retry_rate(1);
-    for (int i = 0; i < 10; i++)
+        if (index < 0 && !resuming)
+        {
+            ROS_WARN("Robot %s is not in /fleet/robots, covering the whole field.", robot_name.c_str());
+        }
+        else
+        {
+            //a resumed robot keeps its lanes, the other robots may have moved since the field was split.
+            if (resuming)
+            {
+                region.firstLane = mission.field().firstLane;
+                region.lastLane = mission.field().lastLane;
+            }
+            else
+            {
+                std::vector<Field_partition::Region> regions = Field_partition::partitionLanes(region.lastLane + 1, lane_spacing, field_width, robot_radius, starts);
+                region = regions[index];
+            }
+            std::vector<Point> own;
+            for (size_t i = 0; i < vec.size(); i++)
+            {
+                if (vec[i].lane >= region.firstLane && vec[i].lane <= region.lastLane)
+                {
+                    own.push_back(vec[i]);
+                }
+            }
+            vec.swap(own);
+            //the robot starts away from its first lane, so the lanes are ordered from its start pose.
+            route_changed = true;
+            ROS_INFO("Robot %s covers lanes %d to %d of the field.", robot_name.c_str(), region.firstLane, region.lastLane);
+        }
+
+        double fleet_period;
+        ros::NodeHandle("~").param("fleet_period", fleet_period, 1.0);
+        fleet_pub = n.advertise<mine_detection::FleetState>("/fleet/state", 10);
+        fleet_sub = n.subscribe("/fleet/state", 10, &fleetStateCallback);
+        fleet_timer = n.createTimer(ros::Duration(fleet_period), &publishFleetState);
+    }
+
+    //the path as spans between stops. detours and reordered lanes change only the spans not driven yet.
+    Path_plan::lane_Path path(vec);
+
+    //a resumed mission continues at the start of the lane it was on, with its detours and lane order.
+    //without a saved path the path is driven from the start, its covered spans are skipped.
+    size_t s = 0;
+    int offset = 0;
+    if (resuming)
     {
-        if (points_pub.getNumSubscribers() != 0)
+        if (mission.loadPath(path))
         {
-            //publish points to rviz.
-            points_instance.rvizPoints(points_pub, vec);
-            ROS_INFO("Connected to rviz.");
-            break;
+            s = std::min(size_t(std::max(progress.span, 0)), path.size());
+            while (s > 0 && s < path.size() && !path.laneStart(s))
+            {
+                s--;
+            }
         }
-        ROS_WARN("Connecting to rviz...");
-        if (i == 9)
+        else
         {
-            ROS_ERROR("Could not connect to rviz.");
-            break;
+            ROS_WARN("The saved path is torn, planning it again.");
+            route_changed = true;
         }
-        retry_rate.sleep();
+        obstacle_odom.x = progress.obstacleX;
+        obstacle_odom.y = progress.obstacleY;
+        radius = progress.obstacleR;
+        mission_saved = true;
+        ROS_INFO("Resuming the mission at span %zu of %zu, %.2f%% covered.", s, path.size(), coverage_map->coverage() * 100);
+    }
+    else if (!state_file.empty())
+    {
+        field.firstLane = region.firstLane;
+        field.lastLane = region.lastLane;
+        mission_saved = mission.create(state_file, field, *coverage_map);
+        if (!mission_saved)
+        {
+            ROS_ERROR("Could not create the state file %s, the mission is not saved.", state_file.c_str());
+        }
+    }
+    if (mission_saved)
+    {
+        mission.savePath(path);
     }
 
-    std::cin.get();
-    //process callback to ensure connections are established.
-    ros::spinOnce();
+    //the lanes and the length of the path left, for the operator to check before starting the mission.
+    std::vector<Point> ahead = path.flatten(s);
+    int lane_count = Points_gen::laneCount(ahead);
+    double mission_length = Points_gen::pathLength(ahead);
+    ros::NodeHandle("~").setParam("lane_spacing", lane_spacing);
+    ros::NodeHandle("~").setParam("lane_count", lane_count);
+    ros::NodeHandle("~").setParam("mission_length", mission_length);
+    ROS_INFO("%d lanes %.3f m apart, %.1f m of path.", lane_count, lane_spacing, mission_length);
 
-    double percentage = 0;
+    //the path is shown as soon as rviz connects, the planner does not wait for it.
+    points_instance.rvizPoints(markers, path.flatten(), marker_frame, marker_ns);
 
-    //check if vel_pub has subscribers.
-    if (vel_pub.getNumSubscribers() != 0)
+    //wait for the base and the start without spinning.
+    if (startup.waitForStart())
     {
-        //loop through the vector.
-        for (int i = 0; i < vec.size(); i++)
+        //drive to every point of every span, offset is the index of the point in span s.
+        while (s < path.size())
         {
             ros::spinOnce();
-            percentage = i;
-            std::cout << std::fixed << std::setprecision(2) << percentage / 195 * 100 << "% cleared." << std::endl;
-
-            //create a point from each element.
-            Point p = vec[i];
+            updatePose();
+            reportCoverage();
 
-            //temp is used to count until a stop points is reached.
-            int temp = i;
-
-            //if at stop: rotate.
-            if (vec[temp].stop || vec[temp - 1].stop)
-            {
-                rotate(p);
-            }
-            //initialize to counters to start at the current index.
-            int count = i;
-            int count2 = i;
-            
-            //as long as there is no stop point...
-            while (!vec[count2].stop)
+            if (offset == 0)
             {
-                //check if the point is in obstacle.
-                if (isInObstacle(vec[count2]))
+                //skip the span if its ground has been covered already.
+                if (isCovered(path, s, skip_coverage))
                 {
-                    //as long as it is not in obstacle, and not a stop point.
-                    while (!isInObstacle(vec[count]) && !vec[count].stop)
-                    {
-                        //increment first counter 
-                        count++;
-                    };
-                    //when in obstacle, set stop point before obstacle.
-                    if (isInObstacle(vec[count]))
+                    ROS_INFO("Skipping covered points of span %zu.", s);
+                    s++;
+                    route_changed = true;
+                    continue;
+                }
+
+                //at the start of a lane, splice in the rest of the path the planner prepared while the last lane was
+                //driven. without a plan, e.g. at the first lane, find a better order for the rest if the path changed.
+                bool reorder = route_changed && reorder_budget > 0;
+                Lane_planner::Lane_plan plan;
+                if (path.laneStart(s) && lane_planner.running() && lane_planner.take(path_version, s, reorder, plan))
+                {
+                    if (plan.reordered || plan.detours > 0)
                     {
-                        vec[count - 1].stop = true;
+                        path.replaceFrom(s, plan.points);
+                        path_version++;
+                        if (plan.reordered)
+                        {
+                            ROS_INFO("Reordered the remaining lanes ahead, %.2f m of transit.", plan.transit);
+                        }
+                        points_instance.rvizPoints(markers, path.flatten(), marker_frame, marker_ns);
+                        if (mission_saved)
+                        {
+                            mission.savePath(path);
+                        }
                     }
-                    //while in obstacle, and not a stop point. 
-                    while (isInObstacle(vec[count]) && !vec[count].stop)
-                    {
-                        //offset points by the path radius.
-                        vec[count] = offsetPointInObstacle(vec[count], path_radius, obstacle_odom);
-                        //increment first counter
-                        count++;
-                    };
-                    //set stop point after obstacle.
-                    if (isInObstacle(vec[count - 1]))
+                    route_changed = false;
+                }
+                else if (reorder && path.laneStart(s))
+                {
+                    Latency_trace::Scoped_timer timer(stage_reorder);
+                    double transit;
+                    if (path.reorderLanes(s, cur_pose.x, cur_pose.y, reorder_budget, transit))
                     {
-                        vec[count].stop = true;
+                        path_version++;
+                        ROS_INFO("Reordered the remaining lanes, %.2f m of transit.", transit);
+                        points_instance.rvizPoints(markers, path.flatten(), marker_frame, marker_ns);
+                        if (mission_saved)
+                        {
+                            mission.savePath(path);
+                        }
                     }
-                    //publish new path points to rviz.
-                    points_instance.rvizPoints(points_pub, vec);
+                    route_changed = false;
+                }
+            }
+
+            //plan the lanes after this one while it is driven.
+            if (lane_planner.running())
+            {
+                size_t next = nextLaneStart(path, s);
+                if (next < path.size())
+                {
+                    lane_planner.request(path, path_version, next, route_changed && reorder_budget > 0);
+                }
+            }
+            uint64_t plan_start = Latency_trace::now();
+
+            //go around the obstacle if it is on the rest of the span. the spans far from it are not searched.
+            Obstacle_Point obstacle = {obstacle_odom.x, obstacle_odom.y};
+            int detour = path.detour(s, offset, obstacle, path_radius);
+            if (detour >= 0)
+            {
+                Trace_context::hop(hop_detour, obstacle_trace);
+                detour_trace = obstacle_trace;
+                path_version++;
+                //publish new path points to rviz.
+                points_instance.rvizPoints(markers, path.flatten(), marker_frame, marker_ns);
+                if (mission_saved)
+                {
+                    mission.savePath(path);
+                }
+                route_changed = true;
+                //the point the robot drives to is on the detour, which is the next span now.
+                if (detour == offset && offset > 0)
+                {
+                    s++;
+                    offset = 0;
                 }
-                //increment other counter
-                count2++;
             }
-            //count untill the next stop point.
-            while (!vec[temp].stop)
+            const Path_plan::Span &span = path.span(s);
+            Point p = path.point(span.begin + offset);
+            Latency_trace::record(stage_plan, plan_start, Latency_trace::now() - plan_start);
+
+            startup.moved();
+            //the robot turns at both ends of a span.
+            if (offset == 0 || span.begin + offset == span.end - 1)
             {
-                temp++;
+                rotate(p);
             }
+
             //move to the goal, using the next point p, as angular vel,
-            //and temp, as the linear vel guide.
-            move2goal(p, vec[temp]);
+            //and the stop of the span, as the linear vel guide.
+            move2goal(p, path.stop(s));
+
+            bool span_done = span.begin + ++offset == span.end;
+            if (span_done)
+            {
+                s++;
+                offset = 0;
+            }
+            if (mission_saved)
+            {
+                saveCheckpoint(s, offset);
+                if (span_done)
+                {
+                    mission.sync();
+                }
+            }
+        }
+        reportCoverage();
+        if (mission_saved)
+        {
+            mission.finish();
         }
         std::cout << "Done";
     }
-    //else throw connection error.
+    //else the node was shut down before the start.
     else
     {
-        ROS_ERROR("Could not connect to turtlebot...");
+        ROS_ERROR("Shut down before the mission started.");
     }
 
+    startup.stop();
+    lane_planner.stop();
+    markers.stop();
+    mission_log.close();
     return 0;
 }
 
@@ -383,6 +793,7 @@ void rotate(Point goal)
 {
     geometry_msgs::Twist vel_msg;
 
+    updatePose();
     double desired_angle = getTheta(getAngle(goal));
 
     // Sets all the velocities equal to zero, except angular.z.
@@ -394,6 +805,7 @@ void rotate(Point goal)
     vel_msg.angular.y = 0;
 
     ros::spinOnce();
+    updatePose();
 
     // Rotates either clockwise (if=true) or counterclockwise (if=false) depending on which is shortest.
 
@@ -401,6 +813,7 @@ void rotate(Point goal)
     // Rotates until turtle has rotated to desired angle (within 0.02 radians).
     do
     {
+        uint64_t iteration_start = Latency_trace::now();
         if (IsClockwise(getTheta(cur_pose.theta), desired_angle))
         {
             vel_msg.angular.z = -fabs(angular_velocity(goal));
@@ -410,14 +823,16 @@ void rotate(Point goal)
             vel_msg.angular.z = fabs(angular_velocity(goal));
         }
         //publish velocity
-        vel_pub.publish(vel_msg);
+        publishVelocity(vel_msg);
         ros::spinOnce();
+        Latency_trace::record(stage_rotate, iteration_start, Latency_trace::now() - iteration_start);
         loop_rate.sleep();
+        updatePose();
     } while (fabs(desired_angle - getTheta(cur_pose.theta)) > 0.05 && ros::ok());
 
     // Stops the turtle from rotating.
     vel_msg.angular.z = 0;
-    vel_pub.publish(vel_msg);
+    publishVelocity(vel_msg);
 }
 
 #pragma region Shortest rotation
@@ -494,14 +909,27 @@ double getAngle(Point goal)
 }
 
 // The function makes the turtle move to the given goal.
+//publish a velocity command. the first one after a detour ends the chain of the scan that caused it.
+void publishVelocity(const geometry_msgs::Twist &vel_msg)
+{
+    vel_pub.publish(vel_msg);
+    if (!detour_trace.source.empty())
+    {
+        Trace_context::hop(hop_velocity, detour_trace);
+        detour_trace.source.clear();
+    }
+}
+
 void move2goal(Point goal, Point stop_goal)
 {
 
     geometry_msgs::Twist vel_msg;
     ros::Rate loop_rate = (100);
 
+    updatePose();
     while (euclidean_distance(cur_pose.x, cur_pose.y, goal.x, goal.y) > distance_tolerance && ros::ok())
     {
+        uint64_t iteration_start = Latency_trace::now();
         // std::cout << "x: " << cur_pose.x << std::endl << "y: " << cur_pose.y << std::endl << "theta: " << cur_pose.theta << std::endl;
 
         // Sets the linear velocity in the direction of the x-axis to a decreasing speed (look at linear_velocity function) depending on where the goal is.
@@ -514,14 +942,16 @@ void move2goal(Point goal, Point stop_goal)
         vel_msg.angular.y = 0;
         vel_msg.angular.z = angular_velocity(goal);
 
-        vel_pub.publish(vel_msg);
+        publishVelocity(vel_msg);
+        Latency_trace::record(stage_move, iteration_start, Latency_trace::now() - iteration_start);
 
         loop_rate.sleep();
         ros::spinOnce();
+        updatePose();
     }
 
     // Sets the velocity (in all directions and rotations) to zero.
     vel_msg.linear.x = 0;
     vel_msg.angular.z = 0;
-    vel_pub.publish(vel_msg);
+    publishVelocity(vel_msg);
 }
@@ -0,0 +1,250 @@
+#include "path_plan.h"
+#include <algorithm>
+#include "lane_order.h"
+
+using namespace Path_plan;
+using Points_gen::Point;
+
+lane_Path::lane_Path(const std::vector<Point> &path)
+{
+    points.reserve(path.size());
+    appendSpans(path, spans);
+}
+
+void lane_Path::appendSpans(const std::vector<Point> &path, std::vector<Span> &out)
+{
+    int base = points.size();
+    points.insert(points.end(), path.begin(), path.end());
+    int begin = base;
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        //a span never crosses into the next lane.
+        if (path[i].stop || i + 1 == path.size() || path[i + 1].lane != path[i].lane)
+        {
+            out.push_back(makeSpan(begin, base + i + 1));
+            begin = base + i + 1;
+        }
+    }
+}
+
+Span lane_Path::makeSpan(int begin, int end) const
+{
+    Span span = {begin, end, points[begin].lane, points[begin].x, points[begin].y, points[begin].x, points[begin].y};
+    for (int i = begin + 1; i < end; i++)
+    {
+        span.minX = std::min(span.minX, points[i].x);
+        span.minY = std::min(span.minY, points[i].y);
+        span.maxX = std::max(span.maxX, points[i].x);
+        span.maxY = std::max(span.maxY, points[i].y);
+    }
+    return span;
+}
+
+void lane_Path::dropUnused()
+{
+    size_t used = 0;
+    for (size_t s = 0; s < spans.size(); s++)
+    {
+        used += spans[s].end - spans[s].begin;
+    }
+    if (points.size() <= 2 * used)
+    {
+        return;
+    }
+    std::vector<Point> kept;
+    std::vector<Span> moved;
+    compact(kept, moved);
+    points.swap(kept);
+    spans.swap(moved);
+}
+
+bool lane_Path::spanNear(size_t s, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius) const
+{
+    const Span &span = spans[s];
+    return obstacle.x + radius > span.minX && obstacle.x - radius < span.maxX &&
+           obstacle.y + radius > span.minY && obstacle.y - radius < span.maxY;
+}
+
+int lane_Path::detour(size_t s, int offset, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius)
+{
+    if (!spanNear(s, obstacle, radius))
+    {
+        return -1;
+    }
+    const Span span = spans[s];
+
+    //the first run of points in the obstacle, not counting the stop.
+    int stop = span.end - 1;
+    int first = span.begin + offset;
+    while (first < stop && !Obstacle_avoidance::isInObstacle(points[first], obstacle, radius))
+    {
+        first++;
+    }
+    if (first >= stop)
+    {
+        return -1;
+    }
+    std::vector<Point> detour;
+    int after = first;
+    while (after < stop && Obstacle_avoidance::isInObstacle(points[after], obstacle, radius))
+    {
+        detour.push_back(Obstacle_avoidance::offsetPointInObstacle(points[after], radius, obstacle));
+        after++;
+    }
+    //the detour ends at the first point after the obstacle.
+    detour.push_back(points[after]);
+
+    std::vector<Span> split;
+    if (first > span.begin)
+    {
+        split.push_back(makeSpan(span.begin, first));
+    }
+    int detour_begin = points.size();
+    points.insert(points.end(), detour.begin(), detour.end());
+    split.push_back(makeSpan(detour_begin, points.size()));
+    if (after + 1 < span.end)
+    {
+        split.push_back(makeSpan(after + 1, span.end));
+    }
+
+    spans.erase(spans.begin() + s);
+    spans.insert(spans.begin() + s, split.begin(), split.end());
+    dropUnused();
+    return first - span.begin;
+}
+
+int lane_Path::detourLanes(size_t s, int lanes, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius)
+{
+    int detours = 0;
+    for (size_t k = s; k < spans.size(); k++)
+    {
+        if (k > s && spans[k].lane != spans[k - 1].lane && --lanes <= 0)
+        {
+            break;
+        }
+        int first = detour(k, 0, obstacle, radius);
+        if (first >= 0)
+        {
+            //continue after the detour, its points are on the edge of the obstacle already.
+            detours++;
+            k += first > 0 ? 1 : 0;
+        }
+    }
+    return detours;
+}
+
+bool lane_Path::nearLanes(size_t s, int lanes, const Obstacle_avoidance::Obstacle_Point &obstacle, double radius) const
+{
+    for (size_t k = s; k < spans.size(); k++)
+    {
+        if (k > s && spans[k].lane != spans[k - 1].lane && --lanes <= 0)
+        {
+            break;
+        }
+        if (spanNear(k, obstacle, radius))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool lane_Path::reorderLanes(size_t s, double x, double y, double timeBudget, double &transit)
+{
+    //the spans of each lane, and the ends of the lane.
+    std::vector<size_t> lane_begin;
+    std::vector<Lane_order::Segment> segments;
+    for (size_t k = s; k < spans.size(); k++)
+    {
+        if (k == s || spans[k].lane != spans[k - 1].lane)
+        {
+            lane_begin.push_back(k);
+            const Point &start = points[spans[k].begin];
+            Lane_order::Segment segment = {start.x, start.y, start.x, start.y};
+            segments.push_back(segment);
+        }
+        segments.back().endX = stop(k).x;
+        segments.back().endY = stop(k).y;
+    }
+    lane_begin.push_back(spans.size());
+
+    //the lanes as they are, kept unless the new order has strictly shorter transits.
+    Lane_order::Route current;
+    for (size_t k = 0; k < segments.size(); k++)
+    {
+        current.order.push_back(k);
+        current.reversed.push_back(false);
+    }
+    transit = Lane_order::transitLength(x, y, segments, current);
+
+    Lane_order::Route route = Lane_order::planRoute(x, y, segments, timeBudget);
+    if (route.transit >= transit - 1e-9)
+    {
+        return false;
+    }
+    transit = route.transit;
+
+    std::vector<Span> reordered(spans.begin(), spans.begin() + s);
+    for (size_t k = 0; k < route.order.size(); k++)
+    {
+        int lane = route.order[k];
+        if (!route.reversed[k])
+        {
+            reordered.insert(reordered.end(), spans.begin() + lane_begin[lane], spans.begin() + lane_begin[lane + 1]);
+            continue;
+        }
+
+        //a reversed lane stops at the same points, so it is split again after each of them in the new direction.
+        std::vector<Point> reversed;
+        for (size_t l = lane_begin[lane + 1]; l-- > lane_begin[lane];)
+        {
+            for (int i = spans[l].end - 1; i >= spans[l].begin; i--)
+            {
+                reversed.push_back(points[i]);
+                reversed.back().stop = i == spans[l].end - 1;
+            }
+        }
+        reversed.front().stop = true;
+        reversed.back().stop = true;
+        appendSpans(reversed, reordered);
+    }
+    spans.swap(reordered);
+    dropUnused();
+    return true;
+}
+
+std::vector<Point> lane_Path::flatten(size_t s) const
+{
+    std::vector<Point> path;
+    for (; s < spans.size(); s++)
+    {
+        for (int i = spans[s].begin; i < spans[s].end; i++)
+        {
+            path.push_back(points[i]);
+            path.back().stop = i == spans[s].end - 1;
+        }
+    }
+    return path;
+}
+
+void lane_Path::replaceFrom(size_t s, const std::vector<Point> &path)
+{
+    //the stops of a flattened path end the same spans again.
+    spans.erase(spans.begin() + s, spans.end());
+    appendSpans(path, spans);
+    dropUnused();
+}
+
+void lane_Path::compact(std::vector<Point> &points, std::vector<Span> &spans) const
+{
+    points.clear();
+    spans.clear();
+    for (size_t s = 0; s < this->spans.size(); s++)
+    {
+        Span span = this->spans[s];
+        points.insert(points.end(), this->points.begin() + span.begin, this->points.begin() + span.end);
+        span.end = points.size();
+        span.begin = span.end - (this->spans[s].end - this->spans[s].begin);
+        spans.push_back(span);
+    }
+}
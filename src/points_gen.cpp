@@ -2,19 +2,56 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include <visualization_msgs/Marker.h>
 
 using namespace Points_gen;
 
-std::vector<Point> points_List::gen_Point_list()
+double Points_gen::laneSpacing(const std::vector<Camera_model::Camera> &cameras, double overlap, double fallback)
+{
+    double left;
+    double right;
+    if (!Camera_model::lateralSwath(cameras, left, right))
+    {
+        return fallback;
+    }
+    //at least a tenth of the strip is new on every lane.
+    overlap = std::max(0.0, std::min(overlap, 0.9));
+    return 2 * std::min(left, right) * (1 - overlap);
+}
+
+int Points_gen::laneCount(const std::vector<Point> &points)
+{
+    int lanes = 0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        if (i == 0 || points[i].lane != points[i - 1].lane)
+        {
+            lanes++;
+        }
+    }
+    return lanes;
+}
+
+double Points_gen::pathLength(const std::vector<Point> &points)
+{
+    double length = 0;
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        length += std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y);
+    }
+    return length;
+}
+
+std::vector<Point> points_List::gen_Point_list(double length, double width, double laneSpacing)
 {
     //create a new vector of points.
     std::vector<Point> vec;
 
     //m is length
     //n is width
-    double x = 3.0; //m
-    double y = 2.9; //n
+    double x = length; //m
+    double y = width;  //n
     //Distance between points
     double point_distance = 0.1;
     //robot radius in meters
@@ -22,9 +59,11 @@ std::vector<Point> points_List::gen_Point_list()
     //count used to generate the points in the correct order.
     int count = 0;
 
-    //iterate through the length of the field.
-    for (double i = robot_radius; i < x; i += 2 * robot_radius)
+    //iterate through the length of the field until the cameras have seen all of it.
+    for (double lane_x = laneSpacing / 2; lane_x - laneSpacing / 2 < x; lane_x += laneSpacing)
     {
+        //the last lane is moved back into the field, the lane before it still meets its strip.
+        double i = std::min(lane_x, x - laneSpacing / 2);
         //check if the iteration is even.
         if (count % 2 == 0)
         {
@@ -32,7 +71,7 @@ std::vector<Point> points_List::gen_Point_list()
             for (double j = robot_radius; j < y - robot_radius; j += point_distance)
             {
                 //create a point.
-                Point p = {i, j};
+                Point p = {i, j, false, count};
                 //if the first point in iteration, set stop to true.
                 if (j == robot_radius)
                 {
@@ -48,7 +87,7 @@ std::vector<Point> points_List::gen_Point_list()
             for (double j = y - robot_radius; j > 0 + robot_radius; j -= point_distance)
             {
                 //create a point.
-                Point p = {i, j};
+                Point p = {i, j, false, count};
                 //if the first point in iteration, set stop to true.
                 if (j == y - robot_radius)
                 {
@@ -68,15 +107,15 @@ std::vector<Point> points_List::gen_Point_list()
     return vec;
 }
 
-void points_List::rvizPoints(ros::Publisher point_pub, std::vector<Point> point_list)
+void points_List::rvizPoints(Marker_sidecar::marker_Sidecar &markers, const std::vector<Point> &point_list, const std::string &frame_id, const std::string &ns)
 {
     visualization_msgs::Marker points, line_strip;
 
     //Initializing the points and line_strip object data.
     //The default marker message members are 0.
     //frame id has to be the same as the robots position topic.
-    points.header.frame_id = line_strip.header.frame_id = "/odom";
-    points.ns = line_strip.ns = "Path namespace";
+    points.header.frame_id = line_strip.header.frame_id = frame_id;
+    points.ns = line_strip.ns = ns;
     points.action = line_strip.action = visualization_msgs::Marker::ADD;
 
     //w must be a non-zero value to be displayed.
@@ -109,6 +148,10 @@ void points_List::rvizPoints(ros::Publisher point_pub, std::vector<Point> point_
     points.lifetime = ros::Duration();
     line_strip.lifetime = ros::Duration();
 
+    points.colors.reserve(point_list.size());
+    points.points.reserve(point_list.size());
+    line_strip.points.reserve(point_list.size());
+
     //iterate through points_list
     for (size_t i = 0; i < point_list.size(); ++i)
     {
@@ -145,12 +188,9 @@ void points_List::rvizPoints(ros::Publisher point_pub, std::vector<Point> point_
 
         //append the linestrip.
         line_strip.points.push_back(point);
-
-        //publish
-        point_pub.publish(points);
-        point_pub.publish(line_strip);
     }
-    //process callbacks.
-    ros::spinOnce();
-    ROS_INFO("Done publishing rviz points.");
+
+    //the sidecar publishes the whole path once, whenever rviz is connected.
+    markers.update(points);
+    markers.update(line_strip);
 }
@@ -0,0 +1,162 @@
+#include "pose_history.h"
+#include <cmath>
+
+using namespace Pose_history;
+
+//wrap an angle into the interval -pi < angle <= pi.
+static double normalizeAngle(double angle)
+{
+    return std::atan2(std::sin(angle), std::cos(angle));
+}
+
+Stamped_pose Pose_history::interpolate(const Stamped_pose &a, const Stamped_pose &b, double stamp)
+{
+    double dt = b.stamp - a.stamp;
+    if (dt <= 0)
+    {
+        return b;
+    }
+    double t = (stamp - a.stamp) / dt;
+
+    //motion from a to b expressed in the frame of a.
+    double c = std::cos(a.theta);
+    double s = std::sin(a.theta);
+    double dx = c * (b.x - a.x) + s * (b.y - a.y);
+    double dy = -s * (b.x - a.x) + c * (b.y - a.y);
+    double dtheta = normalizeAngle(b.theta - a.theta);
+
+    //logarithm of the relative motion gives the twist (vx, vy, w) that moves a to b in unit time.
+    double vx = dx;
+    double vy = dy;
+    if (std::fabs(dtheta) > 1e-9)
+    {
+        double half = dtheta / 2;
+        double cot = half / std::tan(half);
+        vx = cot * dx + half * dy;
+        vy = -half * dx + cot * dy;
+    }
+
+    //exponential of the scaled twist gives the relative motion after the fraction t.
+    double w = t * dtheta;
+    double px = t * vx;
+    double py = t * vy;
+    if (std::fabs(w) > 1e-9)
+    {
+        double sw = std::sin(w) / w;
+        double cw = (1 - std::cos(w)) / w;
+        double qx = sw * px - cw * py;
+        double qy = cw * px + sw * py;
+        px = qx;
+        py = qy;
+    }
+
+    //transform back to the odometry frame.
+    Stamped_pose pose;
+    pose.stamp = stamp;
+    pose.x = a.x + c * px - s * py;
+    pose.y = a.y + s * px + c * py;
+    pose.theta = normalizeAngle(a.theta + w);
+    return pose;
+}
+
+pose_Buffer::pose_Buffer(size_t capacity)
+    : capacity(capacity), slots(new Slot[capacity]), head(0)
+{
+    for (size_t i = 0; i < capacity; i++)
+    {
+        slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+}
+
+void pose_Buffer::push(const Stamped_pose &pose)
+{
+    uint64_t index = head.load(std::memory_order_relaxed);
+    Slot &slot = slots[index % capacity];
+
+    //odd sequence marks the slot as being written.
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.stamp.store(pose.stamp, std::memory_order_relaxed);
+    slot.x.store(pose.x, std::memory_order_relaxed);
+    slot.y.store(pose.y, std::memory_order_relaxed);
+    slot.theta.store(pose.theta, std::memory_order_relaxed);
+
+    //even sequence marks the slot as holding the pose with this index.
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    head.store(index + 1, std::memory_order_release);
+}
+
+bool pose_Buffer::read(uint64_t index, Stamped_pose &pose) const
+{
+    const Slot &slot = slots[index % capacity];
+    uint64_t expected = 2 * index + 2;
+
+    if (slot.seq.load(std::memory_order_acquire) != expected)
+    {
+        return false;
+    }
+    pose.stamp = slot.stamp.load(std::memory_order_relaxed);
+    pose.x = slot.x.load(std::memory_order_relaxed);
+    pose.y = slot.y.load(std::memory_order_relaxed);
+    pose.theta = slot.theta.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return slot.seq.load(std::memory_order_relaxed) == expected;
+}
+
+bool pose_Buffer::latest(Stamped_pose &pose) const
+{
+    //retry if the writer wrapped around onto the newest slot while it was read.
+    while (true)
+    {
+        uint64_t count = head.load(std::memory_order_acquire);
+        if (count == 0)
+        {
+            return false;
+        }
+        if (read(count - 1, pose))
+        {
+            return true;
+        }
+    }
+}
+
+bool pose_Buffer::lookup(double stamp, Stamped_pose &pose) const
+{
+    uint64_t count = head.load(std::memory_order_acquire);
+    if (count == 0)
+    {
+        return false;
+    }
+
+    Stamped_pose newer;
+    if (!read(count - 1, newer))
+    {
+        return false;
+    }
+    if (stamp >= newer.stamp)
+    {
+        pose = newer;
+        return true;
+    }
+
+    //walk back from the newest pose, sensor delays are short so only a few steps are needed.
+    uint64_t oldest = count > capacity ? count - capacity : 0;
+    for (uint64_t i = count - 1; i > oldest; i--)
+    {
+        Stamped_pose older;
+        if (!read(i - 1, older))
+        {
+            //the writer has wrapped around and reused the slot.
+            return false;
+        }
+        if (older.stamp <= stamp)
+        {
+            pose = interpolate(older, newer, stamp);
+            return true;
+        }
+        newer = older;
+    }
+    return false;
+}
@@ -0,0 +1,28 @@
+#include "quaternion.h"
+#include <cmath>
+
+EulerAngles ToEulerAngles(Quaternion q)
+{
+    EulerAngles angles;
+
+    //roll (x axis rotation)
+    double sinr_cosp = 2 * (q.w * q.x - q.y * q.z);
+    double cosr_cosp = 1 - 2 * (q.x * q.x + q.y * q.y);
+    angles.roll = atan2(sinr_cosp, cosr_cosp);
+
+    //pitch (y axis rotation)
+    double sinp = 2 * (q.w * q.y - q.z * q.x);
+    if (std::fabs(sinp) >= 1)
+        //copysign returns the magnitude of M_PI/2 with the sign of sinp
+        angles.pitch = copysign(M_PI / 2, sinp); // use 90 degrees if out of range
+    else
+        angles.pitch = asin(sinp);
+
+    // yaw (z-axis rotation)
+    double siny_cosp = 2 * (q.w * q.z + q.x * q.y);
+    double cosy_cosp = 1 - 2 * (q.y * q.y + q.z * q.z);
+    //calculate yaw, and make the yaw angle be 0 < yaw < 2pi.
+    angles.yaw = std::atan2(siny_cosp, cosy_cosp);
+
+    return angles;
+}
@@ -0,0 +1,168 @@
+#include "startup_sequence.h"
+#include <chrono>
+#include <cmath>
+#include <std_msgs/Empty.h>
+#include <geometry_msgs/Twist.h>
+#include <latency_trace.h>
+
+using namespace Startup_sequence;
+
+namespace
+{
+    const int stage_start = Latency_trace::stage("start_to_motion");
+
+    const char *waitingFor(Stage stage)
+    {
+        switch (stage)
+        {
+        case STAGE_WAIT_BASE:
+            return "Waiting for the mobile base to connect...";
+        case STAGE_WAIT_ODOMETRY:
+            return "Waiting for the odometry after the reset...";
+        default:
+            return "Ready, call start_mission to start the mission.";
+        }
+    }
+} // namespace
+
+void startup_Sequence::start(ros::NodeHandle &n, bool reset, bool autoStart)
+{
+    //the odometry thread may be running already.
+    std::lock_guard<std::mutex> lock(mutex);
+    node_start = Latency_trace::now();
+    this->reset = reset;
+    start_requested = autoStart;
+    start_time = node_start;
+    odometry_after = reset ? INFINITY : -INFINITY;
+
+    //the connection callbacks and the service run on the queue of the sequence, even while the main thread is busy.
+    ros::NodeHandle startup_node(n);
+    startup_node.setCallbackQueue(&queue);
+    ros::SubscriberStatusCallback connect = [this](const ros::SingleSubscriberPublisher &subscriber) { connected(subscriber); };
+    reset_pub = startup_node.advertise<std_msgs::Empty>("mobile_base/commands/reset_odometry", 10, connect);
+    velocity_pub = startup_node.advertise<geometry_msgs::Twist>("cmd_vel_mux/input/navi", 10, connect);
+    start_service = startup_node.advertiseService("start_mission", &startup_Sequence::startService, this);
+    spinner.reset(new ros::AsyncSpinner(1, &queue));
+    spinner->start();
+
+    //the base may have connected before the callbacks were set.
+    advance();
+}
+
+void startup_Sequence::stop()
+{
+    if (spinner)
+    {
+        spinner->stop();
+        spinner.reset();
+    }
+    start_service.shutdown();
+}
+
+void startup_Sequence::connected(const ros::SingleSubscriberPublisher &subscriber)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    advance();
+}
+
+void startup_Sequence::odometry(double stamp)
+{
+    if (stage() >= STAGE_READY)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!odometry_seen && stamp >= odometry_after)
+    {
+        odometry_seen = true;
+        advance();
+    }
+}
+
+bool startup_Sequence::startService(std_srvs::Trigger::Request &request, std_srvs::Trigger::Response &response)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (current == STAGE_STARTED)
+    {
+        response.success = false;
+        response.message = "The mission is running already.";
+        return true;
+    }
+    if (!start_requested)
+    {
+        start_requested = true;
+        start_time = Latency_trace::now();
+    }
+    advance();
+    response.success = true;
+    response.message = current == STAGE_STARTED ? "Starting the mission." : "The mission starts when the base is ready.";
+    return true;
+}
+
+void startup_Sequence::advance()
+{
+    Stage stage = current;
+    double elapsed = (Latency_trace::now() - node_start) * 1e-9;
+    if (stage == STAGE_WAIT_BASE && velocity_pub.getNumSubscribers() > 0 && (!reset || reset_pub.getNumSubscribers() > 0))
+    {
+        if (reset)
+        {
+            std_msgs::Empty e;
+            reset_pub.publish(e);
+            odometry_after = ros::Time::now().toSec();
+            ROS_INFO("Reset the odometry %.3f s after the start of the node.", elapsed);
+        }
+        stage = STAGE_WAIT_ODOMETRY;
+    }
+    if (stage == STAGE_WAIT_ODOMETRY && odometry_seen)
+    {
+        ROS_INFO("The base is ready %.3f s after the start of the node.", elapsed);
+        stage = STAGE_READY;
+    }
+    if (stage == STAGE_READY && start_requested)
+    {
+        stage = STAGE_STARTED;
+    }
+    if (stage != current)
+    {
+        current.store(stage, std::memory_order_release);
+        changed.notify_all();
+    }
+}
+
+bool startup_Sequence::waitForStart()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (current != STAGE_STARTED)
+    {
+        if (!ros::ok())
+        {
+            return false;
+        }
+        ROS_INFO_THROTTLE(5, "%s", waitingFor(current));
+        changed.wait_for(lock, std::chrono::milliseconds(100));
+
+        //the fleet state and the obstacles are handled while waiting, without spinning.
+        lock.unlock();
+        ros::getGlobalCallbackQueue()->callAvailable();
+        lock.lock();
+    }
+    return true;
+}
+
+void startup_Sequence::moved()
+{
+    if (has_moved)
+    {
+        return;
+    }
+    has_moved = true;
+    uint64_t now = Latency_trace::now();
+    uint64_t requested;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requested = start_time;
+    }
+    Latency_trace::record(stage_start, requested, now - requested);
+    ROS_INFO("First motion %.3f s after the start, %.3f s after the start of the node.", (now - requested) * 1e-9, (now - node_start) * 1e-9);
+}
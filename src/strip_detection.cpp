@@ -0,0 +1,203 @@
+#include "strip_detection.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Strip_detection;
+
+strip_Detector::strip_Detector(const Camera_model::Camera &camera, const Strip_config &config)
+    : camera(camera), config(config), primed(false), framesSinceRefresh(0)
+{
+}
+
+bool strip_Detector::process(const cv::Mat &frame, const Paper_vision::Hsv_range &range, const turtlesim::Pose &pose,
+                             Thread_pool::thread_Pool *pool, int bands, cv::Mat &mask, std::vector<cv::Rect> &boundbox)
+{
+    int dx = 0;
+    int dy = 0;
+    bool full = !primed || memcmp(&range, &lastRange, sizeof(range)) != 0 || ++framesSinceRefresh >= config.refreshFrames ||
+                frame.rows != lastMask.rows || frame.cols != lastMask.cols || !predictShift(pose, frame.rows, frame.cols, dx, dy);
+
+    if (full)
+    {
+        processFull(frame, range, pool, bands, mask);
+        framesSinceRefresh = 0;
+    }
+    else
+    {
+        processStrips(frame, range, dx, dy, mask);
+    }
+
+    primed = true;
+    lastPose = pose;
+    lastRange = range;
+    lastMask = mask;
+
+    //the same top to bottom order whichever way the blobs were found.
+    std::sort(blobs.begin(), blobs.end(), [](const Blob_runs::Blob &a, const Blob_runs::Blob &b) {
+        return a.minY != b.minY ? a.minY < b.minY : a.minX < b.minX;
+    });
+    Paper_vision::blobBoxes(blobs, boundbox);
+    return full;
+}
+
+bool strip_Detector::predictShift(const turtlesim::Pose &pose, int rows, int cols, int &dx, int &dy) const
+{
+    //where the ground seen at the center and the corners now was in the last frame.
+    double pixels[5][2] = {{cols / 2.0, rows / 2.0}, {0, 0}, {double(cols), 0}, {0, double(rows)}, {double(cols), double(rows)}};
+    double motionX = 0;
+    double motionY = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        Camera_model::point pixel;
+        pixel.x = pixels[i][0];
+        pixel.y = pixels[i][1];
+        Camera_model::point before = Camera_model::pixelOfPoint(Camera_model::convertCoordinatesOfPoint(pixel, pose, camera), lastPose, camera);
+
+        if (i == 0)
+        {
+            motionX = before.x - pixel.x;
+            motionY = before.y - pixel.y;
+        }
+        else if (std::hypot(before.x - pixel.x - motionX, before.y - pixel.y - motionY) > config.maxError)
+        {
+            return false;
+        }
+    }
+
+    dx = int(std::lround(motionX));
+    dy = int(std::lround(motionY));
+    //with more than half the frame new, processing it all is as cheap.
+    return 2 * std::abs(dx) < cols && 2 * std::abs(dy) < rows;
+}
+
+void strip_Detector::processFull(const cv::Mat &frame, const Paper_vision::Hsv_range &range, Thread_pool::thread_Pool *pool, int bands, cv::Mat &mask)
+{
+    blobs.clear();
+    if (pool)
+    {
+        Paper_vision::processBands(frame, range, *pool, bands, mask, blobs);
+    }
+    else
+    {
+        Paper_vision::thresholdFrame(frame, range, mask);
+        Paper_vision::filterMask(mask);
+        Paper_vision::labelRows(mask, 0, mask.rows, blobs);
+    }
+}
+
+void strip_Detector::processStrips(const cv::Mat &frame, const Paper_vision::Hsv_range &range, int dx, int dy, cv::Mat &mask)
+{
+    int rows = frame.rows;
+    int cols = frame.cols;
+    shiftMask(lastMask, dx, dy, mask);
+
+    //the newly exposed strips. the filter result of the old pixels within its reach of the strip depends on the new
+    //pixels, and the pixels that moved to the opposite border now see the border, so both are processed again.
+    int reach = Paper_vision::bandHalo;
+    std::vector<cv::Rect> regions;
+    if (dy != 0)
+    {
+        int strip = std::min(rows, std::abs(dy) + reach);
+        int opposite = std::min(rows - strip, reach);
+        regions.push_back(dy > 0 ? cv::Rect(0, rows - strip, cols, strip) : cv::Rect(0, 0, cols, strip));
+        regions.push_back(dy > 0 ? cv::Rect(0, 0, cols, opposite) : cv::Rect(0, rows - opposite, cols, opposite));
+    }
+    if (dx != 0)
+    {
+        int strip = std::min(cols, std::abs(dx) + reach);
+        int opposite = std::min(cols - strip, reach);
+        regions.push_back(dx > 0 ? cv::Rect(cols - strip, 0, strip, rows) : cv::Rect(0, 0, strip, rows));
+        regions.push_back(dx > 0 ? cv::Rect(0, 0, opposite, rows) : cv::Rect(cols - opposite, 0, opposite, rows));
+    }
+
+    //row intervals [first, second) that have to be labelled again.
+    std::vector<std::pair<int, int>> dirty;
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        if (regions[i].width > 0 && regions[i].height > 0)
+        {
+            Paper_vision::processRegion(frame, range, regions[i], mask);
+            dirty.push_back(std::make_pair(regions[i].y, regions[i].y + regions[i].height));
+        }
+    }
+
+    //move the blobs of the last frame along, cut to the frame.
+    std::vector<Blob_runs::Blob> moved;
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        Blob_runs::Blob blob = blobs[i];
+        blob.minX = std::max(0, blob.minX - dx);
+        blob.maxX = std::min(cols - 1, blob.maxX - dx);
+        blob.minY = std::max(0, blob.minY - dy);
+        blob.maxY = std::min(rows - 1, blob.maxY - dy);
+        if (blob.minX <= blob.maxX && blob.minY <= blob.maxY)
+        {
+            moved.push_back(blob);
+        }
+    }
+
+    //blobs touching a dirty interval may have grown into it or joined others, their rows are labelled again too.
+    //grow the intervals until no kept blob touches one.
+    std::vector<bool> absorbed(moved.size(), false);
+    bool grown = true;
+    while (grown)
+    {
+        grown = false;
+        std::sort(dirty.begin(), dirty.end());
+        std::vector<std::pair<int, int>> merged;
+        for (size_t i = 0; i < dirty.size(); i++)
+        {
+            if (!merged.empty() && dirty[i].first <= merged.back().second)
+            {
+                merged.back().second = std::max(merged.back().second, dirty[i].second);
+            }
+            else
+            {
+                merged.push_back(dirty[i]);
+            }
+        }
+        dirty.swap(merged);
+
+        for (size_t i = 0; i < moved.size(); i++)
+        {
+            for (size_t j = 0; j < dirty.size() && !absorbed[i]; j++)
+            {
+                if (moved[i].maxY >= dirty[j].first - 1 && moved[i].minY <= dirty[j].second)
+                {
+                    absorbed[i] = true;
+                    dirty.push_back(std::make_pair(moved[i].minY, moved[i].maxY + 1));
+                    grown = true;
+                }
+            }
+        }
+    }
+
+    blobs.clear();
+    for (size_t i = 0; i < moved.size(); i++)
+    {
+        if (!absorbed[i])
+        {
+            blobs.push_back(moved[i]);
+        }
+    }
+    for (size_t i = 0; i < dirty.size(); i++)
+    {
+        Paper_vision::labelRows(mask, dirty[i].first, dirty[i].second, blobs);
+    }
+}
+
+void Strip_detection::shiftMask(const cv::Mat &previous, int dx, int dy, cv::Mat &mask)
+{
+    mask = cv::Mat::zeros(previous.rows, previous.cols, CV_8UC1);
+    int width = previous.cols - std::abs(dx);
+    int height = previous.rows - std::abs(dy);
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    cv::Mat destination = mask(cv::Rect(std::max(0, -dx), std::max(0, -dy), width, height));
+    previous(cv::Rect(std::max(0, dx), std::max(0, dy), width, height)).copyTo(destination);
+}
@@ -0,0 +1,138 @@
+#include "thread_pool.h"
+
+using namespace Thread_pool;
+
+thread_Pool::thread_Pool(unsigned threads)
+    : next_queue(0), queued(0), stopping(false)
+{
+    if (threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0)
+    {
+        threads = 1;
+    }
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (unsigned i = 1; i < threads; i++)
+    {
+        workers.push_back(std::thread(&thread_Pool::workerLoop, this, i));
+    }
+}
+
+thread_Pool::~thread_Pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+void thread_Pool::parallelFor(int count, const std::function<void(int)> &body)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    Job job;
+    job.body = &body;
+    job.remaining = count;
+
+    //spread the tasks over the queues, starting at a different queue every call.
+    unsigned first = next_queue.fetch_add(1);
+    for (int i = 0; i < count; i++)
+    {
+        Queue &queue = *queues[(first + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{&job, i});
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        queued.fetch_add(count);
+    }
+    wake.notify_all();
+
+    //help until no tasks are left, then wait for the workers to finish theirs.
+    Task task;
+    while (takeTask(0, task))
+    {
+        runTask(task);
+    }
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.done.wait(lock, [&job] { return job.remaining == 0; });
+}
+
+bool thread_Pool::takeTask(unsigned self, Task &task)
+{
+    //newest task from the own queue first, it is the most likely to be in cache.
+    {
+        Queue &queue = *queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    //steal the oldest task from the other queues.
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        Queue &queue = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void thread_Pool::runTask(const Task &task)
+{
+    Job *job = task.job;
+    (*job->body)(task.index);
+
+    //the last task wakes the thread waiting for the job.
+    //this is done under the lock, so the job is not destroyed before the worker is done with it.
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->remaining--;
+    if (job->remaining == 0)
+    {
+        job->done.notify_all();
+    }
+}
+
+void thread_Pool::workerLoop(unsigned self)
+{
+    while (true)
+    {
+        Task task;
+        if (takeTask(self, task))
+        {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
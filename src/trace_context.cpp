@@ -0,0 +1,30 @@
+#include "trace_context.h"
+#include <map>
+#include <mutex>
+
+namespace
+{
+    std::mutex sequence_mutex;
+    //the number of the next message of every source.
+    std::map<std::string, uint32_t> sequences;
+} // namespace
+
+mine_detection::TraceContext Trace_context::begin(const std::string &source, const ros::Time &stamp)
+{
+    mine_detection::TraceContext trace;
+    trace.source = source;
+    trace.origin = stamp;
+    std::lock_guard<std::mutex> lock(sequence_mutex);
+    trace.seq = sequences[source]++;
+    return trace;
+}
+
+void Trace_context::hop(int stage_id, const mine_detection::TraceContext &trace)
+{
+    if (trace.source.empty())
+    {
+        return;
+    }
+    //the source is a stage name too, so the trace file names it.
+    Latency_trace::hop(stage_id, Latency_trace::stage(trace.source), trace.seq, trace.origin.toNSec(), ros::Time::now().toNSec());
+}
@@ -0,0 +1,215 @@
+#include <stdint.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+//rebuilds the latency from the sensors through the nodes out of the trace files of the nodes (~trace_file).
+//the hops of every chain of messages are joined by their source, sequence number and origin stamp, and the latency
+//of every hop is given from the origin and from the hop before it, per source.
+//usage: rosrun mine_detection trace_report laser.trace path_basis.trace paper_detection.trace
+
+namespace
+{
+    //record types and layouts of the trace files, as Latency_trace writes them.
+    const uint8_t record_stage = 0;
+    const uint8_t record_span = 1;
+    const uint8_t record_hop = 2;
+    const size_t span_bytes = 24;
+
+    struct Hop
+    {
+        uint32_t stage;
+        uint32_t source;
+        uint32_t seq;
+        uint32_t reserved;
+        uint64_t origin;
+        uint64_t at;
+    };
+
+    //a chain of messages from one sensor message.
+    struct Chain_key
+    {
+        std::string source;
+        uint32_t seq;
+        uint64_t origin;
+
+        bool operator<(const Chain_key &other) const
+        {
+            if (source != other.source)
+            {
+                return source < other.source;
+            }
+            return seq != other.seq ? seq < other.seq : origin < other.origin;
+        }
+    };
+
+    //the hops of a chain by name, with the time each was reached first.
+    typedef std::map<std::string, uint64_t> Chain;
+
+    //read the hops of a trace file into the chains. false if it is not a trace file.
+    bool readTrace(const char *path, std::map<Chain_key, Chain> &chains)
+    {
+        FILE *file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            return false;
+        }
+        char magic[8];
+        if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, "MDTRACE1", sizeof(magic)) != 0)
+        {
+            fclose(file);
+            return false;
+        }
+
+        //the stage names of this file, the ids of every node are its own.
+        std::vector<std::string> names;
+        uint8_t type;
+        while (fread(&type, 1, 1, file) == 1)
+        {
+            if (type == record_stage)
+            {
+                uint32_t id;
+                uint32_t length;
+                if (fread(&id, sizeof(id), 1, file) != 1 || fread(&length, sizeof(length), 1, file) != 1)
+                {
+                    break;
+                }
+                std::string name(length, '\0');
+                if (length > 0 && fread(&name[0], 1, length, file) != length)
+                {
+                    break;
+                }
+                if (id >= names.size())
+                {
+                    names.resize(id + 1);
+                }
+                names[id] = name;
+            }
+            else if (type == record_span)
+            {
+                if (fseek(file, span_bytes, SEEK_CUR) != 0)
+                {
+                    break;
+                }
+            }
+            else if (type == record_hop)
+            {
+                Hop hop;
+                if (fread(&hop, sizeof(hop), 1, file) != 1)
+                {
+                    break;
+                }
+                if (hop.stage >= names.size() || hop.source >= names.size())
+                {
+                    continue;
+                }
+                Chain_key key = {names[hop.source], hop.seq, hop.origin};
+                Chain &chain = chains[key];
+                Chain::iterator reached = chain.find(names[hop.stage]);
+                //a message handled again, e.g. an obstacle published with every loop, reached the hop the first time.
+                if (reached == chain.end() || hop.at < reached->second)
+                {
+                    chain[names[hop.stage]] = hop.at;
+                }
+            }
+            else
+            {
+                //a file cut short while it was written.
+                break;
+            }
+        }
+        fclose(file);
+        return true;
+    }
+
+    //print the count and the percentiles of latencies in milliseconds.
+    void printLatencies(const std::string &name, std::vector<double> &latencies)
+    {
+        std::sort(latencies.begin(), latencies.end());
+        double fractions[] = {0.50, 0.90, 0.99};
+        double percentiles[3];
+        for (int p = 0; p < 3; p++)
+        {
+            percentiles[p] = latencies[size_t(fractions[p] * (latencies.size() - 1))];
+        }
+        printf("  %-44s %8zu %9.2f %9.2f %9.2f %9.2f\n", name.c_str(), latencies.size(), percentiles[0], percentiles[1],
+               percentiles[2], latencies.back());
+    }
+
+    //print the latencies of a table of hops, ordered by their median.
+    void printTable(const char *title, std::map<std::string, std::vector<double>> &hops)
+    {
+        std::vector<std::pair<double, std::string>> order;
+        for (std::map<std::string, std::vector<double>>::iterator h = hops.begin(); h != hops.end(); ++h)
+        {
+            std::vector<double> sorted = h->second;
+            std::sort(sorted.begin(), sorted.end());
+            order.push_back(std::make_pair(sorted[sorted.size() / 2], h->first));
+        }
+        std::sort(order.begin(), order.end());
+        printf("  %-44s %8s %9s %9s %9s %9s\n", title, "count", "p50 ms", "p90 ms", "p99 ms", "max ms");
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            printLatencies(order[i].second, hops[order[i].second]);
+        }
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: trace_report trace_file...\n");
+        return 1;
+    }
+
+    std::map<Chain_key, Chain> chains;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!readTrace(argv[i], chains))
+        {
+            fprintf(stderr, "Could not read the trace %s.\n", argv[i]);
+            return 1;
+        }
+    }
+
+    //the latencies of every source, from the origin to each hop and between the hops that follow each other.
+    std::map<std::string, std::map<std::string, std::vector<double>>> fromOrigin;
+    std::map<std::string, std::map<std::string, std::vector<double>>> betweenHops;
+    std::map<std::string, size_t> chainCount;
+    for (std::map<Chain_key, Chain>::iterator c = chains.begin(); c != chains.end(); ++c)
+    {
+        const std::string &source = c->first.source;
+        chainCount[source]++;
+
+        //the hops in the order they were reached. the clocks of the nodes may differ a little, so a hop can be
+        //stamped before the origin.
+        std::vector<std::pair<uint64_t, std::string>> reached;
+        for (Chain::iterator h = c->second.begin(); h != c->second.end(); ++h)
+        {
+            reached.push_back(std::make_pair(h->second, h->first));
+            fromOrigin[source][h->first].push_back((double(h->second) - double(c->first.origin)) * 1e-6);
+        }
+        std::sort(reached.begin(), reached.end());
+        for (size_t i = 1; i < reached.size(); i++)
+        {
+            std::string name = reached[i - 1].second + " -> " + reached[i].second;
+            betweenHops[source][name].push_back((double(reached[i].first) - double(reached[i - 1].first)) * 1e-6);
+        }
+    }
+
+    for (std::map<std::string, size_t>::iterator s = chainCount.begin(); s != chainCount.end(); ++s)
+    {
+        printf("%s: %zu chains\n", s->first.c_str(), s->second);
+        printTable("from the origin", fromOrigin[s->first]);
+        if (!betweenHops[s->first].empty())
+        {
+            printTable("between hops", betweenHops[s->first]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
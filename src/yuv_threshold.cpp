@@ -0,0 +1,144 @@
+#include "yuv_threshold.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Yuv_threshold;
+
+namespace
+{
+    //the fixed point BT.601 limited range coefficients OpenCV converts YUV to BGR with.
+    const int bt601_shift = 20;
+    const int bt601_cy = 1220542;
+    const int bt601_cub = 2116026;
+    const int bt601_cug = -409993;
+    const int bt601_cvg = -852492;
+    const int bt601_cvr = 1673527;
+
+    //the fixed point divisions OpenCV converts 8 bit BGR to HSV with.
+    const int hsv_shift = 12;
+
+    uint8_t saturate(int value)
+    {
+        return uint8_t(std::max(0, std::min(255, value)));
+    }
+
+    //the HSV box as OpenCV COLOR_BGR2HSV computes the HSV of a colour.
+    class hsv_Test
+    {
+    public:
+        hsv_Test(int lowH, int highH, int lowS, int highS, int lowV, int highV)
+            : lowH(lowH), highH(highH), lowS(lowS), highS(highS), lowV(lowV), highV(highV)
+        {
+            sdiv[0] = hdiv[0] = 0;
+            for (int i = 1; i < 256; i++)
+            {
+                sdiv[i] = int(std::lround((255 << hsv_shift) / (1.0 * i)));
+                hdiv[i] = int(std::lround((180 << hsv_shift) / (6.0 * i)));
+            }
+        }
+
+        bool contains(int b, int g, int r) const
+        {
+            int v = std::max(b, std::max(g, r));
+            if (v < lowV || v > highV)
+            {
+                return false;
+            }
+            int diff = v - std::min(b, std::min(g, r));
+            int s = (diff * sdiv[v] + (1 << (hsv_shift - 1))) >> hsv_shift;
+            if (s < lowS || s > highS)
+            {
+                return false;
+            }
+            int h = v == r ? g - b : v == g ? b - r + 2 * diff : r - g + 4 * diff;
+            h = (h * hdiv[diff] + (1 << (hsv_shift - 1))) >> hsv_shift;
+            if (h < 0)
+            {
+                h += 180;
+            }
+            //a hue box wrapping around red.
+            return lowH <= highH ? h >= lowH && h <= highH : h >= lowH || h <= highH;
+        }
+
+    private:
+        int lowH, highH, lowS, highS, lowV, highV;
+        int sdiv[256];
+        int hdiv[256];
+    };
+} // namespace
+
+Yuv_range Yuv_threshold::rangeOfHsv(int lowH, int highH, int lowS, int highS, int lowV, int highV)
+{
+    Yuv_range range;
+    //an empty HSV box gives an empty YUV range.
+    if (lowS > highS || lowV > highV)
+    {
+        return range;
+    }
+
+    hsv_Test test(lowH, highH, lowS, highS, lowV, highV);
+    range.bits.assign(size_t(1) << 18, 0);
+    for (int u = 0; u < 256; u++)
+    {
+        for (int v = 0; v < 256; v++)
+        {
+            //the chroma terms of the conversion, rounded like OpenCV.
+            int ruv = (1 << (bt601_shift - 1)) + bt601_cvr * (v - 128);
+            int guv = (1 << (bt601_shift - 1)) + bt601_cvg * (v - 128) + bt601_cug * (u - 128);
+            int buv = (1 << (bt601_shift - 1)) + bt601_cub * (u - 128);
+            uint64_t *row = &range.bits[(size_t(u) << 10) | (size_t(v) << 2)];
+            for (int y = 0; y < 256; y++)
+            {
+                int luma = std::max(0, y - 16) * bt601_cy;
+                if (test.contains(saturate((luma + buv) >> bt601_shift), saturate((luma + guv) >> bt601_shift),
+                                  saturate((luma + ruv) >> bt601_shift)))
+                {
+                    row[y >> 6] |= uint64_t(1) << (y & 63);
+                }
+            }
+        }
+    }
+    return range;
+}
+
+void Yuv_threshold::threshold(const Yuv_frame &frame, int rowBegin, int rowEnd, const Yuv_range &range, uint8_t *mask, size_t maskStep)
+{
+    if (range.bits.empty())
+    {
+        for (int y = rowBegin; y < rowEnd; y++, mask += maskStep)
+        {
+            memset(mask, 0, frame.width);
+        }
+        return;
+    }
+
+    //both formats share U and V between two neighbouring pixels, the widths of the frames are even. the two pixels
+    //of a pair look up the same 256 bits of their chroma.
+    const uint64_t *bits = range.bits.data();
+    int pairs = frame.width / 2;
+    for (int y = rowBegin; y < rowEnd; y++, mask += maskStep)
+    {
+        if (frame.format == FORMAT_YUYV)
+        {
+            const uint8_t *p = frame.data + y * frame.step;
+            for (int x = 0; x < pairs; x++, p += 4)
+            {
+                const uint64_t *row = bits + ((size_t(p[1]) << 10) | (size_t(p[3]) << 2));
+                mask[2 * x] = -uint8_t((row[p[0] >> 6] >> (p[0] & 63)) & 1);
+                mask[2 * x + 1] = -uint8_t((row[p[2] >> 6] >> (p[2] & 63)) & 1);
+            }
+        }
+        else
+        {
+            const uint8_t *luma = frame.data + y * frame.step;
+            const uint8_t *chroma = frame.uv + (y / 2) * frame.uvStep;
+            for (int x = 0; x < pairs; x++)
+            {
+                const uint64_t *row = bits + ((size_t(chroma[2 * x]) << 10) | (size_t(chroma[2 * x + 1]) << 2));
+                mask[2 * x] = -uint8_t((row[luma[2 * x] >> 6] >> (luma[2 * x] & 63)) & 1);
+                mask[2 * x + 1] = -uint8_t((row[luma[2 * x + 1] >> 6] >> (luma[2 * x + 1] & 63)) & 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <colour_lut.h>
+
+using namespace Colour_lut;
+
+namespace
+{
+    //the paper range and boxes spread over the hues, like the benchmarks.
+    std::vector<Colour_class> hsvClasses(int count)
+    {
+        std::vector<Colour_class> classes;
+        Colour_class paper = {"paper", true, {0, 170, 150}, {179, 255, 255}};
+        classes.push_back(paper);
+        for (int i = 1; i < count; i++)
+        {
+            Colour_class colourClass = {"", true, {10 + 20 * i, 100, 100}, {25 + 20 * i, 255, 255}};
+            classes.push_back(colourClass);
+        }
+        return classes;
+    }
+} // namespace
+
+TEST(Colour_lut, hueBoxWrapsAroundRed)
+{
+    Colour_class red = {"red", true, {170, 100, 100}, {10, 255, 255}};
+    EXPECT_TRUE(red.contains(20, 20, 230));
+    EXPECT_TRUE(red.contains(60, 20, 230));
+    EXPECT_FALSE(red.contains(20, 230, 20));
+    EXPECT_FALSE(red.contains(100, 100, 110));
+    Colour_class blue = {"blue", false, {120, 0, 0}, {255, 80, 80}};
+    EXPECT_TRUE(blue.contains(200, 40, 40));
+    EXPECT_FALSE(blue.contains(100, 40, 40));
+}
+
+TEST(Colour_lut, tableAgreesWithTheClasses)
+{
+    std::vector<Colour_class> classes = hsvClasses(8);
+    colour_Table table;
+    ASSERT_TRUE(table.compile(classes));
+    EXPECT_EQ(8u, table.classes().size());
+
+    //the misses are in cells straddling a box edge.
+    std::mt19937 random(5);
+    const int samples = 1000000;
+    int agree = 0;
+    for (int i = 0; i < samples; i++)
+    {
+        int b = random() % 256;
+        int g = random() % 256;
+        int r = random() % 256;
+        uint8_t exact = 0;
+        for (size_t k = 0; k < classes.size(); k++)
+        {
+            exact |= classes[k].contains(b, g, r) << k;
+        }
+        agree += table.lookup(b, g, r) == exact;
+    }
+    EXPECT_GT(double(agree) / samples, 0.96);
+}
+
+TEST(Colour_lut, atMostEightClasses)
+{
+    colour_Table table;
+    std::vector<Colour_class> classes = hsvClasses(8);
+    classes.push_back(classes.back());
+    EXPECT_FALSE(table.compile(classes));
+}
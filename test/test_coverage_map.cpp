@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <coverage_map.h>
+
+using namespace Coverage_map;
+
+TEST(Coverage_map, markedDiskIsCovered)
+{
+    coverage_Map map(0, 0, 2, 2, 0.02);
+    EXPECT_EQ(0.0, map.coverage());
+    map.markDisk(1.0, 1.0, 0.2);
+    EXPECT_EQ(1.0, map.diskCoverage(1.0, 1.0, 0.2));
+    EXPECT_EQ(0.0, map.diskCoverage(0.5, 0.5, 0.2));
+    EXPECT_NEAR(3.14159 * 0.04 / 4, map.coverage(), 0.002);
+    //outside the grid nothing is marked and nothing is left to cover.
+    map.markDisk(5.0, 5.0, 0.2);
+    EXPECT_EQ(1.0, map.diskCoverage(5.0, 5.0, 0.2));
+}
+
+TEST(Coverage_map, sweptRectangleIsCovered)
+{
+    coverage_Map map(0, 0, 2, 2, 0.02);
+    map.markSwept(0.5, 0.5, 1.5, 0.5, 0.1);
+    EXPECT_EQ(1.0, map.diskCoverage(1.0, 0.5, 0.1));
+    EXPECT_EQ(0.0, map.diskCoverage(1.0, 0.8, 0.1));
+}
+
+TEST(Coverage_map, changedRowsAreTakenOnce)
+{
+    coverage_Map map(0, 0, 2, 2, 0.02);
+    int begin;
+    int end;
+    map.takeChanged(begin, end);
+    EXPECT_EQ(begin, end);
+
+    map.markDisk(1.0, 1.0, 0.1);
+    map.takeChanged(begin, end);
+    EXPECT_EQ(45, begin);
+    EXPECT_EQ(55, end);
+    map.takeChanged(begin, end);
+    EXPECT_EQ(begin, end);
+}
+
+TEST(Coverage_map, mergeMarksTheRowsItGains)
+{
+    coverage_Map own(0, 0, 2, 2, 0.02);
+    coverage_Map other(0, 0, 2, 2, 0.02);
+    other.markDisk(1.0, 1.5, 0.1);
+    const Bit_mask::bit_Mask &cells = other.covered();
+
+    int begin;
+    int end;
+    ASSERT_TRUE(own.merge(cells.rows, cells.cols, cells.words));
+    own.takeChanged(begin, end);
+    EXPECT_EQ(70, begin);
+    EXPECT_EQ(80, end);
+    EXPECT_EQ(other.coverage(), own.coverage());
+
+    //merging the same cells again gains nothing.
+    ASSERT_TRUE(own.merge(cells.rows, cells.cols, cells.words));
+    own.takeChanged(begin, end);
+    EXPECT_EQ(begin, end);
+
+    coverage_Map larger(0, 0, 3, 2, 0.02);
+    EXPECT_FALSE(own.merge(larger.covered().rows, larger.covered().cols, larger.covered().words));
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <field_partition.h>
+
+using namespace Field_partition;
+
+namespace
+{
+    const double spacing = 0.4;
+    const double width = 3.0;
+    const double margin = 0.2;
+
+    //the cost partitionLanes gives a robot driving the lanes [first, last].
+    double cost(const Start &start, int first, int last)
+    {
+        if (first > last)
+        {
+            return 0;
+        }
+        double x = spacing / 2 + first * spacing;
+        return (last - first + 1) * (width - 2 * margin) + (last - first) * spacing + std::hypot(x - start.x, margin - start.y);
+    }
+
+    //every lane belongs to one robot, and the robots' blocks follow their starts along the field.
+    void expectBlocks(int lanes, const std::vector<Start> &starts, const std::vector<Region> &regions)
+    {
+        ASSERT_EQ(starts.size(), regions.size());
+        std::vector<int> byX(starts.size());
+        for (size_t r = 0; r < byX.size(); r++)
+        {
+            byX[r] = r;
+        }
+        std::stable_sort(byX.begin(), byX.end(), [&](int a, int b) { return starts[a].x < starts[b].x; });
+        int next = 0;
+        for (size_t k = 0; k < byX.size(); k++)
+        {
+            const Region &region = regions[byX[k]];
+            if (region.firstLane > region.lastLane)
+            {
+                continue;
+            }
+            EXPECT_EQ(next, region.firstLane);
+            next = region.lastLane + 1;
+        }
+        EXPECT_EQ(lanes, next);
+    }
+} // namespace
+
+TEST(Field_partition, blocksFollowTheStarts)
+{
+    std::vector<Start> starts = {{3.0, 0.0}, {0.0, 0.0}, {1.5, 0.0}};
+    std::vector<Region> regions = partitionLanes(10, spacing, width, margin, starts);
+    expectBlocks(10, starts, regions);
+    EXPECT_EQ(0, regions[1].firstLane);
+    EXPECT_EQ(9, regions[0].lastLane);
+}
+
+TEST(Field_partition, largestCostIsAsSmallAsPossible)
+{
+    std::vector<Start> starts = {{0.0, 0.0}, {0.2, 0.0}};
+    const int lanes = 9;
+    std::vector<Region> regions = partitionLanes(lanes, spacing, width, margin, starts);
+    expectBlocks(lanes, starts, regions);
+    double largest = std::max(cost(starts[0], regions[0].firstLane, regions[0].lastLane),
+                              cost(starts[1], regions[1].firstLane, regions[1].lastLane));
+    for (int split = 0; split <= lanes; split++)
+    {
+        double other = std::max(cost(starts[0], 0, split - 1), cost(starts[1], split, lanes - 1));
+        EXPECT_LE(largest, other + 1e-9);
+    }
+}
+
+TEST(Field_partition, robotsWithoutLanes)
+{
+    std::vector<Start> starts = {{0.0, 0.0}, {0.5, 0.0}, {1.0, 0.0}};
+    std::vector<Region> regions = partitionLanes(2, spacing, width, margin, starts);
+    expectBlocks(2, starts, regions);
+    int idle = 0;
+    for (size_t r = 0; r < regions.size(); r++)
+    {
+        idle += regions[r].firstLane > regions[r].lastLane;
+    }
+    EXPECT_EQ(1, idle);
+    EXPECT_TRUE(partitionLanes(4, spacing, width, margin, std::vector<Start>()).empty());
+}
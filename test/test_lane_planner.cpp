@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <lane_planner.h>
+
+using namespace Lane_planner;
+
+namespace
+{
+    std::unique_ptr<Lane_plan> planOf(uint64_t version)
+    {
+        std::unique_ptr<Lane_plan> plan(new Lane_plan());
+        plan->version = version;
+        return plan;
+    }
+} // namespace
+
+TEST(Lane_planner, queueIsFirstInFirstOut)
+{
+    plan_Queue queue;
+    std::unique_ptr<Lane_plan> plan;
+    EXPECT_FALSE(queue.pop(plan));
+
+    for (uint64_t v = 0; v < plan_Queue::capacity; v++)
+    {
+        plan = planOf(v);
+        ASSERT_TRUE(queue.push(plan));
+        EXPECT_FALSE(plan);
+    }
+    //a full queue leaves the plan with the caller.
+    plan = planOf(99);
+    EXPECT_FALSE(queue.push(plan));
+    ASSERT_TRUE(plan);
+    EXPECT_EQ(99u, plan->version);
+
+    for (uint64_t v = 0; v < plan_Queue::capacity; v++)
+    {
+        ASSERT_TRUE(queue.pop(plan));
+        EXPECT_EQ(v, plan->version);
+    }
+    EXPECT_FALSE(queue.pop(plan));
+}
+
+TEST(Lane_planner, queuePassesPlansBetweenThreads)
+{
+    plan_Queue queue;
+    const uint64_t count = 10000;
+    std::thread producer([&queue, count] {
+        for (uint64_t v = 0; v < count; v++)
+        {
+            std::unique_ptr<Lane_plan> plan = planOf(v);
+            while (!queue.push(plan))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t next = 0;
+    std::unique_ptr<Lane_plan> plan;
+    while (next < count)
+    {
+        if (!queue.pop(plan))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        EXPECT_EQ(next, plan->version);
+        next++;
+    }
+    producer.join();
+    EXPECT_FALSE(queue.pop(plan));
+}
@@ -0,0 +1,10 @@
+//unit tests of the mine_detection libraries.
+//Run with: catkin_make run_tests_mine_detection
+
+#include <gtest/gtest.h>
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <mission_log.h>
+
+using namespace Mission_log;
+
+namespace
+{
+    std::string tempPath(const std::string &name)
+    {
+        return "/tmp/mine_detection_test_" + std::to_string(getpid()) + "_" + name;
+    }
+
+    //odometry going back and forth and jumping far, so the deltas are negative, small and many bytes long.
+    const double odomX[] = {0.0, 0.001, -0.002, 1000.0, 999.9995, -1000.0, 0.5};
+    const double odomTheta[] = {0.0, 3.1415, -3.1415, 0.0001, -0.0001, 1.5, -1.5};
+    const int odomCount = sizeof(odomX) / sizeof(odomX[0]);
+
+    //write the odometry, a scan and a frame, spread over more than a chunk of time.
+    void writeLog(const std::string &path)
+    {
+        log_Writer writer;
+        ASSERT_TRUE(writer.open(path));
+        for (int i = 0; i < odomCount; i++)
+        {
+            writer.odom(100.0 + 0.4 * i, odomX[i], -odomX[i], odomTheta[i]);
+        }
+        std::vector<float> ranges = {1.2345f, 0.0f, NAN, 70.0f, 0.0004f};
+        writer.scan(103.0, -1.5f, 0.01f, 0.1f, 10.0f, ranges);
+        std::vector<uint8_t> pixels(4 * 2 * 2);
+        for (size_t i = 0; i < pixels.size(); i++)
+        {
+            pixels[i] = uint8_t(i * 37);
+        }
+        writer.frame(103.5, "front", FRAME_YUYV, 4, 2, pixels.data(), pixels.size());
+        writer.close();
+    }
+
+    //check the records of writeLog.
+    void expectRecords(log_Reader &reader)
+    {
+        Record record;
+        for (int i = 0; i < odomCount; i++)
+        {
+            ASSERT_TRUE(reader.next(record));
+            ASSERT_EQ(RECORD_ODOM, record.type);
+            EXPECT_NEAR(100.0 + 0.4 * i, record.stamp, 1e-6);
+            EXPECT_NEAR(odomX[i], record.odom.x, 0.5e-3);
+            EXPECT_NEAR(-odomX[i], record.odom.y, 0.5e-3);
+            EXPECT_NEAR(odomTheta[i], record.odom.theta, 0.5e-4);
+        }
+
+        ASSERT_TRUE(reader.next(record));
+        ASSERT_EQ(RECORD_SCAN, record.type);
+        EXPECT_EQ(-1.5f, record.scan.angleMin);
+        ASSERT_EQ(5, record.scan.count);
+        EXPECT_NEAR(1.2345f, record.scan.range(0), 1e-3);
+        EXPECT_TRUE(std::isnan(record.scan.range(1)));
+        EXPECT_TRUE(std::isnan(record.scan.range(2)));
+        EXPECT_TRUE(std::isinf(record.scan.range(3)));
+        EXPECT_EQ(0.001f, record.scan.range(4));
+
+        ASSERT_TRUE(reader.next(record));
+        ASSERT_EQ(RECORD_FRAME, record.type);
+        EXPECT_EQ("front", record.frame.camera);
+        EXPECT_EQ(FRAME_YUYV, record.frame.format);
+        EXPECT_EQ(4, record.frame.width);
+        EXPECT_EQ(2, record.frame.height);
+        ASSERT_EQ(16u, record.frame.bytes);
+        for (size_t i = 0; i < record.frame.bytes; i++)
+        {
+            EXPECT_EQ(uint8_t(i * 37), record.frame.data[i]);
+        }
+
+        EXPECT_FALSE(reader.next(record));
+    }
+} // namespace
+
+TEST(Mission_log, recordsReadBackAsWritten)
+{
+    std::string path = tempPath("records.mdlog");
+    writeLog(path);
+    log_Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_NEAR(100.0, reader.begin(), 1e-9);
+    EXPECT_NEAR(103.5, reader.end(), 1e-9);
+    expectRecords(reader);
+    std::remove(path.c_str());
+}
+
+TEST(Mission_log, seekStartsAtTheFirstRecordAtTheStamp)
+{
+    std::string path = tempPath("seek.mdlog");
+    writeLog(path);
+    log_Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    reader.seek(101.1);
+    Record record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(RECORD_ODOM, record.type);
+    EXPECT_NEAR(101.2, record.stamp, 1e-6);
+    EXPECT_NEAR(1000.0, record.odom.x, 0.5e-3);
+    std::remove(path.c_str());
+}
+
+TEST(Mission_log, logWithoutIndexIsReadByItsChunks)
+{
+    std::string path = tempPath("cut.mdlog");
+    writeLog(path);
+    //a log whose writer crashed has no footer.
+    FILE *file = std::fopen(path.c_str(), "rb+");
+    ASSERT_TRUE(file != NULL);
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    ASSERT_EQ(0, truncate(path.c_str(), size - 1));
+
+    log_Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    expectRecords(reader);
+    std::remove(path.c_str());
+}
+
+TEST(Mission_log, startPathKeepsTheExtension)
+{
+    //-YYYYmmdd-HHMMSS-pid before the extension.
+    std::string path = startPath("logs/laser.mdlog");
+    std::string suffix = "-" + std::to_string(getpid()) + ".mdlog";
+    ASSERT_EQ(std::string("logs/laser").size() + 16 + suffix.size(), path.size());
+    EXPECT_EQ(0u, path.find("logs/laser-"));
+    EXPECT_EQ('-', path[19]);
+    EXPECT_EQ(path.size() - suffix.size(), path.rfind(suffix));
+    EXPECT_EQ(0u, startPath("laser").find("laser-"));
+    EXPECT_EQ(std::string::npos, startPath("laser").find('.'));
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <mission_state.h>
+
+using namespace Mission_state;
+using Points_gen::Point;
+
+namespace
+{
+    std::string tempPath(const std::string &name)
+    {
+        return "/tmp/mine_detection_test_" + std::to_string(getpid()) + "_" + name;
+    }
+
+    //change a byte of the first copy of value in the file, like a write cut short by a crash. false if it isn't there.
+    bool tearValue(const std::string &path, double value)
+    {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        const char *pattern = reinterpret_cast<const char *>(&value);
+        std::vector<char>::iterator at = std::search(bytes.begin(), bytes.end(), pattern, pattern + sizeof(value));
+        if (at == bytes.end())
+        {
+            return false;
+        }
+        std::fstream out(path.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        out.seekp(at - bytes.begin());
+        out.put(char(*at ^ 0x5a));
+        return bool(out);
+    }
+
+    Progress progressAt(int span, double x)
+    {
+        Progress progress = {};
+        progress.span = span;
+        progress.offset = 1;
+        progress.pose.x = x;
+        progress.pose.y = 0.5;
+        return progress;
+    }
+
+    //two lanes of a 1 x 2 m field, driven up and down.
+    std::vector<Point> twoLanes()
+    {
+        std::vector<Point> points;
+        for (int i = 0; i <= 10; i++)
+        {
+            Point p = {0.25, 0.2 * i, i == 10, 0};
+            points.push_back(p);
+        }
+        for (int i = 10; i >= 0; i--)
+        {
+            Point p = {0.75, 0.2 * i, i == 0, 1};
+            points.push_back(p);
+        }
+        return points;
+    }
+
+    const Field field = {1.0, 2.0, 0.02, 0, 1};
+} // namespace
+
+TEST(Mission_state, resumesTheSavedMission)
+{
+    std::string path = tempPath("mission.bin");
+    Coverage_map::coverage_Map coverage(0, 0, field.length, field.width, field.resolution);
+    Path_plan::lane_Path lanes(twoLanes());
+    {
+        mission_File mission;
+        ASSERT_TRUE(mission.create(path, field, coverage));
+        coverage.markDisk(0.25, 0.5, 0.2);
+        mission.saveCoverage(coverage);
+        mission.saveProgress(progressAt(1, 0.25));
+        mission.savePath(lanes);
+        mission.sync();
+    }
+
+    mission_File resumed;
+    ASSERT_TRUE(resumed.open(path, field));
+    Progress progress;
+    ASSERT_TRUE(resumed.loadProgress(progress));
+    EXPECT_EQ(1, progress.span);
+    EXPECT_EQ(0.25, progress.pose.x);
+    Path_plan::lane_Path loaded;
+    ASSERT_TRUE(resumed.loadPath(loaded));
+    std::vector<Point> expected = lanes.flatten();
+    std::vector<Point> actual = loaded.flatten();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].x, actual[i].x);
+        EXPECT_EQ(expected[i].y, actual[i].y);
+        EXPECT_EQ(expected[i].stop, actual[i].stop);
+    }
+    Coverage_map::coverage_Map loadedCoverage(0, 0, field.length, field.width, field.resolution);
+    resumed.loadCoverage(loadedCoverage);
+    EXPECT_EQ(coverage.coverage(), loadedCoverage.coverage());
+    std::remove(path.c_str());
+}
+
+TEST(Mission_state, tornProgressSlotFallsBackToTheOtherOne)
+{
+    std::string path = tempPath("torn_progress.bin");
+    Coverage_map::coverage_Map coverage(0, 0, field.length, field.width, field.resolution);
+    {
+        mission_File mission;
+        ASSERT_TRUE(mission.create(path, field, coverage));
+        mission.saveProgress(progressAt(2, 12.375));
+        mission.saveProgress(progressAt(3, 23.625));
+        mission.sync();
+    }
+    ASSERT_TRUE(tearValue(path, 23.625));
+
+    mission_File resumed;
+    ASSERT_TRUE(resumed.open(path, field));
+    Progress progress;
+    ASSERT_TRUE(resumed.loadProgress(progress));
+    EXPECT_EQ(2, progress.span);
+    EXPECT_EQ(12.375, progress.pose.x);
+
+    //the next save goes to the torn slot, not over the good one.
+    resumed.saveProgress(progressAt(4, 34.125));
+    ASSERT_TRUE(resumed.loadProgress(progress));
+    EXPECT_EQ(4, progress.span);
+    ASSERT_TRUE(tearValue(path, 34.125));
+    ASSERT_TRUE(resumed.loadProgress(progress));
+    EXPECT_EQ(2, progress.span);
+
+    ASSERT_TRUE(tearValue(path, 12.375));
+    EXPECT_FALSE(resumed.loadProgress(progress));
+    std::remove(path.c_str());
+}
+
+TEST(Mission_state, tornPathIsNotLoaded)
+{
+    std::string path = tempPath("torn_path.bin");
+    Coverage_map::coverage_Map coverage(0, 0, field.length, field.width, field.resolution);
+    mission_File mission;
+    ASSERT_TRUE(mission.create(path, field, coverage));
+    Path_plan::lane_Path loaded;
+    EXPECT_FALSE(mission.loadPath(loaded));
+
+    std::vector<Point> points = twoLanes();
+    points[3].x = 0.3125;
+    mission.savePath(Path_plan::lane_Path(points));
+    mission.sync();
+    ASSERT_TRUE(mission.loadPath(loaded));
+    ASSERT_TRUE(tearValue(path, 0.3125));
+    EXPECT_FALSE(mission.loadPath(loaded));
+    std::remove(path.c_str());
+}
+
+TEST(Mission_state, otherOrFinishedMissionIsNotResumed)
+{
+    std::string path = tempPath("finished.bin");
+    Coverage_map::coverage_Map coverage(0, 0, field.length, field.width, field.resolution);
+    {
+        mission_File mission;
+        ASSERT_TRUE(mission.create(path, field, coverage));
+    }
+    Field other = field;
+    other.width = 3.0;
+    mission_File resumed;
+    EXPECT_FALSE(resumed.open(path, other));
+    ASSERT_TRUE(resumed.open(path, field));
+    resumed.finish();
+    mission_File again;
+    EXPECT_FALSE(again.open(path, field));
+    std::remove(path.c_str());
+}
+
+TEST(Mission_state, tornMineIsDropped)
+{
+    std::string path = tempPath("mines.bin");
+    {
+        mine_File mines;
+        ASSERT_TRUE(mines.open(path, false));
+        for (int id = 0; id < 3; id++)
+        {
+            Detection_map::Detection detection = {id, 1.125 + id, 2.0, 1};
+            mines.saveMine(detection);
+        }
+        Pose pose = {0.5, 0.25, 0.0};
+        mines.savePose(pose);
+    }
+    ASSERT_TRUE(tearValue(path, 2.125));
+
+    mine_File resumed;
+    ASSERT_TRUE(resumed.open(path, true));
+    std::vector<Detection_map::Detection> loaded = resumed.loadMines();
+    ASSERT_EQ(2u, loaded.size());
+    EXPECT_EQ(1.125, loaded[0].x);
+    EXPECT_EQ(3.125, loaded[1].x);
+    EXPECT_EQ(1, loaded[1].id);
+    Pose pose;
+    ASSERT_TRUE(resumed.loadPose(pose));
+    EXPECT_EQ(0.25, pose.y);
+
+    //without resume the old mines are dropped.
+    mine_File fresh;
+    ASSERT_TRUE(fresh.open(path, false));
+    EXPECT_TRUE(fresh.loadMines().empty());
+    std::remove(path.c_str());
+}
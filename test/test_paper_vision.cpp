@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <paper_vision.h>
+#include <thread_pool.h>
+#include <yuv_threshold.h>
+
+namespace
+{
+    //grey ground with red paper sheets and some red noise pixels, like the frames of the benchmarks.
+    cv::Mat syntheticFrame(int width, int height)
+    {
+        cv::Mat frame(height, width, CV_8UC3, cv::Scalar(90, 100, 110));
+        cv::RNG rng(42);
+        for (int i = 0; i < 6; i++)
+        {
+            cv::Point tl(rng.uniform(0, width - 80), rng.uniform(0, height - 60));
+            cv::rectangle(frame, tl, tl + cv::Point(rng.uniform(30, 80), rng.uniform(20, 60)), cv::Scalar(20, 20, 230), -1);
+        }
+        for (int i = 0; i < width * height / 500; i++)
+        {
+            frame.at<cv::Vec3b>(rng.uniform(0, height), rng.uniform(0, width)) = cv::Vec3b(10, 10, 240);
+        }
+        return frame;
+    }
+
+    //the synthetic frame as the YUYV a V4L2 webcam gives.
+    std::vector<uint8_t> syntheticYuyv(int width, int height)
+    {
+        cv::Mat yuv;
+        cv::cvtColor(syntheticFrame(width, height), yuv, cv::COLOR_BGR2YUV);
+        std::vector<uint8_t> yuyv(width * height * 2);
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x += 2)
+            {
+                const cv::Vec3b &a = yuv.at<cv::Vec3b>(y, x);
+                const cv::Vec3b &b = yuv.at<cv::Vec3b>(y, x + 1);
+                uint8_t *p = &yuyv[(y * width + x) * 2];
+                p[0] = a[0];
+                p[1] = (a[1] + b[1]) / 2;
+                p[2] = b[0];
+                p[3] = (a[2] + b[2]) / 2;
+            }
+        }
+        return yuyv;
+    }
+
+    //a random byte mask, about two thirds set.
+    cv::Mat randomMask(cv::RNG &rng, int width, int height)
+    {
+        cv::Mat mask(height, width, CV_8UC1);
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                mask.at<uchar>(y, x) = rng.uniform(0, 3) ? 255 : 0;
+            }
+        }
+        return mask;
+    }
+
+    //filterMaskBytes with the ellipse of the radius.
+    void filterBytes(cv::Mat &mask, int radius)
+    {
+        cv::Mat element = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * radius + 1, 2 * radius + 1));
+        cv::erode(mask, mask, element);
+        cv::dilate(mask, mask, element);
+        cv::dilate(mask, mask, element);
+        cv::erode(mask, mask, element);
+    }
+
+    int differentPixels(const cv::Mat &a, const cv::Mat &b)
+    {
+        cv::Mat diff;
+        cv::absdiff(a, b, diff);
+        return cv::countNonZero(diff);
+    }
+
+    //the YUV threshold of the frame against converting it to BGR and thresholding it in HSV.
+    int differentFromConverted(const Yuv_threshold::Yuv_frame &frame, const Paper_vision::Hsv_range &hsv)
+    {
+        Yuv_threshold::Yuv_range range = Yuv_threshold::rangeOfHsv(hsv.lowH, hsv.highH, hsv.lowS, hsv.highS, hsv.lowV, hsv.highV);
+        cv::Mat bgr;
+        cv::Mat expected;
+        cv::Mat mask;
+        Paper_vision::yuvToBgr(frame, bgr);
+        Paper_vision::thresholdFrame(bgr, hsv, expected);
+        Paper_vision::thresholdYuv(frame, range, mask);
+        return differentPixels(mask, expected);
+    }
+
+    const Paper_vision::Hsv_range paperRange = {0, 179, 170, 255, 150, 255};
+    //a hue range wrapping around red.
+    const Paper_vision::Hsv_range redRange = {170, 10, 100, 255, 80, 255};
+} // namespace
+
+TEST(Paper_vision, packedMorphologyIsOpenCvMorphology)
+{
+    cv::RNG rng(3);
+    for (int radius = 1; radius <= 2; radius++)
+    {
+        for (int width = 1; width <= 640; width++)
+        {
+            cv::Mat expected = randomMask(rng, width, 12);
+            cv::Mat mask = expected.clone();
+            Paper_vision::filterMask(mask, radius);
+            filterBytes(expected, radius);
+            ASSERT_EQ(0, differentPixels(mask, expected)) << "radius " << radius << ", width " << width;
+        }
+    }
+}
+
+TEST(Paper_vision, yuvThresholdIsTheConvertedThreshold)
+{
+    const int width = 640;
+    const int height = 480;
+    std::vector<uint8_t> yuyv = syntheticYuyv(width, height);
+    Yuv_threshold::Yuv_frame frame = {Yuv_threshold::FORMAT_YUYV, width, height, yuyv.data(), size_t(width * 2), NULL, 0};
+
+    std::vector<uint8_t> noise(width * height * 2);
+    cv::RNG rng(7);
+    for (size_t i = 0; i < noise.size(); i++)
+    {
+        noise[i] = rng.uniform(0, 256);
+    }
+    Yuv_threshold::Yuv_frame noiseYuyv = {Yuv_threshold::FORMAT_YUYV, width, height, noise.data(), size_t(width * 2), NULL, 0};
+    Yuv_threshold::Yuv_frame noiseNv12 = {Yuv_threshold::FORMAT_NV12, width, height, noise.data(), size_t(width),
+                                          noise.data() + width * height, size_t(width)};
+    const Paper_vision::Hsv_range *ranges[] = {&paperRange, &redRange};
+    for (int r = 0; r < 2; r++)
+    {
+        EXPECT_EQ(0, differentFromConverted(frame, *ranges[r]));
+        EXPECT_EQ(0, differentFromConverted(noiseYuyv, *ranges[r]));
+        EXPECT_EQ(0, differentFromConverted(noiseNv12, *ranges[r]));
+    }
+}
+
+TEST(Paper_vision, contourBoxesAreTheBandBoxes)
+{
+    for (int size = 0; size < 2; size++)
+    {
+        cv::Mat frame = size == 0 ? syntheticFrame(640, 480) : syntheticFrame(1280, 720);
+        cv::Mat mask;
+        Paper_vision::thresholdFrame(frame, paperRange, mask);
+        Paper_vision::filterMask(mask);
+        std::vector<std::vector<cv::Point>> contoursPoly;
+        std::vector<cv::Rect> boundbox;
+        Paper_vision::findBoundingBoxes(mask, contoursPoly, boundbox);
+        EXPECT_EQ(boundbox.size(), contoursPoly.size());
+
+        Thread_pool::thread_Pool pool(2);
+        cv::Mat bandMask;
+        std::vector<cv::Rect> bandBoxes;
+        Paper_vision::processBands(frame, paperRange, pool, 4, bandMask, bandBoxes);
+        EXPECT_FALSE(bandBoxes.empty());
+        EXPECT_TRUE(boundbox == bandBoxes);
+    }
+}
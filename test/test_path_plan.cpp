@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <path_plan.h>
+#include <lane_order.h>
+
+using namespace Path_plan;
+using Points_gen::Point;
+
+namespace
+{
+    //lanes along y at x = 0.25 + 0.5 * lane, points every 0.1 m, driven up and down. order gives the lanes in
+    //driving order.
+    std::vector<Point> lanes(const std::vector<int> &order)
+    {
+        std::vector<Point> points;
+        for (size_t k = 0; k < order.size(); k++)
+        {
+            for (int i = 0; i <= 20; i++)
+            {
+                int step = k % 2 == 0 ? i : 20 - i;
+                Point p = {0.25 + 0.5 * order[k], 0.1 * step, i == 20, order[k]};
+                points.push_back(p);
+            }
+        }
+        return points;
+    }
+
+    double distance(const Point &a, double x, double y)
+    {
+        return std::hypot(a.x - x, a.y - y);
+    }
+} // namespace
+
+TEST(Path_plan, detourSplitsTheSpanAroundTheObstacle)
+{
+    lane_Path path(lanes({0, 1}));
+    ASSERT_EQ(2u, path.size());
+    Obstacle_avoidance::Obstacle_Point obstacle = {0.25, 1.0};
+    const double radius = 0.25;
+
+    //points 8 to 12 of the first lane are within the radius.
+    EXPECT_EQ(8, path.detour(0, 0, obstacle, radius));
+    ASSERT_EQ(4u, path.size());
+    EXPECT_EQ(0, path.span(1).lane);
+    EXPECT_EQ(0.25, path.stop(2).x);
+    EXPECT_NEAR(2.0, path.stop(2).y, 1e-9);
+
+    std::vector<Point> flat = path.flatten();
+    ASSERT_EQ(42u, flat.size());
+    for (size_t i = 0; i < flat.size(); i++)
+    {
+        EXPECT_GE(distance(flat[i], obstacle.x, obstacle.y), radius - 1e-9);
+    }
+    //the detour ends at the first point after the obstacle, then the lane goes on.
+    EXPECT_TRUE(flat[7].stop);
+    EXPECT_TRUE(flat[13].stop);
+    EXPECT_NEAR(1.3, flat[13].y, 1e-9);
+
+    //a span far from the obstacle is skipped.
+    EXPECT_EQ(-1, path.detour(3, 0, obstacle, radius));
+}
+
+TEST(Path_plan, detourLanesStopsAfterTheLanes)
+{
+    //an obstacle between the first two lanes.
+    Obstacle_avoidance::Obstacle_Point obstacle = {0.5, 1.0};
+    lane_Path one(lanes({0, 1, 2}));
+    EXPECT_TRUE(one.nearLanes(0, 1, obstacle, 0.3));
+    EXPECT_EQ(1, one.detourLanes(0, 1, obstacle, 0.3));
+    lane_Path all(lanes({0, 1, 2}));
+    EXPECT_EQ(2, all.detourLanes(0, 3, obstacle, 0.3));
+    EXPECT_FALSE(all.nearLanes(all.size() - 1, 1, obstacle, 0.3));
+}
+
+TEST(Path_plan, reorderKeepsAnOrderThatIsAlreadyShortest)
+{
+    lane_Path path(lanes({0, 1, 2, 3}));
+    double transit;
+    EXPECT_FALSE(path.reorderLanes(1, 0.25, 2.0, 0.05, transit));
+    EXPECT_NEAR(1.5, transit, 1e-9);
+    EXPECT_EQ(1, path.span(1).lane);
+}
+
+TEST(Path_plan, reorderShortensTheTransits)
+{
+    //the lanes skip back and forth across the field.
+    lane_Path path(lanes({0, 3, 1, 2}));
+    std::vector<Point> before = path.flatten();
+    double transit;
+    ASSERT_TRUE(path.reorderLanes(1, 0.25, 2.0, 0.05, transit));
+    EXPECT_NEAR(1.5, transit, 1e-9);
+
+    //the lanes follow each other across the field, each ending where the next one starts. a reversed lane stops at
+    //the same points as before, so it may have more than one span.
+    std::vector<int> order;
+    for (size_t s = 0; s < path.size(); s++)
+    {
+        if (path.laneStart(s))
+        {
+            order.push_back(path.span(s).lane);
+        }
+        if (s + 1 == path.size() || path.laneStart(s + 1))
+        {
+            EXPECT_NEAR(path.span(s).lane % 2 == 0 ? 2.0 : 0.0, path.stop(s).y, 1e-9);
+        }
+    }
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), order);
+    EXPECT_EQ(before.size(), path.flatten().size());
+}
+
+TEST(Path_plan, replacingKeepsThePathAndDropsOldPoints)
+{
+    lane_Path path(lanes({0, 1, 2}));
+    std::vector<Point> expected = path.flatten();
+    for (int i = 0; i < 10; i++)
+    {
+        path.replaceFrom(1, path.flatten(1));
+    }
+    std::vector<Point> actual = path.flatten();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].x, actual[i].x);
+        EXPECT_EQ(expected[i].y, actual[i].y);
+        EXPECT_EQ(expected[i].stop, actual[i].stop);
+    }
+
+    //compact gives the points in use, the replaced ones were dropped along the way.
+    std::vector<Point> points;
+    std::vector<Span> spans;
+    path.compact(points, spans);
+    EXPECT_EQ(expected.size(), points.size());
+}
+
+TEST(Lane_order, routeIsNeverLongerThanTheGivenOrder)
+{
+    //boustrophedon lanes with some skipped and some split, planned from anywhere on the field.
+    std::mt19937 random(1);
+    for (int c = 0; c < 2000; c++)
+    {
+        std::vector<Lane_order::Segment> segments;
+        int count = 3 + random() % 10;
+        for (int l = 0; l < count; l++)
+        {
+            if (random() % 5 == 0)
+            {
+                continue;
+            }
+            double x = 0.65 * l;
+            std::vector<Lane_order::Segment> lane;
+            if (random() % 4 == 0)
+            {
+                double middle = 1 + (random() % 300) / 100.0;
+                lane.push_back(Lane_order::Segment{x, 0, x, middle});
+                lane.push_back(Lane_order::Segment{x, middle + 0.6, x, 5});
+            }
+            else
+            {
+                lane.push_back(Lane_order::Segment{x, 0, x, 5});
+            }
+            if (l % 2 == 1)
+            {
+                for (size_t i = 0; i < lane.size(); i++)
+                {
+                    std::swap(lane[i].startY, lane[i].endY);
+                }
+                std::reverse(lane.begin(), lane.end());
+            }
+            segments.insert(segments.end(), lane.begin(), lane.end());
+        }
+        if (segments.empty())
+        {
+            continue;
+        }
+
+        Lane_order::Route given;
+        for (size_t k = 0; k < segments.size(); k++)
+        {
+            given.order.push_back(k);
+            given.reversed.push_back(false);
+        }
+        double x = (random() % 800) / 100.0;
+        double y = (random() % 500) / 100.0;
+        Lane_order::Route route = Lane_order::planRoute(x, y, segments, 0.01);
+        EXPECT_LE(route.transit, Lane_order::transitLength(x, y, segments, given) + 1e-9);
+        EXPECT_NEAR(route.transit, Lane_order::transitLength(x, y, segments, route), 1e-9);
+    }
+}